@@ -0,0 +1,136 @@
+#include <limits.h>
+#include <string.h>
+
+#include <QStringList>
+
+#include "GntDataset.h"
+#include "QxBatchRenderer.h"
+#include "QxGntDataset.h"
+
+struct GntDataset
+{
+	GntDataset() : pRenderer(NULL) {}
+
+	QxGntDataset dataset;
+	QxBatchRenderer* pRenderer;
+};
+
+//Copy a message into a caller provided buffer, truncated if needed.
+static void copyError(const QString& strError, char* pError, size_t uErrorSize)
+{
+	if (!pError || !uErrorSize)
+	{
+		return;
+	}
+	QByteArray message = strError.toUtf8();
+	size_t uLength = qMin(size_t(message.size()), uErrorSize - 1);
+	memcpy(pError, message.constData(), uLength);
+	pError[uLength] = '\0';
+}
+
+static bool isValidSide(int iSide)
+{
+	return iSide >= 1 && iSide <= QxGntDataset::MaxImageSide;
+}
+
+GntDataset* gnt_dataset_open(const char* const* file_names, int file_count, int thread_count, char* error, size_t error_size)
+{
+	if (!file_names || file_count <= 0)
+	{
+		copyError("No file to open.", error, error_size);
+		return NULL;
+	}
+	QStringList fileList;
+	for (int i = 0; i != file_count; ++i)
+	{
+		fileList.append(QString::fromUtf8(file_names[i]));
+	}
+
+	GntDataset* pDataset = new GntDataset;
+	if (!pDataset->dataset.open(fileList))
+	{
+		copyError(pDataset->dataset.errorString(), error, error_size);
+		delete pDataset;
+		return NULL;
+	}
+	pDataset->pRenderer = new QxBatchRenderer(&pDataset->dataset, thread_count);
+	copyError(QString(), error, error_size);
+	return pDataset;
+}
+
+void gnt_dataset_close(GntDataset* dataset)
+{
+	if (dataset)
+	{
+		delete dataset->pRenderer;
+		delete dataset;
+	}
+}
+
+uint64_t gnt_dataset_count(const GntDataset* dataset)
+{
+	return dataset ? dataset->dataset.sampleCount() : 0;
+}
+
+uint32_t gnt_dataset_class_count(const GntDataset* dataset)
+{
+	return dataset ? dataset->dataset.classCount() : 0;
+}
+
+uint32_t gnt_dataset_class_code(const GntDataset* dataset, uint32_t label)
+{
+	if (!dataset || label >= dataset->dataset.classCount())
+	{
+		return 0;
+	}
+	return dataset->dataset.labelCodes().at(label);
+}
+
+int gnt_dataset_get_sample(const GntDataset* dataset, uint64_t index, GntSample* sample)
+{
+	if (!dataset || !sample)
+	{
+		return GNT_ERROR_ARGUMENT;
+	}
+	if (index >= dataset->dataset.sampleCount())
+	{
+		return GNT_ERROR_INDEX;
+	}
+	sample->tag_code = dataset->dataset.tagCode(index);
+	sample->label = dataset->dataset.label(index);
+	sample->bitmap = dataset->dataset.bitmap(index, sample->width, sample->height);
+	return GNT_OK;
+}
+
+int gnt_dataset_render(const GntDataset* dataset, uint64_t index, int side, uint8_t* image)
+{
+	if (!dataset || !image || !isValidSide(side))
+	{
+		return GNT_ERROR_ARGUMENT;
+	}
+	if (index >= dataset->dataset.sampleCount())
+	{
+		return GNT_ERROR_INDEX;
+	}
+	dataset->dataset.render(index, side, image);
+	return GNT_OK;
+}
+
+int gnt_dataset_fill_batch(GntDataset* dataset, const uint64_t* indices, size_t count, int side, uint8_t* images, int32_t* labels)
+{
+	if (!dataset || (count && (!indices || !images)) || !isValidSide(side) || count > size_t(INT_MAX))
+	{
+		return GNT_ERROR_ARGUMENT;
+	}
+	// Check all the indices first, so that a bad one doesn't leave a half written batch.
+	const quint64 uSampleCount = dataset->dataset.sampleCount();
+	for (size_t i = 0; i != count; ++i)
+	{
+		if (indices[i] >= uSampleCount)
+		{
+			return GNT_ERROR_INDEX;
+		}
+	}
+	dataset->pRenderer->render(reinterpret_cast<const quint64*>(indices), int(count), side, images, labels);
+	return GNT_OK;
+}
@@ -0,0 +1,81 @@
+#ifndef _GNT_DATASET_H_
+#define _GNT_DATASET_H_
+
+/*
+	C interface of the gntdataset shared library (GntDataset.pro): random access to the samples of .gnt files
+	and multi-threaded batch loading into caller provided buffers, for data loaders linking the decoder directly
+	(e.g. through ctypes or cffi). The samples are padded to a white square and resized like GntDecoder does,
+	and labelled in the order the tag codes are first met in the files.
+
+	Typical use:
+		GntDataset* pDataset = gnt_dataset_open(files, fileCount, 0, error, sizeof(error));
+		uint64_t count = gnt_dataset_count(pDataset);
+		gnt_dataset_fill_batch(pDataset, indices, batchSize, 64, images, labels);
+		gnt_dataset_close(pDataset);
+
+	The images are rendered by the same code as the decoder's (OpenCV), byte-identical to the images of a decoding
+	with the default settings. All the functions but gnt_dataset_close() can be called
+	from several threads; concurrent gnt_dataset_fill_batch() calls on the same dataset run one after the other.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(GNT_DATASET_LIBRARY)
+#    define GNT_DATASET_API __declspec(dllexport)
+#  else
+#    define GNT_DATASET_API __declspec(dllimport)
+#  endif
+#else
+#  define GNT_DATASET_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Return codes */
+#define GNT_OK 0
+#define GNT_ERROR_ARGUMENT (-1)
+#define GNT_ERROR_INDEX (-2)
+
+/* Largest image side of gnt_dataset_render() and gnt_dataset_fill_batch(). */
+#define GNT_MAX_IMAGE_SIDE 1024
+
+typedef struct GntDataset GntDataset;
+
+/* One sample as stored in the file. The bitmap stays valid until the dataset is closed. */
+typedef struct GntSample
+{
+	uint32_t tag_code;
+	uint32_t label;
+	uint32_t width;
+	uint32_t height;
+	/* height rows of width 8-bit pixels, white (255) background */
+	const uint8_t* bitmap;
+} GntSample;
+
+/* Open .gnt (.gnt.gz, .gnt.zst) files, given as UTF-8 paths. thread_count is the number of threads filling
+   the batches (0 means the number of cores). Return NULL on error, with a message in error (if not NULL). */
+GNT_DATASET_API GntDataset* gnt_dataset_open(const char* const* file_names, int file_count, int thread_count, char* error, size_t error_size);
+GNT_DATASET_API void gnt_dataset_close(GntDataset* dataset);
+
+GNT_DATASET_API uint64_t gnt_dataset_count(const GntDataset* dataset);
+GNT_DATASET_API uint32_t gnt_dataset_class_count(const GntDataset* dataset);
+/* Tag code of a label, or 0 for an invalid label. */
+GNT_DATASET_API uint32_t gnt_dataset_class_code(const GntDataset* dataset, uint32_t label);
+
+/* Get a sample without copying its bitmap. */
+GNT_DATASET_API int gnt_dataset_get_sample(const GntDataset* dataset, uint64_t index, GntSample* sample);
+/* Pad and resize one sample into image (side x side bytes), on the calling thread. */
+GNT_DATASET_API int gnt_dataset_render(const GntDataset* dataset, uint64_t index, int side, uint8_t* image);
+/* Pad and resize the samples indices[0..count) into images (count x side x side bytes, C order) with the
+   dataset's threads, and write their labels into labels (count values, may be NULL). */
+GNT_DATASET_API int gnt_dataset_fill_batch(GntDataset* dataset, const uint64_t* indices, size_t count, int side, uint8_t* images, int32_t* labels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
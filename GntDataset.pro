@@ -0,0 +1,54 @@
+#-------------------------------------------------
+#
+# gntdataset: shared library with the C interface declared in GntDataset.h,
+# for data loaders reading .gnt files in process. The samples go through the
+# decoder's QxSampleProcessor (OpenCV); QtWidgets is only needed for the headers
+# of the decode settings, no widget is created.
+#
+#-------------------------------------------------
+
+QT = core gui widgets
+
+TARGET = gntdataset
+TEMPLATE = lib
+CONFIG += shared
+
+DEFINES += GNT_DATASET_LIBRARY
+
+
+SOURCES += GntDataset.cpp \
+    QxAugmenter.cpp \
+    QxBatchRenderer.cpp \
+    QxDecodeSettings.cpp \
+    QxDecompressDevice.cpp \
+    QxGntDataset.cpp \
+    QxGntReader.cpp \
+    QxSampleProcessor.cpp \
+    QxSampleStore.cpp
+
+HEADERS  += \
+    GntDataset.h \
+    QxAugmenter.h \
+    QxBatchRenderer.h \
+    QxDecodeOptionDlg.h \
+    QxDecodeSettings.h \
+    QxDecompressDevice.h \
+    QxGntDataset.h \
+    QxGntReader.h \
+    QxHash.h \
+    QxSampleProcessor.h \
+    QxSampleStore.h
+
+INCLUDEPATH += /usr/local/include
+DEPENDPATH += /usr/local/include \
+                /usr/local/lib \
+                /usr/lib
+
+
+unix:!macx: LIBS += -lopencv_core
+
+unix:!macx: LIBS += -lopencv_imgproc
+
+unix:!macx: LIBS += -lz
+
+unix:!macx: LIBS += -lzstd
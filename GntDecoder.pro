@@ -6,6 +6,8 @@
 
 QT += core gui
 QT += widgets
+QT += concurrent
+QT += network
 
 TARGET = GntDecoder
 TEMPLATE = app
@@ -13,13 +15,54 @@ TEMPLATE = app
 
 SOURCES += main.cpp \
     QxAboutDialog.cpp \
+    QxAtlasWriter.cpp \
+    QxAugmenter.cpp \
+    QxCommandLine.cpp \
     QxDecodeOptionDlg.cpp \
-    QxMainWindow.cpp
+    QxDecodeSettings.cpp \
+    QxDecoder.cpp \
+    QxDecompressDevice.cpp \
+    QxDgrReader.cpp \
+    QxEncodedCache.cpp \
+    QxExternalShuffler.cpp \
+    QxGntDataset.cpp \
+    QxGntReader.cpp \
+    QxGntVerifier.cpp \
+    QxMainWindow.cpp \
+    QxNpyWriter.cpp \
+    QxPngWriter.cpp \
+    QxPotReader.cpp \
+    QxSampleProcessor.cpp \
+    QxSampleServer.cpp \
+    QxSampleStore.cpp \
+    QxShardMerger.cpp \
+    QxStrokeRasterizer.cpp
 
 HEADERS  += \
     QxAboutDialog.h \
+    QxAtlasWriter.h \
+    QxAugmenter.h \
+    QxCommandLine.h \
     QxDecodeOptionDlg.h \
-    QxMainWindow.h
+    QxDecodeSettings.h \
+    QxDecoder.h \
+    QxDecompressDevice.h \
+    QxDgrReader.h \
+    QxEncodedCache.h \
+    QxExternalShuffler.h \
+    QxGntDataset.h \
+    QxGntReader.h \
+    QxGntVerifier.h \
+    QxHash.h \
+    QxMainWindow.h \
+    QxNpyWriter.h \
+    QxPngWriter.h \
+    QxPotReader.h \
+    QxSampleProcessor.h \
+    QxSampleServer.h \
+    QxSampleStore.h \
+    QxShardMerger.h \
+    QxStrokeRasterizer.h
 
 RESOURCES += \
     gntdecoder.qrc \
@@ -37,3 +80,7 @@ unix:!macx: LIBS += -lopencv_core
 unix:!macx: LIBS += -lopencv_highgui
 
 unix:!macx: LIBS += -lopencv_imgproc
+
+unix:!macx: LIBS += -lz
+
+unix:!macx: LIBS += -lzstd
@@ -0,0 +1,144 @@
+#include <string.h>
+
+#include <opencv2/highgui/highgui.hpp>
+
+#include <QtConcurrentRun>
+
+#include "QxAtlasWriter.h"
+#include "QxPngWriter.h"
+
+QxAtlasWriter::QxAtlasWriter()
+	: m_pPngWriter(NULL)
+	, m_iTileSide(0)
+	, m_iTilesPerRow(0)
+	, m_uBackground(255)
+	, m_iSheetIndex(0)
+	, m_iTileCount(0)
+	, m_uSampleCount(0)
+	, m_bSheetPending(false)
+{
+}
+
+QxAtlasWriter::~QxAtlasWriter()
+{
+	close();
+}
+
+//Create the manifest, the sheets are created as they fill.
+bool QxAtlasWriter::open(const QString& strSheetPrefix, const QString& strFormat, const QxPngWriter* pPngWriter,
+	int iTileSide, int iSheetSide, uchar uBackground, const QString& strManifestFileName)
+{
+	close();
+	m_strError.clear();
+	m_ManifestFile.setFileName(strManifestFileName);
+	if (!m_ManifestFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		m_strError = QString("Can not create %1: %2").arg(strManifestFileName).arg(m_ManifestFile.errorString());
+		return false;
+	}
+	m_ManifestFile.write("index sheet row col label\n");
+
+	m_strSheetPrefix = strSheetPrefix;
+	m_strFormat = strFormat;
+	m_pPngWriter = pPngWriter;
+	m_iTileSide = iTileSide;
+	m_iTilesPerRow = qMax(1, iSheetSide / iTileSide);
+	m_uBackground = uBackground;
+	m_Sheet = cv::Mat(m_iTilesPerRow * iTileSide, m_iTilesPerRow * iTileSide, CV_8UC1, cv::Scalar(uBackground));
+	m_iSheetIndex = 0;
+	m_iTileCount = 0;
+	m_uSampleCount = 0;
+	return true;
+}
+
+//Append an 8-bit sample of iTileSide x iTileSide pixels.
+bool QxAtlasWriter::append(const uchar* pTile, qint32 iLabel)
+{
+	if (!isOpen() || !m_strError.isEmpty())
+	{
+		return false;
+	}
+	const int iRow = m_iTileCount / m_iTilesPerRow;
+	const int iCol = m_iTileCount % m_iTilesPerRow;
+	for (int y = 0; y != m_iTileSide; ++y)
+	{
+		memcpy(m_Sheet.ptr<uchar>(iRow * m_iTileSide + y) + iCol * m_iTileSide, pTile + size_t(y) * m_iTileSide, m_iTileSide);
+	}
+	QByteArray line;
+	line.append(QByteArray::number(m_uSampleCount)).append(' ').append(QByteArray::number(m_iSheetIndex)).append(' ')
+		.append(QByteArray::number(iRow)).append(' ').append(QByteArray::number(iCol)).append(' ').append(QByteArray::number(iLabel)).append('\n');
+	if (m_ManifestFile.write(line) != line.size())
+	{
+		m_strError = QString("Can not write %1: %2").arg(m_ManifestFile.fileName()).arg(m_ManifestFile.errorString());
+		return false;
+	}
+	++m_uSampleCount;
+	return ++m_iTileCount != m_iTilesPerRow * m_iTilesPerRow || flushSheet();
+}
+
+//Write the last (partial) sheet and wait for all the sheets to be written.
+bool QxAtlasWriter::close()
+{
+	if (!isOpen())
+	{
+		return m_strError.isEmpty();
+	}
+	if (m_iTileCount)
+	{
+		// The last sheet only keeps its used rows.
+		int iRowCount = (m_iTileCount + m_iTilesPerRow - 1) / m_iTilesPerRow;
+		m_Sheet = m_Sheet.rowRange(0, iRowCount * m_iTileSide);
+		flushSheet();
+	}
+	waitForSheet();
+	m_ManifestFile.close();
+	m_Sheet.release();
+	return m_strError.isEmpty();
+}
+
+bool QxAtlasWriter::isOpen() const
+{
+	return m_ManifestFile.isOpen();
+}
+
+quint64 QxAtlasWriter::sampleCount() const
+{
+	return m_uSampleCount;
+}
+
+QString QxAtlasWriter::errorString() const
+{
+	return m_strError;
+}
+
+//Hand the current sheet over to the worker pool, after the previous one is written.
+bool QxAtlasWriter::flushSheet()
+{
+	if (!waitForSheet())
+	{
+		return false;
+	}
+	m_strPendingSheetName = m_strSheetPrefix + QString("%1").arg(m_iSheetIndex, 5, 10, QChar('0')) + "." + m_strFormat;
+	m_PendingSheet = QtConcurrent::run(&QxAtlasWriter::writeSheet, m_strPendingSheetName, m_Sheet, m_pPngWriter);
+	m_bSheetPending = true;
+	// The worker keeps its reference to the full sheet, the next one is a new image.
+	m_Sheet = cv::Mat(m_iTilesPerRow * m_iTileSide, m_iTilesPerRow * m_iTileSide, CV_8UC1, cv::Scalar(m_uBackground));
+	++m_iSheetIndex;
+	m_iTileCount = 0;
+	return true;
+}
+
+bool QxAtlasWriter::waitForSheet()
+{
+	if (m_bSheetPending && !m_PendingSheet.result() && m_strError.isEmpty())
+	{
+		m_strError = "Can not write " + m_strPendingSheetName;
+	}
+	m_bSheetPending = false;
+	return m_strError.isEmpty();
+}
+
+bool QxAtlasWriter::writeSheet(const QString& strFileName, const cv::Mat& sheet, const QxPngWriter* pPngWriter)
+{
+	return pPngWriter ? pPngWriter->write(strFileName, sheet) : cv::imwrite(strFileName.toStdString(), sheet);
+}
@@ -0,0 +1,64 @@
+#ifndef _QX_ATLAS_WRITER_H_
+#define _QX_ATLAS_WRITER_H_
+
+#include <opencv2/core/core.hpp>
+
+#include <QFile>
+#include <QFuture>
+#include <QString>
+
+class QxPngWriter;
+
+/*
+	Tile fixed-size samples into large grid images (sheets), e.g. 4096 samples of 64 x 64 on each 4096 x 4096 sheet,
+	so that a million samples make a few hundred files instead of a million, and each encoding covers thousands of samples.
+	A manifest lists, for each sample index, its sheet, row, column and label:
+		index sheet row col label
+	A full sheet is encoded on the worker pool while the next one is filled.
+*/
+class QxAtlasWriter
+{
+public:
+	QxAtlasWriter();
+	~QxAtlasWriter();
+
+	// Sheets are named strSheetPrefix + sheet number (5 digits) + "." + strFormat, 1, 2 or 4-bit PNG files are written
+	// by pPngWriter when given. The sheets are filled with uBackground around the samples.
+	bool open(const QString& strSheetPrefix, const QString& strFormat, const QxPngWriter* pPngWriter,
+		int iTileSide, int iSheetSide, uchar uBackground, const QString& strManifestFileName);
+	// Append an 8-bit sample of iTileSide x iTileSide pixels.
+	bool append(const uchar* pTile, qint32 iLabel);
+	// Write the last (partial) sheet and wait for all the sheets to be written.
+	bool close();
+
+	bool isOpen() const;
+	quint64 sampleCount() const;
+	QString errorString() const;
+
+private:
+	// Hand the current sheet over to the worker pool, after the previous one is written.
+	bool flushSheet();
+	bool waitForSheet();
+
+	static bool writeSheet(const QString& strFileName, const cv::Mat& sheet, const QxPngWriter* pPngWriter);
+
+private:
+	QString m_strSheetPrefix;
+	QString m_strFormat;
+	const QxPngWriter* m_pPngWriter;
+	int m_iTileSide;
+	int m_iTilesPerRow;
+	uchar m_uBackground;
+
+	cv::Mat m_Sheet;
+	int m_iSheetIndex;
+	int m_iTileCount;
+	quint64 m_uSampleCount;
+	QFile m_ManifestFile;
+	QFuture<bool> m_PendingSheet;
+	bool m_bSheetPending;
+	QString m_strPendingSheetName;
+	QString m_strError;
+};
+
+#endif
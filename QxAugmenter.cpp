@@ -0,0 +1,112 @@
+#include <algorithm>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "QxAugmenter.h"
+#include "QxHash.h"
+
+QxAugmenter::QxAugmenter(const QxDecodeSettings& settings)
+	: m_Settings(settings)
+{
+}
+
+//Seed of one augmented variant of a sample (iVariant counts from 1).
+quint64 QxAugmenter::variantSeed(quint64 uSeed, const QString& strFileName, quint64 uIndexInFile, int iVariant)
+{
+	// Same key as the split (file key and sample index), so the seed doesn't depend on where the files are stored.
+	QByteArray key = QxDecodeSettings::fileKey(strFileName);
+	key.append(':').append(QByteArray::number(uIndexInFile)).append(':').append(QByteArray::number(iVariant));
+	return qxHash64(key, uSeed);
+}
+
+//Return a randomly distorted copy of a padded, white background sample.
+cv::Mat QxAugmenter::augment(const cv::Mat& image, quint64 uVariantSeed) const
+{
+	if (image.empty())
+	{
+		return image.clone();
+	}
+
+	// The parameters are always drawn in the same order, so a seed gives the same variant whatever options are disabled.
+	cv::RNG rng(uVariantSeed);
+	const double dSide = image.cols;
+	double dAngle = rng.uniform(-m_Settings.dMaxRotation, m_Settings.dMaxRotation);
+	double dScale = 1.0 + rng.uniform(-m_Settings.dMaxScale, m_Settings.dMaxScale);
+	double dShear = rng.uniform(-m_Settings.dMaxShear, m_Settings.dMaxShear);
+	double dShiftX = rng.uniform(-m_Settings.dMaxShift, m_Settings.dMaxShift) * dSide;
+	double dShiftY = rng.uniform(-m_Settings.dMaxShift, m_Settings.dMaxShift) * dSide;
+	int iStrokeChange = m_Settings.iMaxStrokeChange ? rng.uniform(-m_Settings.iMaxStrokeChange, m_Settings.iMaxStrokeChange + 1) : 0;
+
+	// Affine jitter around the center: rotation and scale, then a horizontal shear, then a shift.
+	cv::Point2f center(float(image.cols) / 2, float(image.rows) / 2);
+	cv::Mat rotation = cv::getRotationMatrix2D(center, dAngle, dScale);
+	double* pRow0 = rotation.ptr<double>(0);
+	double* pRow1 = rotation.ptr<double>(1);
+	// [x', y'] = R * [x + shear * (y - cy), y]
+	pRow0[2] += -dShear * center.y * pRow0[0];
+	pRow1[2] += -dShear * center.y * pRow1[0];
+	pRow0[1] += dShear * pRow0[0];
+	pRow1[1] += dShear * pRow1[0];
+	pRow0[2] += dShiftX;
+	pRow1[2] += dShiftY;
+	cv::Mat result;
+	cv::warpAffine(image, result, rotation, image.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(255));
+
+	if (m_Settings.dElasticAlpha > 0.0)
+	{
+		result = elasticDistortion(result, rng);
+	}
+
+	// Ink is dark: eroding the image makes the strokes thicker, dilating makes them thinner.
+	if (iStrokeChange)
+	{
+		int iRadius = iStrokeChange > 0 ? iStrokeChange : -iStrokeChange;
+		cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(2 * iRadius + 1, 2 * iRadius + 1));
+		if (iStrokeChange > 0)
+		{
+			cv::erode(result, result, kernel, cv::Point(-1, -1), 1, cv::BORDER_CONSTANT, cv::Scalar(255));
+		}
+		else
+		{
+			cv::dilate(result, result, kernel, cv::Point(-1, -1), 1, cv::BORDER_CONSTANT, cv::Scalar(255));
+		}
+	}
+	return result;
+}
+
+//Elastic distortion (Simard et al.): a smooth random displacement field.
+cv::Mat QxAugmenter::elasticDistortion(const cv::Mat& image, cv::RNG& rng) const
+{
+	const double dSide = image.cols;
+	cv::Mat dx(image.size(), CV_32FC1);
+	cv::Mat dy(image.size(), CV_32FC1);
+	rng.fill(dx, cv::RNG::UNIFORM, -1.0, 1.0);
+	rng.fill(dy, cv::RNG::UNIFORM, -1.0, 1.0);
+	double dSigma = std::max(m_Settings.dElasticSigma * dSide, 0.5);
+	cv::GaussianBlur(dx, dx, cv::Size(0, 0), dSigma);
+	cv::GaussianBlur(dy, dy, cv::Size(0, 0), dSigma);
+
+	// Rescale the smoothed field, so that the displacement is proportional to the sample side whatever the smoothness.
+	cv::Scalar mean;
+	cv::Scalar stdDevX;
+	cv::Scalar stdDevY;
+	cv::meanStdDev(dx, mean, stdDevX);
+	cv::meanStdDev(dy, mean, stdDevY);
+	double dAlpha = m_Settings.dElasticAlpha * dSide;
+	dx.convertTo(dx, CV_32F, stdDevX[0] > 0 ? dAlpha / stdDevX[0] : 0.0);
+	dy.convertTo(dy, CV_32F, stdDevY[0] > 0 ? dAlpha / stdDevY[0] : 0.0);
+
+	for (int row = 0; row != image.rows; ++row)
+	{
+		float* pX = dx.ptr<float>(row);
+		float* pY = dy.ptr<float>(row);
+		for (int col = 0; col != image.cols; ++col)
+		{
+			pX[col] += float(col);
+			pY[col] += float(row);
+		}
+	}
+	cv::Mat result;
+	cv::remap(image, result, dx, dy, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(255));
+	return result;
+}
@@ -0,0 +1,31 @@
+#ifndef _QX_AUGMENTER_H_
+#define _QX_AUGMENTER_H_
+
+#include <opencv2/core/core.hpp>
+
+#include "QxDecodeSettings.h"
+
+/*
+	Data augmentation of padded samples: small affine jitter, elastic distortion and stroke width change.
+	Every variant draws its random parameters from its own seed, derived from the sample identity only,
+	so the results are reproducible and don't depend on the number of threads or on the processing order.
+*/
+class QxAugmenter
+{
+public:
+	explicit QxAugmenter(const QxDecodeSettings& settings);
+
+	// Seed of one augmented variant of a sample (iVariant counts from 1).
+	static quint64 variantSeed(quint64 uSeed, const QString& strFileName, quint64 uIndexInFile, int iVariant);
+
+	// Return a randomly distorted copy of a padded, white background sample. Thread-safe.
+	cv::Mat augment(const cv::Mat& image, quint64 uVariantSeed) const;
+
+private:
+	cv::Mat elasticDistortion(const cv::Mat& image, cv::RNG& rng) const;
+
+private:
+	QxDecodeSettings m_Settings;
+};
+
+#endif
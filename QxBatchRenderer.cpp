@@ -0,0 +1,143 @@
+#include <QMutexLocker>
+#include <QThread>
+
+#include "QxBatchRenderer.h"
+#include "QxGntDataset.h"
+
+// Number of samples a thread takes at once, small enough to balance samples of very different sizes.
+static const int g_iChunkSize = 4;
+
+// Thread running QxBatchRenderer::work().
+class QxBatchRenderer::Worker : public QThread
+{
+public:
+	explicit Worker(QxBatchRenderer* pRenderer) : m_pRenderer(pRenderer) {}
+
+protected:
+	virtual void run() { m_pRenderer->work(); }
+
+private:
+	QxBatchRenderer* m_pRenderer;
+};
+
+QxBatchRenderer::QxBatchRenderer(const QxGntDataset* pDataset, int iThreadCount)
+	: m_pDataset(pDataset)
+	, m_uGeneration(0)
+	, m_iBusyWorkers(0)
+	, m_bQuit(false)
+	, m_pIndices(NULL)
+	, m_iCount(0)
+	, m_iSide(0)
+	, m_pImages(NULL)
+	, m_pLabels(NULL)
+	, m_iNextSample(0)
+{
+	if (iThreadCount <= 0)
+	{
+		iThreadCount = QThread::idealThreadCount();
+	}
+	// The calling thread renders too.
+	for (int i = 1; i < iThreadCount; ++i)
+	{
+		QThread* pWorker = new Worker(this);
+		m_Workers.append(pWorker);
+		pWorker->start();
+	}
+}
+
+QxBatchRenderer::~QxBatchRenderer()
+{
+	{
+		QMutexLocker locker(&m_Mutex);
+		m_bQuit = true;
+		m_BatchReady.wakeAll();
+	}
+	for (QList<QThread*>::iterator itr = m_Workers.begin(); itr != m_Workers.end(); ++itr)
+	{
+		(*itr)->wait();
+	}
+	qDeleteAll(m_Workers);
+}
+
+int QxBatchRenderer::threadCount() const
+{
+	return m_Workers.size() + 1;
+}
+
+//Render a batch into the caller's buffers.
+void QxBatchRenderer::render(const quint64* pIndices, int iCount, int iSide, uchar* pImages, qint32* pLabels)
+{
+	QMutexLocker renderLocker(&m_RenderMutex);
+	{
+		QMutexLocker locker(&m_Mutex);
+		m_pIndices = pIndices;
+		m_iCount = iCount;
+		m_iSide = iSide;
+		m_pImages = pImages;
+		m_pLabels = pLabels;
+		m_iNextSample.store(0);
+		m_iBusyWorkers = m_Workers.size();
+		++m_uGeneration;
+		m_BatchReady.wakeAll();
+	}
+
+	renderChunks();
+
+	QMutexLocker locker(&m_Mutex);
+	while (m_iBusyWorkers)
+	{
+		m_BatchDone.wait(&m_Mutex);
+	}
+}
+
+//Run on the worker threads: wait for batches and render them until the renderer is destroyed.
+void QxBatchRenderer::work()
+{
+	quint64 uSeenGeneration = 0;
+	for (;;)
+	{
+		{
+			QMutexLocker locker(&m_Mutex);
+			while (m_uGeneration == uSeenGeneration && !m_bQuit)
+			{
+				m_BatchReady.wait(&m_Mutex);
+			}
+			if (m_bQuit)
+			{
+				return;
+			}
+			uSeenGeneration = m_uGeneration;
+		}
+
+		renderChunks();
+
+		QMutexLocker locker(&m_Mutex);
+		if (--m_iBusyWorkers == 0)
+		{
+			m_BatchDone.wakeAll();
+		}
+	}
+}
+
+//Render chunks of the current batch until all of them are taken.
+void QxBatchRenderer::renderChunks()
+{
+	const size_t uImageSize = size_t(m_iSide) * m_iSide;
+	for (;;)
+	{
+		int iBegin = m_iNextSample.fetchAndAddRelaxed(g_iChunkSize);
+		if (iBegin >= m_iCount)
+		{
+			return;
+		}
+		int iEnd = qMin(iBegin + g_iChunkSize, m_iCount);
+		for (int i = iBegin; i != iEnd; ++i)
+		{
+			m_pDataset->render(m_pIndices[i], m_iSide, m_pImages + uImageSize * i);
+			if (m_pLabels)
+			{
+				m_pLabels[i] = qint32(m_pDataset->label(m_pIndices[i]));
+			}
+		}
+	}
+}
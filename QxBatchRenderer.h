@@ -0,0 +1,60 @@
+#ifndef _QX_BATCH_RENDERER_H_
+#define _QX_BATCH_RENDERER_H_
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QThread;
+class QxGntDataset;
+
+/*
+	Render batches of samples of a QxGntDataset into a caller provided buffer with a fixed set of threads.
+	The threads are started once and wait for work, so that rendering a batch doesn't start any thread:
+	the samples are handed out in small chunks through an atomic counter, the calling thread takes part too.
+*/
+class QxBatchRenderer
+{
+public:
+	// iThreadCount is the total number of threads rendering a batch, including the calling one (0 means the number of cores).
+	QxBatchRenderer(const QxGntDataset* pDataset, int iThreadCount);
+	~QxBatchRenderer();
+
+	int threadCount() const;
+	/* Render the samples pIndices[0..iCount) into pImages (iCount x iSide x iSide 8-bit pixels) and write their labels
+	  into pLabels (may be NULL). The indices and the side must be valid. Calls from several threads are serialized. */
+	void render(const quint64* pIndices, int iCount, int iSide, uchar* pImages, qint32* pLabels);
+
+private:
+	class Worker;
+
+	// Run on the worker threads: wait for batches and render them until the renderer is destroyed.
+	void work();
+	// Render chunks of the current batch until all of them are taken.
+	void renderChunks();
+
+private:
+	const QxGntDataset* m_pDataset;
+	QList<QThread*> m_Workers;
+	// Only one batch at a time.
+	QMutex m_RenderMutex;
+
+	// Shared with the worker threads.
+	QMutex m_Mutex;
+	QWaitCondition m_BatchReady;
+	QWaitCondition m_BatchDone;
+	quint64 m_uGeneration;
+	int m_iBusyWorkers;
+	bool m_bQuit;
+
+	// Current batch, set under m_Mutex before m_uGeneration changes.
+	const quint64* m_pIndices;
+	int m_iCount;
+	int m_iSide;
+	uchar* m_pImages;
+	qint32* m_pLabels;
+	QAtomicInt m_iNextSample;
+};
+
+#endif
@@ -0,0 +1,400 @@
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QTextStream>
+#include <QThreadPool>
+
+#include "QxCommandLine.h"
+#include "QxDecoder.h"
+#include "QxGntDataset.h"
+#include "QxGntVerifier.h"
+#include "QxSampleServer.h"
+#include "QxShardMerger.h"
+
+//True when the application is started with command line options instead of the graphic user interface.
+bool QxCommandLine::isRequested(int argc, char* argv[])
+{
+	return argc > 1 && argv[1][0] == '-';
+}
+
+//Run the requested command. Return the exit code of the application.
+int QxCommandLine::run(const QStringList& arguments)
+{
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Decode .gnt files (offline handwriting database), .pot files (online handwriting database) and .dgr files (offline text lines) created by CASIA.");
+	parser.addHelpOption();
+	QCommandLineOption verifyOption("verify", "Check the files for corrupt or truncated samples.");
+	QCommandLineOption serveOption("serve", "Serve decoded batches of the files on a local (Unix-domain) socket, see QxSampleServer.h for the protocol.", "socket");
+	QCommandLineOption decodeOption("decode", "Decode the files into a folder, with the options below.", "folder");
+	QCommandLineOption mergeOption("merge", "Merge the label files of the shard folders given as arguments into a folder.", "folder");
+	QCommandLineOption threadsOption("threads", "Number of worker threads (default: number of cores).", "n");
+	parser.addOption(verifyOption);
+	parser.addOption(serveOption);
+	parser.addOption(decodeOption);
+	parser.addOption(mergeOption);
+	parser.addOption(threadsOption);
+	parser.addOption(QCommandLineOption("size", "Decode: side of the images (default: 64), or several sides decoded at once, e.g. 128,64,32.", "n"));
+	parser.addOption(QCommandLineOption("format", "Decode: image file format, e.g. png, jpg or bmp (default: png).", "format"));
+	parser.addOption(QCommandLineOption("png-bits", "Decode: bits per pixel of PNG images, 8, 4, 2 or 1 (thresholded at --threshold, default: 8).", "n"));
+	parser.addOption(QCommandLineOption("threshold", "Decode: threshold of 1-bit PNG images (default: 128).", "n"));
+	parser.addOption(QCommandLineOption("stroke-width", "Decode: width of the strokes of online .pot samples, in pixels of the largest side (default: 2).", "w"));
+	parser.addOption(QCommandLineOption("app", "Decode: application of the images, caffe, cntk, digits or tensorflow (default: caffe).", "app"));
+	parser.addOption(QCommandLineOption("packed", "Decode: write packed .npy tensors of uint8 or float32 instead of image files.", "type"));
+	parser.addOption(QCommandLineOption("atlas", "Decode: tile the samples into square sheets of this side instead of image files, with a sheets.txt manifest.", "side"));
+	parser.addOption(QCommandLineOption("fan-out", "Decode: spread the images over 256 hashed folders (hash), 256 x 256 (hash2) or one folder per tag code (code).", "layout"));
+	parser.addOption(QCommandLineOption("cache", "Decode: reuse the images encoded by former decodings from this cache folder.", "folder"));
+	parser.addOption(QCommandLineOption("cache-size", "Decode: size limit of the cache in MB (default: 4096).", "MB"));
+	parser.addOption(QCommandLineOption("split", "Decode: split the samples into train/val/test sets by sample or by file.", "mode"));
+	parser.addOption(QCommandLineOption("train", "Decode: percentage of the training set (default: 80).", "percent"));
+	parser.addOption(QCommandLineOption("val", "Decode: percentage of the validation set (default: 10).", "percent"));
+	parser.addOption(QCommandLineOption("split-seed", "Decode: seed of the split (default: 0).", "seed"));
+	parser.addOption(QCommandLineOption("shuffle", "Decode: shuffle the output order with this seed.", "seed"));
+	parser.addOption(QCommandLineOption("shard", "Decode: decode only the shard i (from 0) of n, see --merge.", "i/n"));
+	parser.addOption(QCommandLineOption("shard-by", "Decode: distribute the files or the samples over the shards, file or sample (default: file).", "mode"));
+	parser.addPositionalArgument("files", "The .gnt, .pot or .dgr (.gz, .zst) files, or the shard folders for --merge.", "files...");
+	parser.process(arguments);
+
+	if (parser.isSet(threadsOption))
+	{
+		int iThreadCount = parser.value(threadsOption).toInt();
+		if (iThreadCount > 0)
+		{
+			QThreadPool::globalInstance()->setMaxThreadCount(iThreadCount);
+		}
+	}
+
+	QStringList fileList = parser.positionalArguments();
+	if (parser.isSet(verifyOption) && !fileList.isEmpty())
+	{
+		return verify(fileList);
+	}
+	if (parser.isSet(serveOption) && !fileList.isEmpty())
+	{
+		return serve(fileList, parser.value(serveOption));
+	}
+	if (parser.isSet(decodeOption) && !fileList.isEmpty())
+	{
+		QxDecodeSettings settings;
+		settings.strDestinationPath = parser.value(decodeOption);
+		QString strError;
+		if (!parseDecodeSettings(parser, settings, strError))
+		{
+			QTextStream(stderr) << strError << "\n";
+			return 2;
+		}
+		return decode(fileList, settings);
+	}
+	if (parser.isSet(mergeOption) && !fileList.isEmpty())
+	{
+		return merge(fileList, parser.value(mergeOption));
+	}
+
+	parser.showHelp(2);
+	return 2;
+}
+
+//Check .gnt files for corrupt or truncated samples, one report line per file.
+int QxCommandLine::verify(const QStringList& fileList)
+{
+	QList<QxGntVerifyResult> results = QxGntVerifier::verifyFiles(fileList);
+
+	QTextStream out(stdout);
+	int iFailedCount = 0;
+	quint64 uSampleCount = 0;
+	for (QList<QxGntVerifyResult>::const_iterator itr = results.begin(); itr != results.end(); ++itr)
+	{
+		out << itr->toString() << "\n";
+		uSampleCount += itr->uSampleCount;
+		if (!itr->bOk)
+		{
+			++iFailedCount;
+		}
+	}
+	out << results.size() << " files, " << uSampleCount << " samples, " << iFailedCount << " corrupt files\n";
+	return iFailedCount ? 1 : 0;
+}
+
+//Serve decoded batches of the files to local clients until the process is stopped.
+int QxCommandLine::serve(const QStringList& fileList, const QString& strServerName)
+{
+	QTextStream out(stdout);
+	QTextStream err(stderr);
+	QxGntDataset dataset;
+	if (!dataset.open(fileList))
+	{
+		err << dataset.errorString() << "\n";
+		return 1;
+	}
+
+	int iExitCode = 0;
+	{
+		QxSampleServer server(&dataset);
+		if (!server.listen(strServerName))
+		{
+			err << "Can not listen on " << strServerName << ": " << server.errorString() << "\n";
+			return 1;
+		}
+		out << "Serving " << dataset.sampleCount() << " samples of " << dataset.classCount() << " classes on " << server.fullServerName() << "\n";
+		out.flush();
+		iExitCode = QCoreApplication::exec();
+	}
+	// Batches may still be prepared for clients which were connected, they read the dataset.
+	QThreadPool::globalInstance()->waitForDone();
+	return iExitCode;
+}
+
+//Fill the decoding settings from the --size, --format... options. Return false and set strError for invalid values.
+bool QxCommandLine::parseDecodeSettings(const QCommandLineParser& parser, QxDecodeSettings& settings, QString& strError)
+{
+	bool bOk = true;
+	if (parser.isSet("size"))
+	{
+		// The first side is the main one, the others are decoded along with it.
+		QStringList sizes = parser.value("size").split(',');
+		for (int i = 0; i != sizes.size(); ++i)
+		{
+			int iSize = sizes.at(i).toInt(&bOk);
+			if (!bOk || iSize <= 0)
+			{
+				strError = "Invalid image size: " + parser.value("size");
+				return false;
+			}
+			if (i == 0)
+			{
+				settings.imageSize = cv::Size(iSize, iSize);
+			}
+			else
+			{
+				settings.extraImageSides.append(iSize);
+			}
+		}
+		if (settings.imageSides().size() > QxDecoder::MaxImageSizeCount)
+		{
+			strError = QString("At most %1 image sizes can be decoded at once.").arg(QxDecoder::MaxImageSizeCount);
+			return false;
+		}
+	}
+	if (parser.isSet("format"))
+	{
+		settings.imageFormat = parser.value("format").toLower();
+	}
+	if (parser.isSet("png-bits"))
+	{
+		settings.iPngBitDepth = parser.value("png-bits").toInt(&bOk);
+		if (!bOk || (settings.iPngBitDepth != 8 && settings.iPngBitDepth != 4 && settings.iPngBitDepth != 2 && settings.iPngBitDepth != 1))
+		{
+			strError = "Invalid PNG bit depth: " + parser.value("png-bits");
+			return false;
+		}
+	}
+	if (parser.isSet("threshold"))
+	{
+		settings.iThreshold = parser.value("threshold").toInt(&bOk);
+		if (!bOk || settings.iThreshold < 0 || settings.iThreshold > 255)
+		{
+			strError = "Invalid threshold: " + parser.value("threshold");
+			return false;
+		}
+	}
+	if (parser.isSet("stroke-width"))
+	{
+		settings.dStrokeWidth = parser.value("stroke-width").toDouble(&bOk);
+		if (!bOk || settings.dStrokeWidth <= 0.0)
+		{
+			strError = "Invalid stroke width: " + parser.value("stroke-width");
+			return false;
+		}
+	}
+	if (parser.isSet("app"))
+	{
+		QString strApp = parser.value("app").toLower();
+		if (strApp == "caffe")
+		{
+			settings.appType = QxDecodeOptionDlg::Caffe;
+		}
+		else if (strApp == "cntk")
+		{
+			settings.appType = QxDecodeOptionDlg::CNTK;
+		}
+		else if (strApp == "digits")
+		{
+			settings.appType = QxDecodeOptionDlg::DIGITS;
+		}
+		else if (strApp == "tensorflow")
+		{
+			settings.appType = QxDecodeOptionDlg::TensorFlow;
+		}
+		else
+		{
+			strError = "Unknown application: " + parser.value("app");
+			return false;
+		}
+	}
+	if (parser.isSet("packed"))
+	{
+		QString strType = parser.value("packed").toLower();
+		if (strType != "uint8" && strType != "float32")
+		{
+			strError = "Unknown tensor type: " + parser.value("packed");
+			return false;
+		}
+		settings.outputMode = QxDecodeSettings::PackedTensors;
+		settings.tensorType = (strType == "uint8") ? QxDecodeSettings::UInt8Tensor : QxDecodeSettings::Float32Tensor;
+	}
+	if (parser.isSet("atlas"))
+	{
+		settings.iAtlasSide = parser.value("atlas").toInt(&bOk);
+		if (!bOk || settings.iAtlasSide <= 0)
+		{
+			strError = "Invalid atlas sheet side: " + parser.value("atlas");
+			return false;
+		}
+		if (parser.isSet("packed"))
+		{
+			strError = "--atlas and --packed can not be used together";
+			return false;
+		}
+		settings.outputMode = QxDecodeSettings::AtlasSheets;
+	}
+	if (parser.isSet("fan-out"))
+	{
+		QString strLayout = parser.value("fan-out").toLower();
+		if (strLayout == "none")
+		{
+			settings.fanOutMode = QxDecodeSettings::NoFanOut;
+		}
+		else if (strLayout == "hash")
+		{
+			settings.fanOutMode = QxDecodeSettings::HashFanOut;
+		}
+		else if (strLayout == "hash2")
+		{
+			settings.fanOutMode = QxDecodeSettings::TwoLevelHashFanOut;
+		}
+		else if (strLayout == "code")
+		{
+			settings.fanOutMode = QxDecodeSettings::TagCodeFanOut;
+		}
+		else
+		{
+			strError = "Unknown fan-out layout: " + parser.value("fan-out");
+			return false;
+		}
+	}
+	if (parser.isSet("cache"))
+	{
+		settings.strCachePath = parser.value("cache");
+	}
+	if (parser.isSet("cache-size"))
+	{
+		qint64 iCacheSize = parser.value("cache-size").toLongLong(&bOk);
+		if (!bOk || iCacheSize <= 0)
+		{
+			strError = "Invalid cache size: " + parser.value("cache-size");
+			return false;
+		}
+		settings.iCacheSizeLimit = iCacheSize * 1024 * 1024;
+	}
+
+	if (parser.isSet("split"))
+	{
+		QString strMode = parser.value("split").toLower();
+		if (strMode != "sample" && strMode != "file")
+		{
+			strError = "Unknown split mode: " + parser.value("split");
+			return false;
+		}
+		settings.splitMode = (strMode == "sample") ? QxDecodeSettings::SplitBySample : QxDecodeSettings::SplitByFile;
+	}
+	if (parser.isSet("train"))
+	{
+		settings.uTrainPercent = parser.value("train").toUInt(&bOk);
+	}
+	if (bOk && parser.isSet("val"))
+	{
+		settings.uValidationPercent = parser.value("val").toUInt(&bOk);
+	}
+	if (!bOk || settings.uTrainPercent + settings.uValidationPercent > 100)
+	{
+		strError = "The training and validation percentages must not exceed 100 together.";
+		return false;
+	}
+	if (parser.isSet("split-seed"))
+	{
+		settings.uSplitSeed = parser.value("split-seed").toULongLong(&bOk);
+	}
+	if (bOk && parser.isSet("shuffle"))
+	{
+		settings.bShuffle = true;
+		settings.uShuffleSeed = parser.value("shuffle").toULongLong(&bOk);
+	}
+	if (!bOk)
+	{
+		strError = "Seeds must be unsigned integers.";
+		return false;
+	}
+
+	if (parser.isSet("shard"))
+	{
+		// "i/n", e.g. "2/8" is the third of eight shards.
+		QStringList fields = parser.value("shard").split('/');
+		bool bCountOk = false;
+		settings.iShardIndex = fields.size() == 2 ? fields.first().toInt(&bOk) : -1;
+		settings.iShardCount = fields.size() == 2 ? fields.last().toInt(&bCountOk) : 0;
+		if (!bOk || !bCountOk || settings.iShardCount <= 0 || settings.iShardIndex < 0 || settings.iShardIndex >= settings.iShardCount)
+		{
+			strError = "Invalid shard, expected i/n with 0 <= i < n: " + parser.value("shard");
+			return false;
+		}
+	}
+	if (parser.isSet("shard-by"))
+	{
+		QString strMode = parser.value("shard-by").toLower();
+		if (strMode != "sample" && strMode != "file")
+		{
+			strError = "Unknown shard mode: " + parser.value("shard-by");
+			return false;
+		}
+		settings.shardMode = (strMode == "sample") ? QxDecodeSettings::ShardBySample : QxDecodeSettings::ShardByFile;
+	}
+	return true;
+}
+
+//Decode the files without any window, the questions get their default answer.
+int QxCommandLine::decode(const QStringList& fileList, const QxDecodeSettings& settings)
+{
+	if (!QDir().mkpath(settings.strDestinationPath))
+	{
+		QTextStream(stderr) << "Can not create " << settings.strDestinationPath << "\n";
+		return 1;
+	}
+	QxDecoder decoder;
+	if (!decoder.decodeFiles(fileList, settings))
+	{
+		return 1;
+	}
+	if (!settings.strCachePath.isEmpty())
+	{
+		QTextStream(stdout) << decoder.cachedImageCount() << " images from the cache\n";
+	}
+	return 0;
+}
+
+//Merge the label files of the shard folders into strDestinationPath.
+int QxCommandLine::merge(const QStringList& shardPaths, const QString& strDestinationPath)
+{
+	if (!QDir().mkpath(strDestinationPath))
+	{
+		QTextStream(stderr) << "Can not create " << strDestinationPath << "\n";
+		return 1;
+	}
+	QxShardMerger merger;
+	if (!merger.merge(shardPaths, strDestinationPath))
+	{
+		QTextStream(stderr) << merger.errorString() << "\n";
+		return 1;
+	}
+	QTextStream(stdout) << shardPaths.size() << " shards, " << merger.sampleCount() << " samples, " << merger.classCount() << " classes\n";
+	return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef _QX_COMMAND_LINE_H_
+#define _QX_COMMAND_LINE_H_
+
+#include <QStringList>
+
+#include "QxDecodeSettings.h"
+
+class QCommandLineParser;
+
+/*
+	Command line mode of the application, used for batch jobs without any window, e.g.
+		GntDecoder --verify data/*.gnt
+		GntDecoder --serve /tmp/gnt.sock data/*.gnt
+		GntDecoder --decode out/shard-0 --shard 0/4 --split sample data/*.gnt
+		GntDecoder --merge out/all out/shard-*
+*/
+class QxCommandLine
+{
+public:
+	// True when the application is started with command line options instead of the graphic user interface.
+	static bool isRequested(int argc, char* argv[]);
+	// Run the requested command. Return the exit code of the application.
+	static int run(const QStringList& arguments);
+
+private:
+	// Check .gnt files for corrupt or truncated samples, one report line per file.
+	static int verify(const QStringList& fileList);
+	// Serve decoded batches of the files to local clients until the process is stopped.
+	static int serve(const QStringList& fileList, const QString& strServerName);
+	// Fill the decoding settings from the --size, --format... options. Return false and set strError for invalid values.
+	static bool parseDecodeSettings(const QCommandLineParser& parser, QxDecodeSettings& settings, QString& strError);
+	// Decode the files without any window, the questions get their default answer.
+	static int decode(const QStringList& fileList, const QxDecodeSettings& settings);
+	// Merge the label files of the shard folders into strDestinationPath.
+	static int merge(const QStringList& shardPaths, const QString& strDestinationPath);
+};
+
+#endif
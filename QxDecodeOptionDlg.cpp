@@ -1,6 +1,11 @@
 #include "QxDecodeOptionDlg.h"
+#include "QxDecodeSettings.h"
+#include "QxPotReader.h"
 
+#include <QCheckBox>
+#include <QComboBox>
 #include <QFileDialog>
+#include <QGridLayout>
 #include <QGroupBox>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -9,6 +14,7 @@
 #include <QMessageBox>
 #include <QPushButton>
 #include <QRadioButton>
+#include <QStandardPaths>
 #include <QStringList>
 
 static const unsigned UINT_DEFAULT_IMAGE_SIZE = 64;
@@ -54,7 +60,14 @@ void QxDecodeOptionDlg::initDialog(const QStringList& fileList)
 	m_pJpegFormat = new QRadioButton("JPEG");
 	m_pPpmFormat = new QRadioButton("PPM");
 	m_pBmpFormat = new QRadioButton("BMP");
+	// PNG can store near-binary glyphs with fewer bits per pixel
+	m_pPngBitDepthComboBox = new QComboBox;
+	m_pPngBitDepthComboBox->addItem("8 bit", 8);
+	m_pPngBitDepthComboBox->addItem("4 bit gray", 4);
+	m_pPngBitDepthComboBox->addItem("2 bit gray", 2);
+	m_pPngBitDepthComboBox->addItem("1 bit threshold", 1);
 	pImageFormatBoxLayout->addWidget(m_pPngFormat);
+	pImageFormatBoxLayout->addWidget(m_pPngBitDepthComboBox);
 	pImageFormatBoxLayout->addWidget(m_pPpmFormat);
 	pImageFormatBoxLayout->addWidget(m_pBmpFormat);
 	pImageFormatBoxLayout->addWidget(m_pJpegFormat);
@@ -76,8 +89,139 @@ void QxDecodeOptionDlg::initDialog(const QStringList& fileList)
 	pImageSizetBoxLayout->addWidget(m_pMedium);
 	pImageSizetBoxLayout->addWidget(m_pLarge);
 	pImageSizetBoxLayout->addLayout(pImageSizeLayout);
+	// more sizes decoded in the same pass, each in its own sub-folder
+	m_pExtraSizesEdit = new QLineEdit;
+	m_pExtraSizesEdit->setPlaceholderText("e.g. 32, 128");
+	pImageSizetBoxLayout->addWidget(new QLabel("Also: "));
+	pImageSizetBoxLayout->addWidget(m_pExtraSizesEdit);
+	// online samples are drawn with this stroke width, in pixels of the largest size
+	m_pStrokeWidthEdit = new QLineEdit("2");
+	pImageSizetBoxLayout->addWidget(new QLabel("Stroke width (.pot): "));
+	pImageSizetBoxLayout->addWidget(m_pStrokeWidthEdit);
+	bool bPotFiles = false;
+	for (QStringList::const_iterator itr = fileList.begin(); itr != fileList.end() && !bPotFiles; ++itr)
+	{
+		bPotFiles = QxPotReader::isPotFile(*itr);
+	}
+	m_pStrokeWidthEdit->setEnabled(bPotFiles);
 	m_pImageSizeGroupBox->setLayout(pImageSizetBoxLayout);
 
+	// split the samples into train/validation/test sets while decoding
+	m_pSplitGroupBox = new QGroupBox("Split: ");
+    QPointer<QGridLayout> pSplitBoxLayout = new QGridLayout;
+	m_pNoSplit = new QRadioButton("None");
+	m_pSplitBySample = new QRadioButton("By sample");
+	m_pSplitByFile = new QRadioButton("By writer (.gnt file)");
+	m_pTrainPercentEdit = new QLineEdit("80");
+	m_pValidationPercentEdit = new QLineEdit("10");
+	m_pSplitSeedEdit = new QLineEdit("0");
+	pSplitBoxLayout->addWidget(m_pNoSplit, 0, 0);
+	pSplitBoxLayout->addWidget(m_pSplitBySample, 1, 0);
+	pSplitBoxLayout->addWidget(m_pSplitByFile, 2, 0);
+	pSplitBoxLayout->addWidget(new QLabel("Train (%): "), 0, 1);
+	pSplitBoxLayout->addWidget(m_pTrainPercentEdit, 0, 2);
+	pSplitBoxLayout->addWidget(new QLabel("Validation (%): "), 1, 1);
+	pSplitBoxLayout->addWidget(m_pValidationPercentEdit, 1, 2);
+	pSplitBoxLayout->addWidget(new QLabel("Seed: "), 2, 1);
+	pSplitBoxLayout->addWidget(m_pSplitSeedEdit, 2, 2);
+	m_pSplitGroupBox->setLayout(pSplitBoxLayout);
+
+	// per-sample post-processing, done in the same pass as padding and resizing
+	m_pPostProcessGroupBox = new QGroupBox("Post-processing: ");
+    QPointer<QGridLayout> pPostProcessBoxLayout = new QGridLayout;
+	m_pInvertCheckBox = new QCheckBox("Invert (ink = 1)");
+	m_pBinarizeComboBox = new QComboBox;
+	m_pBinarizeComboBox->addItem("No binarization", QxDecodeSettings::NoBinarization);
+	m_pBinarizeComboBox->addItem("Global threshold", QxDecodeSettings::GlobalThreshold);
+	m_pBinarizeComboBox->addItem("Otsu", QxDecodeSettings::OtsuThreshold);
+	m_pThresholdEdit = new QLineEdit("128");
+	m_pNormalizeComboBox = new QComboBox;
+	m_pNormalizeComboBox->addItem("No normalization", QxDecodeSettings::NoNormalization);
+	m_pNormalizeComboBox->addItem("[0, 1]", QxDecodeSettings::UnitRange);
+	m_pNormalizeComboBox->addItem("Mean/std", QxDecodeSettings::MeanStd);
+	m_pMeanEdit = new QLineEdit("0");
+	m_pStdEdit = new QLineEdit("1");
+	pPostProcessBoxLayout->addWidget(m_pInvertCheckBox, 0, 0, 1, 2);
+	pPostProcessBoxLayout->addWidget(m_pBinarizeComboBox, 1, 0);
+	pPostProcessBoxLayout->addWidget(new QLabel("Threshold: "), 1, 1);
+	pPostProcessBoxLayout->addWidget(m_pThresholdEdit, 1, 2);
+	pPostProcessBoxLayout->addWidget(m_pNormalizeComboBox, 2, 0);
+	pPostProcessBoxLayout->addWidget(new QLabel("Mean: "), 2, 1);
+	pPostProcessBoxLayout->addWidget(m_pMeanEdit, 2, 2);
+	pPostProcessBoxLayout->addWidget(new QLabel("Std: "), 2, 3);
+	pPostProcessBoxLayout->addWidget(m_pStdEdit, 2, 4);
+	m_pPostProcessGroupBox->setLayout(pPostProcessBoxLayout);
+
+	// one image file per sample, packed tensor files, or atlas sheets
+	m_pOutputGroupBox = new QGroupBox("Output: ");
+    QPointer<QVBoxLayout> pOutputBoxLayout = new QVBoxLayout;
+	m_pImageFilesOutput = new QRadioButton("Image files");
+	m_pPackedOutput = new QRadioButton("Packed tensors (.npy)");
+	m_pAtlasOutput = new QRadioButton("Atlas sheets, sheet side: ");
+	m_pAtlasSideEdit = new QLineEdit("4096");
+	m_pTensorTypeComboBox = new QComboBox;
+	m_pTensorTypeComboBox->addItem("uint8", QxDecodeSettings::UInt8Tensor);
+	m_pTensorTypeComboBox->addItem("float32", QxDecodeSettings::Float32Tensor);
+	m_pFanOutComboBox = new QComboBox;
+	m_pFanOutComboBox->addItem("Single folder", QxDecodeSettings::NoFanOut);
+	m_pFanOutComboBox->addItem("256 hashed folders", QxDecodeSettings::HashFanOut);
+	m_pFanOutComboBox->addItem("256 x 256 hashed folders", QxDecodeSettings::TwoLevelHashFanOut);
+	m_pFanOutComboBox->addItem("One folder per tag code", QxDecodeSettings::TagCodeFanOut);
+	pOutputBoxLayout->addWidget(m_pImageFilesOutput);
+	pOutputBoxLayout->addWidget(m_pFanOutComboBox);
+	pOutputBoxLayout->addWidget(m_pPackedOutput);
+	pOutputBoxLayout->addWidget(m_pTensorTypeComboBox);
+	pOutputBoxLayout->addWidget(m_pAtlasOutput);
+	pOutputBoxLayout->addWidget(m_pAtlasSideEdit);
+	m_pShuffleCheckBox = new QCheckBox("Shuffle order, seed: ");
+	m_pShuffleSeedEdit = new QLineEdit("0");
+	pOutputBoxLayout->addWidget(m_pShuffleCheckBox);
+	pOutputBoxLayout->addWidget(m_pShuffleSeedEdit);
+	m_pCacheCheckBox = new QCheckBox("Reuse cached images, cache size (MB): ");
+	m_pCacheSizeEdit = new QLineEdit("4096");
+	pOutputBoxLayout->addWidget(m_pCacheCheckBox);
+	pOutputBoxLayout->addWidget(m_pCacheSizeEdit);
+	m_pOutputGroupBox->setLayout(pOutputBoxLayout);
+
+	// augmented variants of each sample, generated on the worker threads
+	m_pAugmentGroupBox = new QGroupBox("Augmentation: ");
+    QPointer<QGridLayout> pAugmentBoxLayout = new QGridLayout;
+	m_pAugmentCountEdit = new QLineEdit("0");
+	m_pKeepOriginalCheckBox = new QCheckBox("Keep original");
+	m_pKeepOriginalCheckBox->setChecked(true);
+	m_pRotationEdit = new QLineEdit("5");
+	m_pScaleEdit = new QLineEdit("0.1");
+	m_pShearEdit = new QLineEdit("0.1");
+	m_pShiftEdit = new QLineEdit("0.05");
+	m_pElasticAlphaEdit = new QLineEdit("0.02");
+	m_pElasticSigmaEdit = new QLineEdit("0.08");
+	m_pStrokeChangeEdit = new QLineEdit("1");
+	m_pAugmentSeedEdit = new QLineEdit("0");
+	pAugmentBoxLayout->addWidget(new QLabel("Variants per sample: "), 0, 0);
+	pAugmentBoxLayout->addWidget(m_pAugmentCountEdit, 0, 1);
+	pAugmentBoxLayout->addWidget(m_pKeepOriginalCheckBox, 0, 2, 1, 2);
+	pAugmentBoxLayout->addWidget(new QLabel("Seed: "), 0, 4);
+	pAugmentBoxLayout->addWidget(m_pAugmentSeedEdit, 0, 5);
+	pAugmentBoxLayout->addWidget(new QLabel("Rotation (+/- degree): "), 1, 0);
+	pAugmentBoxLayout->addWidget(m_pRotationEdit, 1, 1);
+	pAugmentBoxLayout->addWidget(new QLabel("Scale (+/-): "), 1, 2);
+	pAugmentBoxLayout->addWidget(m_pScaleEdit, 1, 3);
+	pAugmentBoxLayout->addWidget(new QLabel("Shear (+/-): "), 1, 4);
+	pAugmentBoxLayout->addWidget(m_pShearEdit, 1, 5);
+	pAugmentBoxLayout->addWidget(new QLabel("Shift (+/- side): "), 2, 0);
+	pAugmentBoxLayout->addWidget(m_pShiftEdit, 2, 1);
+	pAugmentBoxLayout->addWidget(new QLabel("Elastic alpha/sigma (side): "), 2, 2);
+	pAugmentBoxLayout->addWidget(m_pElasticAlphaEdit, 2, 3);
+	pAugmentBoxLayout->addWidget(m_pElasticSigmaEdit, 2, 4);
+	pAugmentBoxLayout->addWidget(new QLabel("Stroke width (+/- pixel): "), 3, 0);
+	pAugmentBoxLayout->addWidget(m_pStrokeChangeEdit, 3, 1);
+	m_pAugmentGroupBox->setLayout(pAugmentBoxLayout);
+
+	QPointer<QHBoxLayout> pProcessLayout = new QHBoxLayout;
+	pProcessLayout->addWidget(m_pSplitGroupBox);
+	pProcessLayout->addWidget(m_pPostProcessGroupBox);
+	pProcessLayout->addWidget(m_pOutputGroupBox);
+
 	// put the groupboxes together
     QPointer<QHBoxLayout> pButtonLayout = new QHBoxLayout;
 	pButtonLayout->addWidget(m_pApplicationGroupBox);
@@ -97,6 +241,8 @@ void QxDecodeOptionDlg::initDialog(const QStringList& fileList)
 	pLayout->addWidget(pFileListWidget);
 	pLayout->addLayout(pSavePathLayout);
 	pLayout->addLayout(pButtonLayout);
+	pLayout->addLayout(pProcessLayout);
+	pLayout->addWidget(m_pAugmentGroupBox);
 	pLayout->addLayout(pOptionLayout);
 	setLayout(pLayout);
 	setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint &~Qt::WindowCloseButtonHint);
@@ -113,11 +259,27 @@ void QxDecodeOptionDlg::initDialog(const QStringList& fileList)
     connect(m_pCNTK.data(), &QRadioButton::toggled, this, &QxDecodeOptionDlg::setImageFormatOption);
     connect(m_pDigits.data(), &QRadioButton::toggled, this, &QxDecodeOptionDlg::setImageFormatOption);
     connect(m_pTensorFlow.data(), &QRadioButton::toggled, this, &QxDecodeOptionDlg::setImageFormatOption);
+    connect(m_pPngFormat.data(), &QRadioButton::toggled, this, &QxDecodeOptionDlg::setPostProcessOption);
+    connect(m_pPngBitDepthComboBox.data(), static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &QxDecodeOptionDlg::setPostProcessOption);
+    connect(m_pNoSplit.data(), &QRadioButton::toggled, this, &QxDecodeOptionDlg::setSplitOption);
+    connect(m_pSplitBySample.data(), &QRadioButton::toggled, this, &QxDecodeOptionDlg::setSplitOption);
+    connect(m_pSplitByFile.data(), &QRadioButton::toggled, this, &QxDecodeOptionDlg::setSplitOption);
+    connect(m_pImageFilesOutput.data(), &QRadioButton::toggled, this, &QxDecodeOptionDlg::setPostProcessOption);
+    connect(m_pPackedOutput.data(), &QRadioButton::toggled, this, &QxDecodeOptionDlg::setPostProcessOption);
+    connect(m_pAtlasOutput.data(), &QRadioButton::toggled, this, &QxDecodeOptionDlg::setPostProcessOption);
+    connect(m_pShuffleCheckBox.data(), &QCheckBox::toggled, this, &QxDecodeOptionDlg::setPostProcessOption);
+    connect(m_pCacheCheckBox.data(), &QCheckBox::toggled, this, &QxDecodeOptionDlg::setPostProcessOption);
+    connect(m_pBinarizeComboBox.data(), static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &QxDecodeOptionDlg::setPostProcessOption);
+    connect(m_pNormalizeComboBox.data(), static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &QxDecodeOptionDlg::setPostProcessOption);
+    connect(m_pTensorTypeComboBox.data(), static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &QxDecodeOptionDlg::setPostProcessOption);
 
 	// default status
 	m_pCaffe->setChecked(true);
 	m_pPngFormat->setChecked(true);
 	m_pMedium->setChecked(true);
+	m_pNoSplit->setChecked(true);
+	m_pImageFilesOutput->setChecked(true);
+	setPostProcessOption();
 }
 
 void QxDecodeOptionDlg::setSaveFilePath()
@@ -162,6 +324,129 @@ void QxDecodeOptionDlg::accept()
 			return;
 		}
 	}
+	// Check extra image sizes
+	{
+		QStringList sizes = m_pExtraSizesEdit->text().split(',', QString::SkipEmptyParts);
+		for (QStringList::const_iterator itr = sizes.begin(); itr != sizes.end(); ++itr)
+		{
+			bool bOk = false;
+			quint32 uImageSize = itr->trimmed().toUInt(&bOk);
+			if (!bOk || !uImageSize)
+			{
+				QMessageBox::information(this, "Invalid image size", "Please input valid extra image sizes (positive integers separated by commas) !", QMessageBox::Ok);
+				return;
+			}
+		}
+	}
+	// Check stroke width
+	if (m_pStrokeWidthEdit->isEnabled())
+	{
+		bool bOk = false;
+		double dStrokeWidth = m_pStrokeWidthEdit->text().toDouble(&bOk);
+		if (!bOk || dStrokeWidth <= 0.0)
+		{
+			QMessageBox::information(this, "Invalid stroke width", "Please input a valid stroke width (positive number) !", QMessageBox::Ok);
+			return;
+		}
+	}
+	// Check split percentages and seed
+	if (!m_pNoSplit->isChecked())
+	{
+		bool bTrainOk = false;
+		bool bValidationOk = false;
+		bool bSeedOk = false;
+		quint32 uTrainPercent = m_pTrainPercentEdit->text().toUInt(&bTrainOk);
+		quint32 uValidationPercent = m_pValidationPercentEdit->text().toUInt(&bValidationOk);
+		m_pSplitSeedEdit->text().toULongLong(&bSeedOk);
+		if (!bTrainOk || !bValidationOk || uTrainPercent + uValidationPercent > 100)
+		{
+			QMessageBox::information(this, "Invalid split", "Train and validation percentages must be non-negative integers whose sum is at most 100!", QMessageBox::Ok);
+			return;
+		}
+		if (!bSeedOk)
+		{
+			QMessageBox::information(this, "Invalid seed", "Please input a valid seed (non-negative integer only) !", QMessageBox::Ok);
+			return;
+		}
+	}
+	// Check shuffle seed
+	if (m_pShuffleCheckBox->isChecked())
+	{
+		bool bSeedOk = false;
+		m_pShuffleSeedEdit->text().toULongLong(&bSeedOk);
+		if (!bSeedOk)
+		{
+			QMessageBox::information(this, "Invalid seed", "Please input a valid shuffle seed (non-negative integer only) !", QMessageBox::Ok);
+			return;
+		}
+	}
+	// Check cache size
+	if (m_pCacheSizeEdit->isEnabled())
+	{
+		bool bOk = false;
+		qint64 iCacheSize = m_pCacheSizeEdit->text().toLongLong(&bOk);
+		if (!bOk || iCacheSize <= 0)
+		{
+			QMessageBox::information(this, "Invalid cache size", "Please input a valid cache size (positive integer only) !", QMessageBox::Ok);
+			return;
+		}
+	}
+	// Check atlas sheet side
+	if (m_pAtlasSideEdit->isEnabled())
+	{
+		bool bOk = false;
+		int iAtlasSide = m_pAtlasSideEdit->text().toInt(&bOk);
+		if (!bOk || iAtlasSide <= 0)
+		{
+			QMessageBox::information(this, "Invalid sheet side", "Please input a valid atlas sheet side (positive integer only) !", QMessageBox::Ok);
+			return;
+		}
+	}
+	// Check augmentation parameters
+	{
+		bool bCountOk = false;
+		bool bStrokeOk = false;
+		bool bSeedOk = false;
+		int iAugmentCount = m_pAugmentCountEdit->text().toInt(&bCountOk);
+		int iStrokeChange = m_pStrokeChangeEdit->text().toInt(&bStrokeOk);
+		m_pAugmentSeedEdit->text().toULongLong(&bSeedOk);
+		bool bRangesOk = true;
+		QLineEdit* rangeEdits[] = { m_pRotationEdit, m_pScaleEdit, m_pShearEdit, m_pShiftEdit, m_pElasticAlphaEdit, m_pElasticSigmaEdit };
+		for (size_t i = 0; i != sizeof(rangeEdits) / sizeof(rangeEdits[0]); ++i)
+		{
+			bool bOk = false;
+			double dValue = rangeEdits[i]->text().toDouble(&bOk);
+			bRangesOk = bRangesOk && bOk && dValue >= 0.0;
+		}
+		if (!bCountOk || iAugmentCount < 0 || !bStrokeOk || iStrokeChange < 0 || !bSeedOk || !bRangesOk)
+		{
+			QMessageBox::information(this, "Invalid augmentation", "Please input valid augmentation parameters (non-negative numbers only) !", QMessageBox::Ok);
+			return;
+		}
+	}
+	// Check post-processing parameters
+	if (m_pThresholdEdit->isEnabled())
+	{
+		bool bOk = false;
+		int iThreshold = m_pThresholdEdit->text().toInt(&bOk);
+		if (!bOk || iThreshold < 0 || iThreshold > 255)
+		{
+			QMessageBox::information(this, "Invalid threshold", "Please input a valid threshold (integer from 0 to 255) !", QMessageBox::Ok);
+			return;
+		}
+	}
+	if (m_pMeanEdit->isEnabled())
+	{
+		bool bMeanOk = false;
+		bool bStdOk = false;
+		m_pMeanEdit->text().toDouble(&bMeanOk);
+		double dStd = m_pStdEdit->text().toDouble(&bStdOk);
+		if (!bMeanOk || !bStdOk || dStd <= 0.0)
+		{
+			QMessageBox::information(this, "Invalid mean/std", "Please input a valid mean and a positive standard deviation (of pixels scaled to [0, 1]) !", QMessageBox::Ok);
+			return;
+		}
+	}
 
 	QDialog::accept();
 }
@@ -272,3 +557,112 @@ QString QxDecodeOptionDlg::filePath() const
 {
 	return m_pFilePathEdit->text();
 }
+
+void QxDecodeOptionDlg::setSplitOption()
+{
+	bool bSplit = !m_pNoSplit->isChecked();
+	m_pTrainPercentEdit->setEnabled(bSplit);
+	m_pValidationPercentEdit->setEnabled(bSplit);
+	m_pSplitSeedEdit->setEnabled(bSplit);
+}
+
+void QxDecodeOptionDlg::setPostProcessOption()
+{
+	bool bPacked = m_pPackedOutput->isChecked();
+	bool bImageFiles = m_pImageFilesOutput->isChecked();
+	bool bFloat = bPacked && m_pTensorTypeComboBox->currentData().toInt() == QxDecodeSettings::Float32Tensor;
+	// Atlas sheets are images too, in the selected format.
+	m_pImageFormatGroupBox->setEnabled(!bPacked);
+	m_pTensorTypeComboBox->setEnabled(bPacked);
+	m_pAtlasSideEdit->setEnabled(m_pAtlasOutput->isChecked());
+	m_pFanOutComboBox->setEnabled(bImageFiles);
+	m_pPngBitDepthComboBox->setEnabled(m_pPngFormat->isChecked());
+	m_pCacheCheckBox->setEnabled(bImageFiles);
+	m_pCacheSizeEdit->setEnabled(bImageFiles && m_pCacheCheckBox->isChecked());
+	m_pShuffleSeedEdit->setEnabled(m_pShuffleCheckBox->isChecked());
+	// Normalization needs float outputs
+	m_pNormalizeComboBox->setEnabled(bFloat);
+	bool bMeanStd = bFloat && m_pNormalizeComboBox->currentData().toInt() == QxDecodeSettings::MeanStd;
+	m_pMeanEdit->setEnabled(bMeanStd);
+	m_pStdEdit->setEnabled(bMeanStd);
+	// The threshold is also the one of 1-bit PNG files.
+	bool bOneBitPng = !bPacked && m_pPngFormat->isChecked() && m_pPngBitDepthComboBox->currentData().toInt() == 1;
+	m_pThresholdEdit->setEnabled(bOneBitPng || m_pBinarizeComboBox->currentData().toInt() == QxDecodeSettings::GlobalThreshold);
+}
+
+QxDecodeSettings QxDecodeOptionDlg::settings() const
+{
+	QxDecodeSettings settings;
+	unsigned uImageSize = imageSize();
+	settings.strDestinationPath = filePath();
+	settings.imageFormat = imageFormat();
+	settings.iPngBitDepth = m_pPngBitDepthComboBox->currentData().toInt();
+	settings.imageSize = cv::Size(uImageSize, uImageSize);
+	QStringList extraSizes = m_pExtraSizesEdit->text().split(',', QString::SkipEmptyParts);
+	for (QStringList::const_iterator itr = extraSizes.begin(); itr != extraSizes.end(); ++itr)
+	{
+		settings.extraImageSides.append(itr->trimmed().toInt());
+	}
+	if (m_pStrokeWidthEdit->isEnabled())
+	{
+		settings.dStrokeWidth = m_pStrokeWidthEdit->text().toDouble();
+	}
+	settings.appType = application();
+
+	settings.splitMode = QxDecodeSettings::NoSplit;
+	if (m_pSplitBySample->isChecked())
+	{
+		settings.splitMode = QxDecodeSettings::SplitBySample;
+	}
+	else if (m_pSplitByFile->isChecked())
+	{
+		settings.splitMode = QxDecodeSettings::SplitByFile;
+	}
+	settings.uTrainPercent = m_pTrainPercentEdit->text().toUInt();
+	settings.uValidationPercent = m_pValidationPercentEdit->text().toUInt();
+	settings.uSplitSeed = m_pSplitSeedEdit->text().toULongLong();
+
+	settings.bInvert = m_pInvertCheckBox->isChecked();
+	settings.binarizeMode = QxDecodeSettings::BinarizeMode(m_pBinarizeComboBox->currentData().toInt());
+	settings.iThreshold = m_pThresholdEdit->text().toInt();
+	settings.normalizeMode = QxDecodeSettings::NormalizeMode(m_pNormalizeComboBox->currentData().toInt());
+	settings.dMean = m_pMeanEdit->text().toDouble();
+	settings.dStd = m_pStdEdit->text().toDouble();
+	settings.outputMode = QxDecodeSettings::ImageFiles;
+	if (m_pPackedOutput->isChecked())
+	{
+		settings.outputMode = QxDecodeSettings::PackedTensors;
+	}
+	else if (m_pAtlasOutput->isChecked())
+	{
+		settings.outputMode = QxDecodeSettings::AtlasSheets;
+	}
+	settings.iAtlasSide = m_pAtlasSideEdit->text().toInt();
+	settings.tensorType = QxDecodeSettings::TensorType(m_pTensorTypeComboBox->currentData().toInt());
+	settings.fanOutMode = QxDecodeSettings::FanOutMode(m_pFanOutComboBox->currentData().toInt());
+	if (m_pCacheSizeEdit->isEnabled())
+	{
+		// One cache per user, shared by all the decodings.
+		settings.strCachePath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/encoded_images";
+		settings.iCacheSizeLimit = m_pCacheSizeEdit->text().toLongLong() * 1024 * 1024;
+	}
+	settings.bShuffle = m_pShuffleCheckBox->isChecked();
+	settings.uShuffleSeed = m_pShuffleSeedEdit->text().toULongLong();
+	settings.iAugmentCount = m_pAugmentCountEdit->text().toInt();
+	settings.bKeepOriginal = m_pKeepOriginalCheckBox->isChecked();
+	settings.dMaxRotation = m_pRotationEdit->text().toDouble();
+	settings.dMaxScale = m_pScaleEdit->text().toDouble();
+	settings.dMaxShear = m_pShearEdit->text().toDouble();
+	settings.dMaxShift = m_pShiftEdit->text().toDouble();
+	settings.dElasticAlpha = m_pElasticAlphaEdit->text().toDouble();
+	settings.dElasticSigma = m_pElasticSigmaEdit->text().toDouble();
+	settings.iMaxStrokeChange = m_pStrokeChangeEdit->text().toInt();
+	settings.uAugmentSeed = m_pAugmentSeedEdit->text().toULongLong();
+	// 8-bit outputs can't hold normalized values
+	if (settings.outputMode != QxDecodeSettings::PackedTensors || settings.tensorType != QxDecodeSettings::Float32Tensor)
+	{
+		settings.normalizeMode = QxDecodeSettings::NoNormalization;
+	}
+
+	return settings;
+}
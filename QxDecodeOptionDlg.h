@@ -4,10 +4,13 @@
 #include <QDialog>
 #include <QPointer>
 
+class QCheckBox;
+class QComboBox;
 class QGroupBox;
 class QLineEdit;
 class QRadioButton;
 class QString;
+struct QxDecodeSettings;
 
 /*
 	Dialog allowing user to select image path, image format/size, and target software(Caffe, Digits) and so on.
@@ -27,6 +30,8 @@ public:
 	QString filePath() const;
 	// Selected/entered image size
 	unsigned int imageSize() const;
+	// All the selected options
+	QxDecodeSettings settings() const;
 
 private slots:
     // Re-implemented function, which ensures legal selections/inputs.
@@ -34,6 +39,8 @@ private slots:
     void setImageFormatOption();
     void setSaveFilePath();
     void setImageSize();
+    void setSplitOption();
+    void setPostProcessOption();
 
 private:
 	// Init the dialog
@@ -43,9 +50,43 @@ private:
 	QPointer<QGroupBox> m_pApplicationGroupBox;
 	QPointer<QGroupBox> m_pImageFormatGroupBox;
 	QPointer<QGroupBox> m_pImageSizeGroupBox;
+	QPointer<QGroupBox> m_pSplitGroupBox;
+	QPointer<QGroupBox> m_pPostProcessGroupBox;
+	QPointer<QGroupBox> m_pOutputGroupBox;
+	QPointer<QGroupBox> m_pAugmentGroupBox;
 
 	QPointer<QLineEdit> m_pFilePathEdit;
 	QPointer<QLineEdit> m_pImageSizeEdit;
+	QPointer<QLineEdit> m_pExtraSizesEdit;
+	QPointer<QLineEdit> m_pStrokeWidthEdit;
+	QPointer<QLineEdit> m_pTrainPercentEdit;
+	QPointer<QLineEdit> m_pValidationPercentEdit;
+	QPointer<QLineEdit> m_pSplitSeedEdit;
+	QPointer<QLineEdit> m_pShuffleSeedEdit;
+	QPointer<QLineEdit> m_pCacheSizeEdit;
+	QPointer<QLineEdit> m_pAtlasSideEdit;
+	QPointer<QLineEdit> m_pThresholdEdit;
+	QPointer<QLineEdit> m_pMeanEdit;
+	QPointer<QLineEdit> m_pStdEdit;
+	QPointer<QLineEdit> m_pAugmentCountEdit;
+	QPointer<QLineEdit> m_pRotationEdit;
+	QPointer<QLineEdit> m_pScaleEdit;
+	QPointer<QLineEdit> m_pShearEdit;
+	QPointer<QLineEdit> m_pShiftEdit;
+	QPointer<QLineEdit> m_pElasticAlphaEdit;
+	QPointer<QLineEdit> m_pElasticSigmaEdit;
+	QPointer<QLineEdit> m_pStrokeChangeEdit;
+	QPointer<QLineEdit> m_pAugmentSeedEdit;
+
+	QPointer<QCheckBox> m_pInvertCheckBox;
+	QPointer<QCheckBox> m_pKeepOriginalCheckBox;
+	QPointer<QCheckBox> m_pShuffleCheckBox;
+	QPointer<QCheckBox> m_pCacheCheckBox;
+	QPointer<QComboBox> m_pBinarizeComboBox;
+	QPointer<QComboBox> m_pNormalizeComboBox;
+	QPointer<QComboBox> m_pTensorTypeComboBox;
+	QPointer<QComboBox> m_pFanOutComboBox;
+	QPointer<QComboBox> m_pPngBitDepthComboBox;
 
 	QPointer<QRadioButton> m_pCaffe;
 	QPointer<QRadioButton> m_pCNTK;
@@ -61,6 +102,14 @@ private:
 	QPointer<QRadioButton> m_pMedium;
 	QPointer<QRadioButton> m_pLarge;
 	QPointer<QRadioButton> m_pCustomize;
+
+	QPointer<QRadioButton> m_pNoSplit;
+	QPointer<QRadioButton> m_pSplitBySample;
+	QPointer<QRadioButton> m_pSplitByFile;
+
+	QPointer<QRadioButton> m_pImageFilesOutput;
+	QPointer<QRadioButton> m_pPackedOutput;
+	QPointer<QRadioButton> m_pAtlasOutput;
 };
 
 #endif
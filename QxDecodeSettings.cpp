@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <functional>
+#include <string.h>
+
+#include <QFileInfo>
+
+#include "QxDecodeSettings.h"
+#include "QxHash.h"
+
+// Seed of the shard hash, so that the shards don't follow the sets of a split with the default seed.
+static const quint64 g_uShardSeed = Q_UINT64_C(0x5348415244);
+
+QxDecodeSettings::QxDecodeSettings()
+	: imageFormat("png")
+	, iPngBitDepth(8)
+	, imageSize(64, 64)
+	, dStrokeWidth(2.0)
+	, appType(QxDecodeOptionDlg::Caffe)
+	, splitMode(NoSplit)
+	, uTrainPercent(80)
+	, uValidationPercent(10)
+	, uSplitSeed(0)
+	, shardMode(ShardByFile)
+	, iShardIndex(0)
+	, iShardCount(1)
+	, bInvert(false)
+	, normalizeMode(NoNormalization)
+	, dMean(0.0)
+	, dStd(1.0)
+	, binarizeMode(NoBinarization)
+	, iThreshold(128)
+	, outputMode(ImageFiles)
+	, tensorType(UInt8Tensor)
+	, iAtlasSide(4096)
+	, fanOutMode(NoFanOut)
+	, iCacheSizeLimit(Q_INT64_C(4096) * 1024 * 1024)
+	, bShuffle(false)
+	, uShuffleSeed(0)
+	, iAugmentCount(0)
+	, bKeepOriginal(true)
+	, dMaxRotation(5.0)
+	, dMaxScale(0.1)
+	, dMaxShear(0.1)
+	, dMaxShift(0.05)
+	, dElasticAlpha(0.02)
+	, dElasticSigma(0.08)
+	, iMaxStrokeChange(1)
+	, uAugmentSeed(0)
+{
+}
+
+//Decide which set a sample belongs to, based on a seeded hash of its key.
+QxDecodeSettings::SplitSet QxDecodeSettings::splitSet(const QString& strFileName, quint64 uIndexInFile) const
+{
+	if (splitMode == NoSplit)
+	{
+		return TrainSet;
+	}
+
+	// Only the file key is used (e.g. "1001-c" for ".../1001-c.gnt"), thus the split doesn't depend on where the files are stored.
+	QByteArray key = fileKey(strFileName);
+	if (splitMode == SplitBySample)
+	{
+		key.append(':').append(QByteArray::number(uIndexInFile));
+	}
+	quint32 uBucket = quint32(qxHash64(key, uSplitSeed) % 100);
+	if (uBucket < uTrainPercent)
+	{
+		return TrainSet;
+	}
+	else if (uBucket < uTrainPercent + uValidationPercent)
+	{
+		return ValidationSet;
+	}
+	return TestSet;
+}
+
+//Name of a file without folder and known suffixes. Only those are removed: names like "1.0train-gb1.gnt" have other dots.
+QByteArray QxDecodeSettings::fileKey(const QString& strFileName)
+{
+	QString strKey = QFileInfo(strFileName).fileName();
+	const char* compressionSuffixes[] = { ".gz", ".zst" };
+	for (int i = 0; i != 2; ++i)
+	{
+		if (strKey.endsWith(compressionSuffixes[i], Qt::CaseInsensitive))
+		{
+			strKey.chop(int(strlen(compressionSuffixes[i])));
+			break;
+		}
+	}
+	const char* fileSuffixes[] = { ".gnt", ".pot", ".dgr" };
+	for (int i = 0; i != 3; ++i)
+	{
+		if (strKey.endsWith(fileSuffixes[i], Qt::CaseInsensitive))
+		{
+			strKey.chop(int(strlen(fileSuffixes[i])));
+			break;
+		}
+	}
+	return strKey.toUtf8();
+}
+
+//Name of a set, used for the label file and the image sub-folder.
+QString QxDecodeSettings::splitSetName(SplitSet set)
+{
+	switch (set)
+	{
+	case TrainSet:
+		return "train";
+	case ValidationSet:
+		return "val";
+	case TestSet:
+		return "test";
+	default:
+		return QString();
+	}
+}
+
+//imageSize and the extra sides, from the largest to the smallest, without duplicates.
+QList<int> QxDecodeSettings::imageSides() const
+{
+	QList<int> sides;
+	sides << imageSize.width;
+	for (QList<int>::const_iterator itr = extraImageSides.begin(); itr != extraImageSides.end(); ++itr)
+	{
+		if (!sides.contains(*itr))
+		{
+			sides << *itr;
+		}
+	}
+	std::sort(sides.begin(), sides.end(), std::greater<int>());
+	return sides;
+}
+
+//Whether a sample belongs to the shard decoded by this run.
+bool QxDecodeSettings::inShard(const QString& strFileName, quint64 uIndexInFile) const
+{
+	if (iShardCount <= 1)
+	{
+		return true;
+	}
+	QByteArray key = fileKey(strFileName);
+	if (shardMode == ShardBySample)
+	{
+		key.append(':').append(QByteArray::number(uIndexInFile));
+	}
+	return int(qxHash64(key, g_uShardSeed) % quint64(iShardCount)) == iShardIndex;
+}
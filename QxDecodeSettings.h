@@ -0,0 +1,116 @@
+#ifndef _QX_DECODE_SETTINGS_H_
+#define _QX_DECODE_SETTINGS_H_
+
+#include <opencv2/core/core.hpp>
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include "QxDecodeOptionDlg.h"
+
+/*
+	All the parameters of one decoding run, as selected in QxDecodeOptionDlg.
+*/
+struct QxDecodeSettings
+{
+	// How samples are distributed to train/validation/test sets.
+	enum SplitMode{ NoSplit, SplitBySample, SplitByFile };
+	enum SplitSet{ TrainSet, ValidationSet, TestSet, SplitSetCount };
+	// Per-sample post-processing, applied right after padding and resizing.
+	enum NormalizeMode{ NoNormalization, UnitRange, MeanStd };
+	enum BinarizeMode{ NoBinarization, GlobalThreshold, OtsuThreshold };
+	// Where the samples go: one image file per sample, a few packed tensor files (.npy) holding all of them,
+	// or large grid images (atlas sheets) holding thousands of samples each, with a manifest.
+	enum OutputMode{ ImageFiles, PackedTensors, AtlasSheets };
+	enum TensorType{ UInt8Tensor, Float32Tensor };
+	// How the samples are distributed over the shards of a decoding split over several runs (or machines).
+	enum ShardMode{ ShardByFile, ShardBySample };
+	// How the image files are spread over sub-folders, so that no folder holds millions of files:
+	// one or two levels of 256 folders picked by a hash of the image name, or one folder per tag code.
+	enum FanOutMode{ NoFanOut, HashFanOut, TwoLevelHashFanOut, TagCodeFanOut };
+
+	QxDecodeSettings();
+
+	// Decide which set a sample belongs to, based on a seeded hash of its key.
+	// The key is the name of the .gnt file (SplitByFile) or the file name plus the sample index inside the file (SplitBySample),
+	// so the same sample always ends up in the same set, no matter which or how many files are decoded together.
+	SplitSet splitSet(const QString& strFileName, quint64 uIndexInFile) const;
+	// Key of a file in the split, shard and augmentation hashes: its name without folder and without the known suffixes
+	// (.gnt, .pot or .dgr, then .gz or .zst), e.g. "1.0train-gb1" for ".../1.0train-gb1.gnt.gz".
+	static QByteArray fileKey(const QString& strFileName);
+	// Name of a set, used for the label file and the image sub-folder.
+	static QString splitSetName(SplitSet set);
+	// imageSize and the extra sides, from the largest to the smallest, without duplicates.
+	QList<int> imageSides() const;
+	// Whether a sample belongs to the shard decoded by this run. Like the split, it only depends on the file key
+	// (and the sample index when sharding by sample), so every run makes the same decision whatever files it is given.
+	bool inShard(const QString& strFileName, quint64 uIndexInFile) const;
+
+	QString strDestinationPath;
+	QString imageFormat;
+	// PNG only: 8 bits per pixel, or 4, 2 or 1 (see QxPngWriter). 1-bit images are thresholded at iThreshold,
+	// 2 and 4-bit images keep evenly spaced gray levels.
+	int iPngBitDepth;
+	cv::Size imageSize;
+	// More sides decoded in the same pass, e.g. 32 and 128 along with a 64 x 64 imageSize. Each size then gets its own
+	// output tree, a sub-folder named after the side, and the trees share the same labels.
+	QList<int> extraImageSides;
+	// Online (.pot) samples only: width of the rasterized strokes, in pixels of the largest side.
+	double dStrokeWidth;
+	QxDecodeOptionDlg::ApplicationType appType;
+
+	SplitMode splitMode;
+	// Percentage of samples in the training and the validation set, the remaining samples form the test set.
+	unsigned uTrainPercent;
+	unsigned uValidationPercent;
+	quint64 uSplitSeed;
+
+	// Decode only the shard iShardIndex (from 0) of iShardCount. Each shard has its own labels, see QxShardMerger.
+	ShardMode shardMode;
+	int iShardIndex;
+	int iShardCount;
+
+	// Invert the samples, so that ink is bright (255, or 1 after normalization) on a black background.
+	bool bInvert;
+	// Float32 tensors only: map pixels to [0,1], or to (pixel / 255 - dMean) / dStd with the dataset mean and standard deviation.
+	NormalizeMode normalizeMode;
+	double dMean;
+	double dStd;
+	// Pixels brighter than iThreshold (or than the Otsu threshold of each sample) become background, the others ink.
+	BinarizeMode binarizeMode;
+	int iThreshold;
+
+	OutputMode outputMode;
+	TensorType tensorType;
+	// Atlas sheets only: side of the square sheets in pixels, holding (iAtlasSide / image side)^2 samples each.
+	int iAtlasSide;
+	// Image files only, DIGITS already uses one folder per class.
+	FanOutMode fanOutMode;
+	// Image files only: reuse the images encoded by former decodings from this cache folder (no cache when empty),
+	// keeping at most iCacheSizeLimit bytes of images in it. See QxEncodedCache.
+	QString strCachePath;
+	qint64 iCacheSizeLimit;
+	// Write the label files and the packed tensors in a seeded random order instead of the file name order.
+	// The shuffle runs in bounded memory (see QxExternalShuffler), whatever the number of samples.
+	bool bShuffle;
+	quint64 uShuffleSeed;
+
+	// Number of augmented variants emitted per source sample, and whether the original sample is emitted too.
+	int iAugmentCount;
+	bool bKeepOriginal;
+	// Maximum random affine jitter: rotation in degrees, scale and shear factors, and shift as a fraction of the sample side.
+	double dMaxRotation;
+	double dMaxScale;
+	double dMaxShear;
+	double dMaxShift;
+	// Elastic distortion: standard deviation of the displacement and smoothness of the displacement field,
+	// both as a fraction of the sample side. No elastic distortion when dElasticAlpha is 0.
+	double dElasticAlpha;
+	double dElasticSigma;
+	// Maximum change of the stroke width, in pixels of the source sample.
+	int iMaxStrokeChange;
+	quint64 uAugmentSeed;
+};
+
+#endif
@@ -0,0 +1,1049 @@
+#include <string.h>
+
+#include <opencv2/highgui/highgui.hpp>
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include "QxAtlasWriter.h"
+#include "QxAugmenter.h"
+#include "QxDecoder.h"
+#include "QxDgrReader.h"
+#include "QxGntReader.h"
+#include "QxHash.h"
+#include "QxNpyWriter.h"
+#include "QxPngWriter.h"
+#include "QxPotReader.h"
+#include "QxSampleProcessor.h"
+#include "QxStrokeRasterizer.h"
+
+// Manage the directories.
+static QDir g_dirManager;
+// Create a sub-folder named "images" in the selected folder to save the decoded images.
+static const QString g_ImageFolderName = "images";
+// Use a .txt file named "image_labels.txt" to save path of images and corresponding labels.
+static const QString g_LabelFileName = "image_labels.txt";
+// When the samples are split, each set uses a .txt file named "<set>_labels.txt", e.g. "train_labels.txt".
+static const QString g_SplitLabelFileSuffix = "labels.txt";
+// Use a local file named "code_labels.txt" to save the mapping relationship between image labels and gbk code of Chinese characters.
+static const QString g_MappingFileName = "code_label.txt";
+// Packed outputs use a .npy file named "images.npy" for the samples and "labels.npy" for the labels (with a "<set>_" prefix when splitting).
+static const QString g_TensorFileName = "images.npy";
+static const QString g_TensorLabelFileName = "labels.npy";
+// Atlas outputs put the sheets in a sub-folder named "sheets" and list the samples in "sheets.txt" (with a "<set>_" prefix when splitting).
+static const QString g_SheetFolderName = "sheets";
+static const QString g_SheetManifestFileName = "sheets.txt";
+// Number of samples read before they are processed in parallel.
+static const int g_iBatchSize = 512;
+// Number of folders of each level of a hashed fan-out.
+static const int g_iFanOutWidth = 256;
+// Images are written under their name with this prefix, then renamed.
+static const QString g_TempImagePrefix = "~";
+
+//Write an image under a temporary name, then move it to its name. The file it replaces may be a hard link to an image
+//of the encoded cache, which must be replaced instead of written through.
+static bool writeImage(const QString& strFileName, const cv::Mat& image, const QxPngWriter* pPngWriter)
+{
+	QFileInfo fileInfo(strFileName);
+	// same extension, so that OpenCV picks the same encoder
+	const QString strTempFileName = fileInfo.path() + "/" + g_TempImagePrefix + fileInfo.fileName();
+	bool bWritten = pPngWriter ? pPngWriter->write(strTempFileName, image) : cv::imwrite(strTempFileName.toStdString(), image);
+	if (!bWritten)
+	{
+		QFile::remove(strTempFileName);
+		return false;
+	}
+	QFile::remove(strFileName);
+	if (!QFile::rename(strTempFileName, strFileName))
+	{
+		QFile::remove(strTempFileName);
+		return false;
+	}
+	return true;
+}
+
+// One output sample: a source sample (shared by all its variants) and where the result goes.
+struct QxDecodeJob
+{
+	const QxGntRecord* pRecord;
+	int iVariant;
+	quint64 uVariantSeed;
+	QxDecodeSettings::SplitSet set;
+	qint32 iLabel;
+	// image files only, one per image size
+	QStringList saveFileNames;
+	// packed tensors (or 8-bit atlas tiles) only, one per image size, filled by the worker
+	QVector<QByteArray> tensors;
+};
+
+// Process (and save) one sample on a worker thread, in all the image sizes.
+class QxDecodeWorker
+{
+public:
+	typedef void result_type;
+
+	QxDecodeWorker(const QxSampleProcessor& processor, const QList<int>& sides, QxDecodeSettings::OutputMode outputMode, QxEncodedCache* pCache, const QxPngWriter* pPngWriter)
+		: m_Processor(processor), m_Sides(sides), m_OutputMode(outputMode), m_pCache(pCache), m_pPngWriter(pPngWriter) {}
+
+	void operator()(QxDecodeJob& job) const
+	{
+		// Cached images only need to be linked to their new names, the sample is processed when any size is missing.
+		QVector<QByteArray> cacheKeys(m_pCache ? m_Sides.size() : 0);
+		bool bAllCached = (m_pCache != NULL);
+		for (int i = 0; i != cacheKeys.size(); ++i)
+		{
+			cacheKeys[i] = m_pCache->key(*job.pRecord, m_Sides.mid(0, i + 1), job.iVariant, job.uVariantSeed);
+			if (m_pCache->fetch(cacheKeys[i], job.saveFileNames.at(i)))
+			{
+				cacheKeys[i].clear();
+			}
+			else
+			{
+				bAllCached = false;
+			}
+		}
+		if (bAllCached)
+		{
+			return;
+		}
+
+		QVector<cv::Mat> images;
+		m_Processor.process(*job.pRecord, job.iVariant, job.uVariantSeed, m_Sides, images);
+		if (m_OutputMode == QxDecodeSettings::PackedTensors)
+		{
+			job.tensors.resize(images.size());
+			for (int i = 0; i != images.size(); ++i)
+			{
+				job.tensors[i].resize(int(m_Processor.tensorByteSize(m_Sides.at(i))));
+				m_Processor.toTensor(images[i], job.tensors[i].data());
+			}
+			return;
+		}
+		if (m_OutputMode == QxDecodeSettings::AtlasSheets)
+		{
+			// The tiles are copied into the sheets in sample order by the decoding thread.
+			job.tensors.resize(images.size());
+			for (int i = 0; i != images.size(); ++i)
+			{
+				const cv::Mat tile = images[i].isContinuous() ? images[i] : images[i].clone();
+				job.tensors[i] = QByteArray(reinterpret_cast<const char*>(tile.data), int(tile.total()));
+			}
+			return;
+		}
+		for (int i = 0; i != images.size(); ++i)
+		{
+			if (m_pCache && cacheKeys[i].isEmpty())
+			{
+				continue;
+			}
+			bool bWritten = writeImage(job.saveFileNames.at(i), images[i], m_pPngWriter);
+			if (bWritten && m_pCache)
+			{
+				m_pCache->store(cacheKeys[i], job.saveFileNames.at(i));
+			}
+		}
+	}
+
+private:
+	const QxSampleProcessor& m_Processor;
+	// from the largest to the smallest
+	QList<int> m_Sides;
+	QxDecodeSettings::OutputMode m_OutputMode;
+	// image files only, NULL without cache
+	QxEncodedCache* m_pCache;
+	// low bit depth PNG files only, NULL otherwise
+	const QxPngWriter* m_pPngWriter;
+};
+
+// One online sample to rasterize, and the record it becomes.
+struct QxRasterJob
+{
+	const QxPotSample* pSample;
+	QxGntRecord* pRecord;
+};
+
+// Rasterize one online sample on a worker thread.
+class QxRasterWorker
+{
+public:
+	typedef void result_type;
+
+	explicit QxRasterWorker(const QxStrokeRasterizer& rasterizer)
+		: m_Rasterizer(rasterizer) {}
+
+	void operator()(const QxRasterJob& job) const
+	{
+		m_Rasterizer.rasterize(*job.pSample, *job.pRecord);
+	}
+
+private:
+	const QxStrokeRasterizer& m_Rasterizer;
+};
+
+// One page of a .dgr file, and the records its characters go to.
+struct QxPageJob
+{
+	int iPage;
+	QxGntRecord* pRecords;
+};
+
+// Extract the characters of one page on a worker thread.
+class QxPageWorker
+{
+public:
+	typedef void result_type;
+
+	explicit QxPageWorker(const QxDgrReader& reader)
+		: m_Reader(reader) {}
+
+	void operator()(const QxPageJob& job) const
+	{
+		m_Reader.readPage(job.iPage, job.pRecords);
+	}
+
+private:
+	const QxDgrReader& m_Reader;
+};
+
+QxDecoder::QxDecoder()
+	: m_iSizeCount(0)
+	, m_pSampleStore(NULL)
+{
+}
+
+QxDecoder::~QxDecoder()
+{
+}
+
+//Name of the file holding the mapping between tag codes and labels.
+QString QxDecoder::mappingFileName()
+{
+	return g_MappingFileName;
+}
+
+//Name of the label file of a set.
+QString QxDecoder::labelFileName(QxDecodeSettings::SplitMode splitMode, QxDecodeSettings::SplitSet set)
+{
+	if (splitMode == QxDecodeSettings::NoSplit)
+	{
+		return g_LabelFileName;
+	}
+	return QxDecodeSettings::splitSetName(set) + "_" + g_SplitLabelFileSuffix;
+}
+
+//Name of the atlas manifest of a set.
+QString QxDecoder::manifestFileName(QxDecodeSettings::SplitMode splitMode, QxDecodeSettings::SplitSet set)
+{
+	if (splitMode == QxDecodeSettings::NoSplit)
+	{
+		return g_SheetManifestFileName;
+	}
+	return QxDecodeSettings::splitSetName(set) + "_" + g_SheetManifestFileName;
+}
+
+//Name of the packed tensors of a set.
+QString QxDecoder::tensorFileName(QxDecodeSettings::SplitMode splitMode, QxDecodeSettings::SplitSet set)
+{
+	if (splitMode == QxDecodeSettings::NoSplit)
+	{
+		return g_TensorFileName;
+	}
+	return QxDecodeSettings::splitSetName(set) + "_" + g_TensorFileName;
+}
+
+//Name of the packed labels of a set.
+QString QxDecoder::tensorLabelFileName(QxDecodeSettings::SplitMode splitMode, QxDecodeSettings::SplitSet set)
+{
+	if (splitMode == QxDecodeSettings::NoSplit)
+	{
+		return g_TensorLabelFileName;
+	}
+	return QxDecodeSettings::splitSetName(set) + "_" + g_TensorLabelFileName;
+}
+
+//Read the files through a sample store, or straight from disk when pStore is NULL.
+void QxDecoder::setSampleStore(QxSampleStore* pStore)
+{
+	m_pSampleStore = pStore;
+}
+
+//Number of images of the last decoding linked (or copied) from the cache instead of being encoded.
+int QxDecoder::cachedImageCount() const
+{
+	return m_EncodedCache.hitCount();
+}
+
+//Ask a yes/no question. The default implementation prints it and returns bDefault.
+bool QxDecoder::confirm(const QString& strTitle, const QString& strMessage, bool bDefault)
+{
+	QTextStream(stderr) << strTitle << ": " << strMessage << (bDefault ? " Yes" : " No") << "\n";
+	return bDefault;
+}
+
+//Report an error. The default implementation prints it.
+void QxDecoder::reportError(const QString& strTitle, const QString& strMessage)
+{
+	QTextStream(stderr) << strTitle << ": " << strMessage << "\n";
+}
+
+//Called before each file and regularly while decoding it. Return false to cancel.
+bool QxDecoder::reportProgress(int /*iDone*/, int /*iTotal*/)
+{
+	return true;
+}
+
+//Decoded .gnt files based on the parameters. Return true when successfully decoding the files.
+bool QxDecoder::decodeFiles(const QStringList& fileList, const QxDecodeSettings& settings)
+{
+	// Each image size gets an output tree: the selected folder itself, or a sub-folder named after the side (e.g. "64")
+	// when several sizes are decoded at once.
+	const QString& strDestinationPath = settings.strDestinationPath;
+	const bool bPacked = (settings.outputMode == QxDecodeSettings::PackedTensors);
+	const bool bAtlas = (settings.outputMode == QxDecodeSettings::AtlasSheets);
+	const bool bImageFiles = (settings.outputMode == QxDecodeSettings::ImageFiles);
+	const QList<int> sides = settings.imageSides();
+	if (sides.size() > MaxImageSizeCount)
+	{
+		reportError("Too many image sizes", QString("At most %1 image sizes can be decoded at once.").arg(MaxImageSizeCount));
+		return false;
+	}
+	m_iSizeCount = sides.size();
+	for (int iSize = 0; iSize != m_iSizeCount; ++iSize)
+	{
+		m_SizeOutputs[iSize].iSide = sides.at(iSize);
+		m_SizeOutputs[iSize].strDestinationPath = strDestinationPath;
+		if (m_iSizeCount > 1)
+		{
+			m_SizeOutputs[iSize].strDestinationPath += "/" + QString::number(sides.at(iSize));
+			g_dirManager.mkpath(m_SizeOutputs[iSize].strDestinationPath);
+		}
+	}
+
+	// Create a sub-folder in the selected folder to save the decoded images.
+	// If the folder already exists, ask user whether to append decoded images to it.
+	bool bImageFolderExists = false;
+	for (int iSize = 0; iSize != m_iSizeCount && bImageFiles; ++iSize)
+	{
+		QString strImagePath = m_SizeOutputs[iSize].strDestinationPath + "/" + g_ImageFolderName;
+		if (!g_dirManager.exists(strImagePath))
+		{
+			g_dirManager.mkdir(strImagePath);
+		}
+		else
+		{
+			bImageFolderExists = true;
+		}
+	}
+	if (bImageFolderExists)
+	{
+		QString strTitle("Folder already exists");
+		QString strMessage;
+		strMessage.append("There is already a floder named \"").append(g_ImageFolderName).append("\" in the selected folder.\n");
+		strMessage.append("Do you still want to save the decoded images to it?");
+		if (!confirm(strTitle, strMessage, true)) { return false; }
+	}
+	// When splitting, each set gets its own sub-folder, e.g. "images/train".
+	for (int iSize = 0; iSize != m_iSizeCount; ++iSize)
+	{
+		for (int iSet = 0; iSet != QxDecodeSettings::SplitSetCount; ++iSet)
+		{
+			QString& strSetImagePath = m_SizeOutputs[iSize].strSetImagePath[iSet];
+			strSetImagePath = m_SizeOutputs[iSize].strDestinationPath + "/" + g_ImageFolderName;
+			if (settings.splitMode != QxDecodeSettings::NoSplit && bImageFiles)
+			{
+				strSetImagePath += "/" + QxDecodeSettings::splitSetName(QxDecodeSettings::SplitSet(iSet));
+				g_dirManager.mkpath(strSetImagePath);
+			}
+		}
+	}
+	// DIGITS keeps its own layout: one folder per class.
+	const QxDecodeSettings::FanOutMode fanOutMode = (!bImageFiles || settings.appType == QxDecodeOptionDlg::DIGITS) ? QxDecodeSettings::NoFanOut : settings.fanOutMode;
+	int iImageSetCount = (settings.splitMode == QxDecodeSettings::NoSplit) ? 1 : int(QxDecodeSettings::SplitSetCount);
+	for (int iSize = 0; iSize != m_iSizeCount && (fanOutMode == QxDecodeSettings::HashFanOut || fanOutMode == QxDecodeSettings::TwoLevelHashFanOut); ++iSize)
+	{
+		for (int iSet = 0; iSet != iImageSetCount; ++iSet)
+		{
+			if (!createFanOutFolders(m_SizeOutputs[iSize].strSetImagePath[iSet], fanOutMode))
+			{
+				QString strMessage("Can not create the image folders in the selected folder:\n");
+				strMessage.append(m_SizeOutputs[iSize].strSetImagePath[iSet]);
+				reportError("Create folder error", strMessage);
+				return false;
+			}
+		}
+	}
+
+	// Packed output: "images.npy" and "labels.npy", or "<set>_images.npy" and "<set>_labels.npy" for each set, in each output tree.
+	// The writers update the sample count in the file headers when they are destroyed, whatever way this function returns.
+	QxNpyWriter tensorWriter[MaxImageSizeCount][QxDecodeSettings::SplitSetCount];
+	QxNpyWriter labelWriter[MaxImageSizeCount][QxDecodeSettings::SplitSetCount];
+	if (bPacked)
+	{
+		QxNpyWriter::ElementType elementType = (settings.tensorType == QxDecodeSettings::Float32Tensor) ? QxNpyWriter::Float32 : QxNpyWriter::UInt8;
+		int iSetCount = (settings.splitMode == QxDecodeSettings::NoSplit) ? 1 : int(QxDecodeSettings::SplitSetCount);
+		for (int iSize = 0; iSize != m_iSizeCount; ++iSize)
+		{
+			QList<int> sampleShape;
+			sampleShape << sides.at(iSize) << sides.at(iSize);
+			for (int iSet = 0; iSet != iSetCount; ++iSet)
+			{
+				const QString strPrefix = m_SizeOutputs[iSize].strDestinationPath + "/";
+				const QxDecodeSettings::SplitSet set = QxDecodeSettings::SplitSet(iSet);
+				if (!tensorWriter[iSize][iSet].open(strPrefix + tensorFileName(settings.splitMode, set), elementType, sampleShape)
+					|| !labelWriter[iSize][iSet].open(strPrefix + tensorLabelFileName(settings.splitMode, set), QxNpyWriter::Int32, QList<int>()))
+				{
+					QString strMessage("Can not create tensor files in the selected folder:\n");
+					strMessage.append(m_SizeOutputs[iSize].strDestinationPath);
+					strMessage.append("\nMaybe you do not have permission to create a new file in the selected folder?");
+					reportError("Open file error", strMessage);
+					return false;
+				}
+			}
+		}
+	}
+	// OpenCV only writes 8-bit PNG files.
+	QxPngWriter pngWriter(settings.iPngBitDepth, settings.iThreshold);
+	const bool bLowBitPng = !bPacked && settings.imageFormat == "png" && settings.iPngBitDepth < 8;
+	// Atlas output: "sheets/00000.png"... and "sheets.txt", or "sheets/<set>_00000.png"... and "<set>_sheets.txt" for each set, in each output tree.
+	// The writers write their last sheet when they are destroyed, whatever way this function returns.
+	QxAtlasWriter atlasWriter[MaxImageSizeCount][QxDecodeSettings::SplitSetCount];
+	if (bAtlas)
+	{
+		int iSetCount = (settings.splitMode == QxDecodeSettings::NoSplit) ? 1 : int(QxDecodeSettings::SplitSetCount);
+		for (int iSize = 0; iSize != m_iSizeCount; ++iSize)
+		{
+			QString strSheetPath = m_SizeOutputs[iSize].strDestinationPath + "/" + g_SheetFolderName;
+			g_dirManager.mkpath(strSheetPath);
+			for (int iSet = 0; iSet != iSetCount; ++iSet)
+			{
+				QString strSetPrefix;
+				if (settings.splitMode != QxDecodeSettings::NoSplit)
+				{
+					strSetPrefix = QxDecodeSettings::splitSetName(QxDecodeSettings::SplitSet(iSet)) + "_";
+				}
+				if (!atlasWriter[iSize][iSet].open(strSheetPath + "/" + strSetPrefix, settings.imageFormat, bLowBitPng ? &pngWriter : NULL,
+					sides.at(iSize), settings.iAtlasSide, settings.bInvert ? 0 : 255,
+					m_SizeOutputs[iSize].strDestinationPath + "/" + manifestFileName(settings.splitMode, QxDecodeSettings::SplitSet(iSet))))
+				{
+					QString strMessage("Can not create atlas files in the selected folder:\n");
+					strMessage.append(atlasWriter[iSize][iSet].errorString());
+					reportError("Open file error", strMessage);
+					return false;
+				}
+			}
+		}
+	}
+	// Shuffled outputs go through bounded-memory bucket shufflers, with their temporary files in the selected folder.
+	// The label lines of a sample for all the output trees are shuffled as one record, so the trees get the same order.
+	// Packed and atlas samples (the tensors of all the sizes and the label) are shuffled here and written at the end,
+	// so cancelled shuffled packed or atlas outputs hold no sample.
+	QxExternalShuffler tensorShuffler[QxDecodeSettings::SplitSetCount];
+	for (int iSet = 0; iSet != QxDecodeSettings::SplitSetCount; ++iSet)
+	{
+		bool bOpened = true;
+		m_LabelShufflers[iSet].close();
+		if (settings.bShuffle && bImageFiles)
+		{
+			bOpened = m_LabelShufflers[iSet].open(strDestinationPath, settings.uShuffleSeed + iSet);
+		}
+		else if (settings.bShuffle)
+		{
+			bOpened = tensorShuffler[iSet].open(strDestinationPath, settings.uShuffleSeed + iSet);
+		}
+		if (!bOpened)
+		{
+			QString strMessage("Can not create temporary files for shuffling in the selected folder:\n");
+			strMessage.append(strDestinationPath);
+			reportError("Open file error", strMessage);
+			return false;
+		}
+	}
+	// Encoded images are reused across decodings with the same image settings, whatever the application and labels.
+	m_EncodedCache.close();
+	if (bImageFiles && !settings.strCachePath.isEmpty() && !m_EncodedCache.open(settings.strCachePath, settings, settings.iCacheSizeLimit))
+	{
+		QString strMessage("Can not open the image cache, the images will all be encoded:\n");
+		strMessage.append(m_EncodedCache.errorString());
+		reportError("Cache error", strMessage);
+	}
+	QxEncodedCache* pCache = m_EncodedCache.isOpen() ? &m_EncodedCache : NULL;
+	QxSampleProcessor processor(settings);
+	// Variant 0 is the original sample, variants 1 to iAugmentCount are augmented.
+	const int iFirstVariant = (settings.iAugmentCount > 0 && !settings.bKeepOriginal) ? 1 : 0;
+	QVector<QxGntRecord> records(g_iBatchSize);
+	QVector<QxDecodeJob> jobs;
+	// Online samples are rasterized to the largest side, so that they are barely resized.
+	QxStrokeRasterizer rasterizer(sides.first(), settings.dStrokeWidth);
+	QVector<QxPotSample> potSamples(g_iBatchSize);
+	QVector<QxRasterJob> rasterJobs;
+	QVector<QxPageJob> pageJobs;
+
+	// Remove former information, just in case the user does twice or more times decoding without restart the software.
+	m_LabelCodeMap.clear();
+	m_DigitsImageCountMap.clear();
+	for (int iSize = 0; iSize != MaxImageSizeCount; ++iSize)
+	{
+		for (int iSet = 0; iSet != QxDecodeSettings::SplitSetCount; ++iSet)
+		{
+			m_SizeOutputs[iSize].imageLabelMap[iSet].clear();
+		}
+	}
+
+	// decode files
+	QStringList::size_type uFileAmount = fileList.size();
+	quint64 uTempIndex = 0;
+	for (QStringList::size_type i = 0; i != fileList.size(); ++i)
+	{
+		//Update progress dialog
+		if (!reportProgress(i, uFileAmount))
+		{
+			saveMappingFiles(settings.appType);
+			saveLabelFiles(settings);
+			return false;
+		}
+
+		//Files of other shards are not even opened when sharding by file.
+		QString strFileName = fileList.at(i);
+		if (settings.shardMode == QxDecodeSettings::ShardByFile && !settings.inShard(strFileName, 0))
+		{
+			continue;
+		}
+
+		//Error handling
+		QxGntReader reader;
+		QxPotReader potReader;
+		QxDgrReader dgrReader;
+		const bool bPot = QxPotReader::isPotFile(strFileName);
+		const bool bDgr = QxDgrReader::isDgrFile(strFileName);
+		if (bPot ? !potReader.open(strFileName) : bDgr ? !dgrReader.open(strFileName) : !reader.open(strFileName, m_pSampleStore))
+		{
+			QString strTitle("Open file error");
+			QString strErrorMessage = "Cannot open selected file:\nFile name: " + strFileName + "\nContinue decoding the remaining files? ";
+			if (confirm(strTitle, strErrorMessage, true)) { continue; }
+			else { return false; }
+		}
+
+		//Decode .gnt (or .pot, .dgr) file specified by strFileName, one batch of samples at a time.
+		//Samples are labeled and named here in file order, so the results don't depend on the number of threads,
+		//then processed and saved on the worker pool, and finally appended to the packed outputs in the same order.
+		bool bEndOfFile = false;
+		int iPage = 0;
+		while (!bEndOfFile)
+		{
+			int iRecordCount = 0;
+			if (bDgr)
+			{
+				// Whole pages go in a batch, at least one even when it has more characters than a batch.
+				// The characters are extracted from the mapped file on the worker pool, one page per job.
+				pageJobs.clear();
+				while (iPage != dgrReader.pageCount()
+					&& (pageJobs.isEmpty() || iRecordCount + dgrReader.page(iPage).uCharacterCount <= quint32(g_iBatchSize)))
+				{
+					const int iPageCharacterCount = int(dgrReader.page(iPage).uCharacterCount);
+					if (records.size() < iRecordCount + iPageCharacterCount)
+					{
+						records.resize(iRecordCount + iPageCharacterCount);
+					}
+					QxPageJob pageJob = { iPage, records.data() + iRecordCount };
+					pageJobs.append(pageJob);
+					iRecordCount += iPageCharacterCount;
+					++iPage;
+				}
+				QtConcurrent::blockingMap(pageJobs, QxPageWorker(dgrReader));
+			}
+			else if (bPot)
+			{
+				// The strokes are read here and rasterized on the worker pool, only for the samples of this shard.
+				rasterJobs.clear();
+				while (iRecordCount != g_iBatchSize && potReader.readSample(potSamples[iRecordCount]))
+				{
+					QxGntRecord& record = records[iRecordCount];
+					record.uIndex = potSamples[iRecordCount].uIndex;
+					if (settings.inShard(strFileName, record.uIndex))
+					{
+						QxRasterJob rasterJob = { &potSamples[iRecordCount], &record };
+						rasterJobs.append(rasterJob);
+					}
+					++iRecordCount;
+				}
+				QtConcurrent::blockingMap(rasterJobs, QxRasterWorker(rasterizer));
+			}
+			else
+			{
+				while (iRecordCount != g_iBatchSize && reader.readRecord(records[iRecordCount]))
+				{
+					++iRecordCount;
+				}
+			}
+			bEndOfFile = bDgr ? (iPage == dgrReader.pageCount()) : (iRecordCount != g_iBatchSize);
+
+			jobs.clear();
+			for (int r = 0; r != iRecordCount; ++r)
+			{
+				const QxGntRecord& record = records[r];
+				if (!settings.inShard(strFileName, record.uIndex))
+				{
+					continue;
+				}
+				quint32 uTagCode = record.uTagCode;
+				// update mapping table, because label of the input images should, optimally, start from 0 and be consecutive.
+				if (!m_LabelCodeMap.contains(uTagCode))
+				{
+					quint32 uNewLabel = m_LabelCodeMap.size();
+					m_LabelCodeMap[uTagCode] = uNewLabel;
+					// The class folders are created here, when the class is first met, and never by the workers.
+					for (int iSize = 0; iSize != m_iSizeCount && fanOutMode == QxDecodeSettings::TagCodeFanOut; ++iSize)
+					{
+						for (int iSet = 0; iSet != iImageSetCount; ++iSet)
+						{
+							g_dirManager.mkpath(m_SizeOutputs[iSize].strSetImagePath[iSet] + fanOutFolder(QString(), uTagCode, fanOutMode));
+						}
+					}
+				}
+				// The set is decided by the hash of the writer (file) or of the sample, so that all the sets are written in this single pass.
+				// Augmented variants stay in the set of their source sample.
+				QxDecodeSettings::SplitSet set = settings.splitSet(strFileName, record.uIndex);
+				for (int iVariant = iFirstVariant; iVariant <= settings.iAugmentCount; ++iVariant)
+				{
+					QxDecodeJob job;
+					job.pRecord = &record;
+					job.iVariant = iVariant;
+					job.uVariantSeed = iVariant ? QxAugmenter::variantSeed(settings.uAugmentSeed, strFileName, record.uIndex, iVariant) : 0;
+					job.set = set;
+					job.iLabel = m_LabelCodeMap[uTagCode];
+					if (bImageFiles)
+					{
+						// For 1.0train-gb1.gnt, it's a single file containing a lot samples, i+i is not correct index for image names
+						// Temporary solution on 8th May, to update
+						++uTempIndex;
+						for (int iSize = 0; iSize != m_iSizeCount; ++iSize)
+						{
+							job.saveFileNames.append(getSaveImageName(m_SizeOutputs[iSize].strSetImagePath[set], uTagCode, uTempIndex, settings) + "." + settings.imageFormat);
+						}
+					}
+					jobs.append(job);
+				}
+			}
+
+			// padding, augmentation, resizing to every size, post-processing and image saving
+			QtConcurrent::blockingMap(jobs, QxDecodeWorker(processor, sides, settings.outputMode, pCache, (bImageFiles && bLowBitPng) ? &pngWriter : NULL));
+			if (pCache)
+			{
+				// other processes sharing the cache see the images stored so far
+				pCache->sync();
+			}
+
+			for (QVector<QxDecodeJob>::const_iterator itr = jobs.begin(); itr != jobs.end(); ++itr)
+			{
+				bool bWritten = true;
+				QString strError;
+				if (bImageFiles && settings.bShuffle)
+				{
+					// the label line of each size, one per line
+					QByteArray lines;
+					for (int iSize = 0; iSize != m_iSizeCount; ++iSize)
+					{
+						lines.append(getLabelInfo(itr->saveFileNames.at(iSize), itr->iLabel, settings.appType).toUtf8()).append('\n');
+					}
+					bWritten = m_LabelShufflers[itr->set].append(lines);
+					strError = m_LabelShufflers[itr->set].errorString();
+				}
+				for (int iSize = 0; iSize != m_iSizeCount && bImageFiles && !settings.bShuffle; ++iSize)
+				{
+					m_SizeOutputs[iSize].imageLabelMap[itr->set][itr->saveFileNames.at(iSize)] = itr->iLabel;
+				}
+				if (!bImageFiles && settings.bShuffle)
+				{
+					// the tensors of all the sizes followed by the label
+					QByteArray sample;
+					for (int iSize = 0; iSize != m_iSizeCount; ++iSize)
+					{
+						sample.append(itr->tensors.at(iSize));
+					}
+					sample.append(reinterpret_cast<const char*>(&itr->iLabel), sizeof(itr->iLabel));
+					bWritten = tensorShuffler[itr->set].append(sample);
+					strError = tensorShuffler[itr->set].errorString();
+				}
+				else if (bPacked)
+				{
+					for (int iSize = 0; iSize != m_iSizeCount && bWritten; ++iSize)
+					{
+						bWritten = tensorWriter[iSize][itr->set].append(itr->tensors.at(iSize).constData()) && labelWriter[iSize][itr->set].append(&itr->iLabel);
+						strError = tensorWriter[iSize][itr->set].errorString();
+					}
+				}
+				else if (bAtlas)
+				{
+					for (int iSize = 0; iSize != m_iSizeCount && bWritten; ++iSize)
+					{
+						bWritten = atlasWriter[iSize][itr->set].append(reinterpret_cast<const uchar*>(itr->tensors.at(iSize).constData()), itr->iLabel);
+						strError = atlasWriter[iSize][itr->set].errorString();
+					}
+				}
+				if (!bWritten)
+				{
+					QString strMessage("Can not write output file:\n");
+					strMessage.append(strError);
+					reportError("Write file error", strMessage);
+					saveMappingFiles(settings.appType);
+					return false;
+				}
+			}
+
+			// Keep the window responsive while decoding large files.
+			if (!reportProgress(i, uFileAmount))
+			{
+				saveMappingFiles(settings.appType);
+				saveLabelFiles(settings);
+				return false;
+			}
+		}
+		reader.close();
+		potReader.close();
+		if (bDgr)
+		{
+			// The bitmaps are views on the mapped file, they must not outlive it.
+			for (QVector<QxGntRecord>::iterator itr = records.begin(); itr != records.end(); ++itr)
+			{
+				itr->bitmap.clear();
+			}
+		}
+		dgrReader.close();
+
+		// Corrupt or truncated file (or broken compressed stream).
+		if (reader.hasError() || potReader.hasError() || dgrReader.hasError())
+		{
+			QString strTitle("Read file error");
+			QString strReadError = bPot ? potReader.errorString() : bDgr ? dgrReader.errorString() : reader.errorString();
+			QString strErrorMessage = "Error while reading file:\nFile name: " + strFileName + "\n" + strReadError + "\nContinue decoding the remaining files? ";
+			if (!confirm(strTitle, strErrorMessage, true))
+			{
+				saveMappingFiles(settings.appType);
+				saveLabelFiles(settings);
+				return false;
+			}
+		}
+	}
+	// Write the shuffled packed or atlas samples, one bucket of the shuffler at a time.
+	if (!bImageFiles && settings.bShuffle)
+	{
+		for (int iSet = 0; iSet != QxDecodeSettings::SplitSetCount; ++iSet)
+		{
+			QByteArray sample;
+			quint64 uSampleCount = 0;
+			bool bWritten = true;
+			QString strError;
+			while (bWritten && tensorShuffler[iSet].readRecord(sample))
+			{
+				// The label follows the tensors of all the sizes.
+				const char* pLabel = sample.constData() + sample.size() - sizeof(qint32);
+				int iOffset = 0;
+				for (int iSize = 0; iSize != m_iSizeCount && bWritten; ++iSize)
+				{
+					const int iSide = sides.at(iSize);
+					if (bAtlas)
+					{
+						qint32 iLabel;
+						memcpy(&iLabel, pLabel, sizeof(iLabel));
+						bWritten = atlasWriter[iSize][iSet].append(reinterpret_cast<const uchar*>(sample.constData()) + iOffset, iLabel);
+						strError = atlasWriter[iSize][iSet].errorString();
+						iOffset += iSide * iSide;
+					}
+					else
+					{
+						bWritten = tensorWriter[iSize][iSet].append(sample.constData() + iOffset) && labelWriter[iSize][iSet].append(pLabel);
+						strError = tensorWriter[iSize][iSet].errorString();
+						iOffset += int(processor.tensorByteSize(iSide));
+					}
+				}
+				if (++uSampleCount % g_iBatchSize == 0)
+				{
+					reportProgress(uFileAmount, uFileAmount);
+				}
+			}
+			if (!bWritten || tensorShuffler[iSet].hasError())
+			{
+				QString strMessage("Can not write output file:\n");
+				strMessage.append(bWritten ? tensorShuffler[iSet].errorString() : strError);
+				reportError("Write file error", strMessage);
+				saveMappingFiles(settings.appType);
+				return false;
+			}
+		}
+	}
+
+	// The last sheets are written (and all the sheets encoded) before the decoding is reported done.
+	for (int iSize = 0; iSize != m_iSizeCount && bAtlas; ++iSize)
+	{
+		for (int iSet = 0; iSet != QxDecodeSettings::SplitSetCount; ++iSet)
+		{
+			if (!atlasWriter[iSize][iSet].close())
+			{
+				QString strMessage("Can not write output file:\n");
+				strMessage.append(atlasWriter[iSize][iSet].errorString());
+				reportError("Write file error", strMessage);
+				saveMappingFiles(settings.appType);
+				return false;
+			}
+		}
+	}
+
+	// Save the .txt files for different software
+	saveMappingFiles(settings.appType);
+	saveLabelFiles(settings);
+	m_EncodedCache.close();
+	reportProgress(uFileAmount, uFileAmount);
+	return true;
+}
+
+//Generate a proper file name according to application type.
+QString QxDecoder::getSaveImageName(const QString& strImagePath, const quint32 uCode, const quint32 uIndex, const QxDecodeSettings& settings)
+{
+	const QxDecodeOptionDlg::ApplicationType appType = settings.appType;
+	const QString strBaseName = QString::number(uCode) + "-" + QString::number(uIndex);
+	QString strImageName;
+	if (appType == QxDecodeOptionDlg::Caffe)
+	{
+		strImageName = strImagePath + fanOutFolder(strBaseName, uCode, settings.fanOutMode) + "/" + strBaseName;
+	}
+	else if (appType == QxDecodeOptionDlg::CNTK)
+	{
+		strImageName = strImagePath + fanOutFolder(strBaseName, uCode, settings.fanOutMode) + "/" + strBaseName;
+	}
+	else if (appType == QxDecodeOptionDlg::TensorFlow)
+	{
+		strImageName = strImagePath + fanOutFolder(strBaseName, uCode, settings.fanOutMode) + "/" + strBaseName;
+	}
+	else  //DIGITS
+	{
+		// First, check whether the subfolder for this class exists.
+		strImageName = strImagePath + "/" + QString::number(uCode);
+		if (!m_DigitsImageCountMap.contains(strImageName))
+		{
+			// The global g_dirManager keeps its path, so that relative paths are never resolved inside a class folder.
+			if (!g_dirManager.exists(strImageName))
+			{
+				g_dirManager.mkpath(strImageName);
+			}
+			// Images are saved later on the worker pool, thus the folder is counted only once, then the count is kept up to date here.
+			m_DigitsImageCountMap[strImageName] = QDir(strImageName, QString(), QDir::NoSort, QDir::Files).count();
+		}
+		//For example, if there are already 5 images in the folder, the new image will be named 6 (plus image suffix).
+		quint32& uImageCount = m_DigitsImageCountMap[strImageName];
+		strImageName = strImageName + "/" + QString::number(++uImageCount);
+	}
+
+	return strImageName;
+}
+
+//Sub-folder of an image in the fan-out layout, e.g. "/3f/a2" or "/45217", empty without fan-out.
+QString QxDecoder::fanOutFolder(const QString& strImageName, const quint32 uCode, QxDecodeSettings::FanOutMode fanOutMode)
+{
+	// The hash only depends on the image name, thus the folder of an image can be found back from its name alone.
+	quint64 uHash = (fanOutMode == QxDecodeSettings::HashFanOut || fanOutMode == QxDecodeSettings::TwoLevelHashFanOut) ? qxHash64(strImageName.toUtf8(), 0) : 0;
+	switch (fanOutMode)
+	{
+	case QxDecodeSettings::HashFanOut:
+		return QString("/%1").arg(uHash % g_iFanOutWidth, 2, 16, QChar('0'));
+	case QxDecodeSettings::TwoLevelHashFanOut:
+		return QString("/%1/%2").arg(uHash % g_iFanOutWidth, 2, 16, QChar('0')).arg(uHash / g_iFanOutWidth % g_iFanOutWidth, 2, 16, QChar('0'));
+	case QxDecodeSettings::TagCodeFanOut:
+		return "/" + QString::number(uCode);
+	default:
+		return QString();
+	}
+}
+
+//Create all the hashed fan-out folders of an image folder, so that the workers only create files.
+bool QxDecoder::createFanOutFolders(const QString& strImagePath, QxDecodeSettings::FanOutMode fanOutMode)
+{
+	for (int i = 0; i != g_iFanOutWidth; ++i)
+	{
+		QString strFolder = strImagePath + QString("/%1").arg(i, 2, 16, QChar('0'));
+		for (int j = 0; j != g_iFanOutWidth && fanOutMode == QxDecodeSettings::TwoLevelHashFanOut; ++j)
+		{
+			if (!g_dirManager.mkpath(strFolder + QString("/%1").arg(j, 2, 16, QChar('0'))))
+			{
+				return false;
+			}
+		}
+		if (!g_dirManager.mkpath(strFolder))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//Generate the "image name   label" format string.
+QString QxDecoder::getLabelInfo(const QString& strImageName, const quint32 uLabel, QxDecodeOptionDlg::ApplicationType appType)
+{
+	QString strToken;
+	switch (appType)
+	{
+	case QxDecodeOptionDlg::Caffe:
+		strToken = " "; break;
+	case QxDecodeOptionDlg::CNTK:
+		strToken = "\t"; break;
+	case QxDecodeOptionDlg::TensorFlow:
+		strToken = " "; break;
+	case QxDecodeOptionDlg::DIGITS:
+		strToken = " "; break;
+	default:
+		strToken = " ";
+	}
+	return strImageName + strToken + QString::number(uLabel);
+}
+
+//Save the mapping file of each output tree.
+void QxDecoder::saveMappingFiles(QxDecodeOptionDlg::ApplicationType appType)
+{
+	for (int iSize = 0; iSize != m_iSizeCount; ++iSize)
+	{
+		saveMappingFile(m_SizeOutputs[iSize].strDestinationPath, appType);
+	}
+}
+
+//Save the mapping relationship between image labels and the GBK code of Chinese characters into a .txt file.
+void QxDecoder::saveMappingFile(const QString& strFilePath, QxDecodeOptionDlg::ApplicationType appType)
+{
+	// There's no need to store label files for DIGITS.
+	if (appType == QxDecodeOptionDlg::DIGITS)
+	{
+		return;
+	}
+
+	QString strFileName = strFilePath + "/" + mappingFileName();
+	QFile file(strFileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		return;
+	}
+
+	const int iWordWidth = 10;
+	QTextStream textStream(&file);
+	textStream << qSetFieldWidth(iWordWidth) << left << "Code" << "Label" << qSetFieldWidth(0) << "\n";
+	for (QMap<quint32, quint32>::iterator itr = m_LabelCodeMap.begin(); itr != m_LabelCodeMap.end(); ++itr)
+	{
+		textStream << qSetFieldWidth(iWordWidth) << left << itr.key() << itr.value() << qSetFieldWidth(0) << "\n";
+	}
+	file.close();
+}
+
+//Save one label file per set (or a single one when the samples are not split).
+void QxDecoder::saveLabelFiles(const QxDecodeSettings& settings)
+{
+	// Packed tensors and atlas sheets come with their own label files.
+	if (settings.outputMode != QxDecodeSettings::ImageFiles)
+	{
+		return;
+	}
+	int iSetCount = (settings.splitMode == QxDecodeSettings::NoSplit) ? 1 : int(QxDecodeSettings::SplitSetCount);
+	for (int iSet = 0; iSet != iSetCount; ++iSet)
+	{
+		QString strLabelFileName = labelFileName(settings.splitMode, QxDecodeSettings::SplitSet(iSet));
+		if (settings.bShuffle)
+		{
+			saveLabelFiles(strLabelFileName, m_LabelShufflers[iSet], settings.appType);
+			continue;
+		}
+		for (int iSize = 0; iSize != m_iSizeCount; ++iSize)
+		{
+			SizeOutput& output = m_SizeOutputs[iSize];
+			saveLabelFile(output.strDestinationPath, strLabelFileName, output.imageLabelMap[iSet], settings.appType);
+		}
+	}
+}
+
+//Save the image names and corresponding labels into a .txt file for Caffe/CNTK/TensorFlow
+void QxDecoder::saveLabelFile(const QString& strFilePath, const QString& strLabelFileName, const QMap<QString, quint32>& imageLabelMap, QxDecodeOptionDlg::ApplicationType appType)
+{
+	// There's no need to store label files for DIGITS.
+	if (appType == QxDecodeOptionDlg::DIGITS)
+	{
+		return;
+	}
+
+	// Use a local file to save path of images and corresponding labels.
+	QFile labelFile(strFilePath + "/" + strLabelFileName);
+	if (!openLabelFile(labelFile, strLabelFileName))
+	{
+		return;
+	}
+
+	QTextStream textStream(&labelFile);
+	for (QMap<QString, quint32>::const_iterator itr = imageLabelMap.begin(); itr != imageLabelMap.end(); ++itr)
+	{
+		textStream << getLabelInfo(itr.key(), itr.value(), appType) << "\n";
+	}
+	labelFile.close();
+}
+
+//Save the label lines of all the output trees collected by a shuffler, in shuffled order. The temporary files of the shuffler are removed.
+void QxDecoder::saveLabelFiles(const QString& strLabelFileName, QxExternalShuffler& labelShuffler, QxDecodeOptionDlg::ApplicationType appType)
+{
+	if (appType == QxDecodeOptionDlg::DIGITS)
+	{
+		labelShuffler.close();
+		return;
+	}
+
+	QFile labelFiles[MaxImageSizeCount];
+	for (int iSize = 0; iSize != m_iSizeCount; ++iSize)
+	{
+		labelFiles[iSize].setFileName(m_SizeOutputs[iSize].strDestinationPath + "/" + strLabelFileName);
+		if (!openLabelFile(labelFiles[iSize], strLabelFileName))
+		{
+			labelShuffler.close();
+			return;
+		}
+	}
+
+	// Each record holds the line of every output tree, UTF-8 already and ended by a new line.
+	QByteArray lines;
+	while (labelShuffler.readRecord(lines))
+	{
+		int iStart = 0;
+		for (int iSize = 0; iSize != m_iSizeCount; ++iSize)
+		{
+			int iEnd = lines.indexOf('\n', iStart) + 1;
+			if (iEnd == 0)
+			{
+				break;
+			}
+			labelFiles[iSize].write(lines.constData() + iStart, iEnd - iStart);
+			iStart = iEnd;
+		}
+	}
+	for (int iSize = 0; iSize != m_iSizeCount; ++iSize)
+	{
+		labelFiles[iSize].close();
+	}
+	if (labelShuffler.hasError())
+	{
+		reportError("Read file error", "Can not shuffle the labels:\n" + labelShuffler.errorString());
+	}
+	labelShuffler.close();
+}
+
+//Create a label file, telling the user when it's not possible.
+bool QxDecoder::openLabelFile(QFile& labelFile, const QString& strLabelFileName)
+{
+	if (!labelFile.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		QString strTitle("Open file error");
+		QString strMessage("Can not open label file:\n");
+		strMessage.append(labelFile.fileName());
+		strMessage.append("\nMaybe you do not have permission to create a new file in the selected folder?");
+		strMessage.append("\nOr maybe there is a Read-Only file named \"").append(strLabelFileName).append("\" in the selected folder?");
+		reportError(strTitle, strMessage);
+		return false;
+	}
+	return true;
+}
+
@@ -0,0 +1,104 @@
+#ifndef _QX_DECODER_H_
+#define _QX_DECODER_H_
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include "QxDecodeOptionDlg.h"
+#include "QxDecodeSettings.h"
+#include "QxEncodedCache.h"
+#include "QxExternalShuffler.h"
+
+class QFile;
+class QxSampleStore;
+
+/*
+	Decode .gnt files into image files or packed tensors, with their label files, as selected in QxDecodeSettings.
+	There's no window involved: the questions, errors and progress go through virtual functions, whose default
+	implementations suit batch jobs (print the message, take the default answer). The main window overrides them.
+*/
+class QxDecoder
+{
+public:
+	// Maximum number of image sizes decoded in one pass (see QxDecodeSettings::extraImageSides).
+	static const int MaxImageSizeCount = 8;
+
+	QxDecoder();
+	virtual ~QxDecoder();
+
+	//Decoded .gnt files based on the parameters. Return true when successfully decoding the files.
+	bool decodeFiles(const QStringList& fileList, const QxDecodeSettings& settings);
+	//Read the files through a sample store (see QxGntReader::open()), or straight from disk when pStore is NULL (default).
+	void setSampleStore(QxSampleStore* pStore);
+
+	//Name of the file holding the mapping between tag codes and labels ("code_label.txt").
+	static QString mappingFileName();
+	//Name of the label file of a set: "image_labels.txt" when not splitting, otherwise e.g. "train_labels.txt".
+	static QString labelFileName(QxDecodeSettings::SplitMode splitMode, QxDecodeSettings::SplitSet set);
+	//Name of the atlas manifest of a set: "sheets.txt" when not splitting, otherwise e.g. "train_sheets.txt".
+	static QString manifestFileName(QxDecodeSettings::SplitMode splitMode, QxDecodeSettings::SplitSet set);
+	//Name of the packed tensors and labels of a set: "images.npy" and "labels.npy" when not splitting, otherwise e.g. "train_images.npy".
+	static QString tensorFileName(QxDecodeSettings::SplitMode splitMode, QxDecodeSettings::SplitSet set);
+	static QString tensorLabelFileName(QxDecodeSettings::SplitMode splitMode, QxDecodeSettings::SplitSet set);
+	//Number of images of the last decoding linked (or copied) from the cache instead of being encoded.
+	int cachedImageCount() const;
+
+protected:
+	//Ask a yes/no question. The default implementation prints it and returns bDefault.
+	virtual bool confirm(const QString& strTitle, const QString& strMessage, bool bDefault);
+	//Report an error. The default implementation prints it.
+	virtual void reportError(const QString& strTitle, const QString& strMessage);
+	//Called before each file and regularly while decoding it, iDone of iTotal files being done. Return false to cancel.
+	virtual bool reportProgress(int iDone, int iTotal);
+
+private:
+    //Generate the "image name   label" format string.
+    QString getLabelInfo(const QString& strImageName, const quint32 uLabel, QxDecodeOptionDlg::ApplicationType appType);
+	//Generate a proper file name according to application type.
+	QString getSaveImageName(const QString& strImagePath, const quint32 uCode, const quint32 uIndex, const QxDecodeSettings& settings);
+	//Sub-folder of an image in the fan-out layout, e.g. "/3f/a2" or "/45217", empty without fan-out.
+	static QString fanOutFolder(const QString& strImageName, const quint32 uCode, QxDecodeSettings::FanOutMode fanOutMode);
+	//Create all the hashed fan-out folders of an image folder, so that the workers only create files.
+	bool createFanOutFolders(const QString& strImagePath, QxDecodeSettings::FanOutMode fanOutMode);
+
+    //Save the image names and corresponding labels into a .txt file for Caffe/CNTK/TensorFlow
+    void saveLabelFile(const QString& strFilePath, const QString& strLabelFileName, const QMap<QString, quint32>& imageLabelMap, QxDecodeOptionDlg::ApplicationType appType);
+    //Save the label lines of all the output trees collected by a shuffler, in shuffled order. The temporary files of the shuffler are removed.
+    void saveLabelFiles(const QString& strLabelFileName, QxExternalShuffler& labelShuffler, QxDecodeOptionDlg::ApplicationType appType);
+    //Create a label file, telling the user when it's not possible.
+    bool openLabelFile(QFile& labelFile, const QString& strLabelFileName);
+    //Save one label file per set (or a single one when the samples are not split).
+    void saveLabelFiles(const QxDecodeSettings& settings);
+    //Save the mapping relationship between image labels and the GBK code of Chinese characters into a .txt file.
+    void saveMappingFile(const QString& strFilePath, QxDecodeOptionDlg::ApplicationType appType);
+    //Save the mapping file of each output tree.
+    void saveMappingFiles(QxDecodeOptionDlg::ApplicationType appType);
+
+private:
+    //Output tree of one image size: the selected folder, or its sub-folder named after the side when decoding several sizes.
+    struct SizeOutput
+    {
+        int iSide;
+        QString strDestinationPath;
+        QString strSetImagePath[QxDecodeSettings::SplitSetCount];
+        //Image names and labels of each set (only the first one is used when the samples are not split).
+        QMap<QString, quint32> imageLabelMap[QxDecodeSettings::SplitSetCount];
+    };
+
+    //Labels shared by all the output trees.
+    QMap<quint32, quint32> m_LabelCodeMap;
+    SizeOutput m_SizeOutputs[MaxImageSizeCount];
+    //Label lines of each set when the output order is shuffled (they are not kept in memory then). Each record holds
+    //the lines of a sample for all the output trees, so that a single shuffle gives every tree the same order.
+    QxExternalShuffler m_LabelShufflers[QxDecodeSettings::SplitSetCount];
+    int m_iSizeCount;
+    //Number of images in each class folder (DIGITS only).
+    QMap<QString, quint32> m_DigitsImageCountMap;
+    //Images encoded by former decodings, when QxDecodeSettings::strCachePath is set.
+    QxEncodedCache m_EncodedCache;
+    //Samples of the files read by former decodings and previews, NULL when the files are read from disk.
+    QxSampleStore* m_pSampleStore;
+};
+
+#endif
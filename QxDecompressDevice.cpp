@@ -0,0 +1,356 @@
+#include <string.h>
+
+#include <zlib.h>
+#include <zstd.h>
+
+#include <QMutexLocker>
+#include <QThread>
+
+#include "QxDecompressDevice.h"
+
+// Size of the compressed blocks read from disk.
+static const qint64 g_iInputChunkSize = 256 * 1024;
+// Size of the decompressed chunks handed over to the reader.
+static const qint64 g_iOutputChunkSize = 1024 * 1024;
+// At most this many decompressed chunks are buffered, which bounds the memory used per device.
+static const int g_iMaxQueuedChunks = 8;
+
+// Thread running QxDecompressDevice::decompress().
+class QxDecompressDevice::Worker : public QThread
+{
+public:
+	explicit Worker(QxDecompressDevice* pDevice) : m_pDevice(pDevice) {}
+
+protected:
+	virtual void run() { m_pDevice->decompress(); }
+
+private:
+	QxDecompressDevice* m_pDevice;
+};
+
+QxDecompressDevice::QxDecompressDevice(const QString& strFileName, Compression compression, QObject* parent /*= NULL*/)
+	: QIODevice(parent)
+	, m_strFileName(strFileName)
+	, m_Compression(compression)
+	, m_File(strFileName)
+	, m_bFinished(false)
+	, m_bAbort(false)
+	, m_iChunkPos(0)
+{
+}
+
+QxDecompressDevice::~QxDecompressDevice()
+{
+	close();
+}
+
+//Detect the compression from the file suffix. Return false for uncompressed files.
+bool QxDecompressDevice::compressionOf(const QString& strFileName, Compression& compression)
+{
+	if (strFileName.endsWith(".gz", Qt::CaseInsensitive))
+	{
+		compression = Gzip;
+		return true;
+	}
+	else if (strFileName.endsWith(".zst", Qt::CaseInsensitive))
+	{
+		compression = Zstd;
+		return true;
+	}
+	return false;
+}
+
+bool QxDecompressDevice::open(OpenMode mode)
+{
+	if ((mode & WriteOnly) || isOpen())
+	{
+		return false;
+	}
+	if (!m_File.open(QIODevice::ReadOnly))
+	{
+		setErrorString(m_File.errorString());
+		return false;
+	}
+
+	m_Chunks.clear();
+	m_CurrentChunk.clear();
+	m_iChunkPos = 0;
+	m_bFinished = false;
+	m_bAbort = false;
+	m_strError.clear();
+
+	m_pWorker.reset(new Worker(this));
+	m_pWorker->start();
+	return QIODevice::open(mode);
+}
+
+void QxDecompressDevice::close()
+{
+	if (m_pWorker)
+	{
+		{
+			QMutexLocker locker(&m_Mutex);
+			m_bAbort = true;
+			m_NotFull.wakeAll();
+		}
+		m_pWorker->wait();
+		m_pWorker.reset();
+	}
+	m_File.close();
+	m_Chunks.clear();
+	m_CurrentChunk.clear();
+	m_iChunkPos = 0;
+	QIODevice::close();
+}
+
+bool QxDecompressDevice::isSequential() const
+{
+	return true;
+}
+
+bool QxDecompressDevice::atEnd() const
+{
+	if (m_iChunkPos != m_CurrentChunk.size())
+	{
+		return false;
+	}
+	// Wait until the worker either produced more data or reached the end, otherwise "no data yet" would look like the end.
+	QMutexLocker locker(&m_Mutex);
+	while (m_Chunks.isEmpty() && !m_bFinished)
+	{
+		m_NotEmpty.wait(&m_Mutex);
+	}
+	return m_Chunks.isEmpty();
+}
+
+qint64 QxDecompressDevice::readData(char* pData, qint64 iMaxSize)
+{
+	qint64 iReadSize = 0;
+	while (iReadSize < iMaxSize)
+	{
+		if (m_iChunkPos == m_CurrentChunk.size())
+		{
+			QMutexLocker locker(&m_Mutex);
+			while (m_Chunks.isEmpty() && !m_bFinished)
+			{
+				m_NotEmpty.wait(&m_Mutex);
+			}
+			if (m_Chunks.isEmpty())
+			{
+				// Nothing left. Report a decompression error only once all the good data has been consumed.
+				if (!m_strError.isEmpty())
+				{
+					setErrorString(m_strError);
+					return iReadSize ? iReadSize : -1;
+				}
+				break;
+			}
+			m_CurrentChunk = m_Chunks.dequeue();
+			m_iChunkPos = 0;
+			m_NotFull.wakeOne();
+		}
+		qint64 iCopySize = qMin(iMaxSize - iReadSize, qint64(m_CurrentChunk.size()) - m_iChunkPos);
+		memcpy(pData + iReadSize, m_CurrentChunk.constData() + m_iChunkPos, iCopySize);
+		m_iChunkPos += iCopySize;
+		iReadSize += iCopySize;
+	}
+	return iReadSize;
+}
+
+qint64 QxDecompressDevice::writeData(const char* /*pData*/, qint64 /*iMaxSize*/)
+{
+	return -1;
+}
+
+//Run on the worker thread: decompress the whole file into the chunk queue.
+void QxDecompressDevice::decompress()
+{
+	QString strError;
+	if (m_Compression == Gzip)
+	{
+		inflateGzip(strError);
+	}
+	else
+	{
+		decompressZstd(strError);
+	}
+
+	QMutexLocker locker(&m_Mutex);
+	m_bFinished = true;
+	m_strError = strError;
+	m_NotEmpty.wakeAll();
+}
+
+bool QxDecompressDevice::inflateGzip(QString& strError)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	// 15 + 32: maximum window size, detect gzip/zlib header automatically.
+	if (inflateInit2(&stream, 15 + 32) != Z_OK)
+	{
+		strError = "Cannot initialize gzip decompression.";
+		return false;
+	}
+
+	QByteArray input(g_iInputChunkSize, Qt::Uninitialized);
+	QByteArray output(g_iOutputChunkSize, Qt::Uninitialized);
+	bool bOk = true;
+	bool bInputEnd = false;
+	// Whether a member ended and the next one didn't start yet, and whether zero padding followed it.
+	bool bStreamEnd = false;
+	bool bPadding = false;
+	while (bOk)
+	{
+		if (stream.avail_in == 0 && !bInputEnd)
+		{
+			qint64 iReadSize = m_File.read(input.data(), input.size());
+			if (iReadSize < 0)
+			{
+				strError = m_File.errorString();
+				bOk = false;
+				break;
+			}
+			bInputEnd = (iReadSize == 0);
+			stream.next_in = reinterpret_cast<Bytef*>(input.data());
+			stream.avail_in = uInt(iReadSize);
+		}
+		if (bStreamEnd)
+		{
+			// Files written through tar or dd may be padded with zeros after the last member, which gzip accepts too.
+			while (stream.avail_in && *stream.next_in == 0)
+			{
+				++stream.next_in;
+				--stream.avail_in;
+				bPadding = true;
+			}
+			if (stream.avail_in == 0)
+			{
+				if (bInputEnd)
+				{
+					break;
+				}
+				continue;
+			}
+			if (bPadding)
+			{
+				strError = "Unexpected data after the zero padding of the gzip data.";
+				bOk = false;
+				break;
+			}
+		}
+
+		// Called until the end of a member, or until it makes no progress without input left, so that the output
+		// still pending inside zlib when the input is consumed exactly as the output fills is drained.
+		stream.next_out = reinterpret_cast<Bytef*>(output.data());
+		stream.avail_out = uInt(output.size());
+		int iResult = inflate(&stream, Z_NO_FLUSH);
+		if (iResult != Z_OK && iResult != Z_STREAM_END && iResult != Z_BUF_ERROR)
+		{
+			strError = QString("Corrupt gzip data: %1").arg(stream.msg ? stream.msg : "unknown error");
+			bOk = false;
+			break;
+		}
+		qint64 iProducedSize = output.size() - stream.avail_out;
+		if (iProducedSize && !pushChunk(output.constData(), iProducedSize))
+		{
+			bOk = false;
+			break;
+		}
+		// Files written by parallel compressors (pigz, ...) consist of several concatenated gzip members.
+		bStreamEnd = (iResult == Z_STREAM_END);
+		if (bStreamEnd)
+		{
+			inflateReset(&stream);
+		}
+		else if (iResult == Z_BUF_ERROR && bInputEnd)
+		{
+			break;
+		}
+	}
+	inflateEnd(&stream);
+
+	if (bOk && !bStreamEnd)
+	{
+		strError = "Unexpected end of gzip data, the file may be truncated.";
+		bOk = false;
+	}
+	return bOk;
+}
+
+bool QxDecompressDevice::decompressZstd(QString& strError)
+{
+	ZSTD_DStream* pStream = ZSTD_createDStream();
+	if (!pStream || ZSTD_isError(ZSTD_initDStream(pStream)))
+	{
+		ZSTD_freeDStream(pStream);
+		strError = "Cannot initialize zstd decompression.";
+		return false;
+	}
+
+	QByteArray input(g_iInputChunkSize, Qt::Uninitialized);
+	QByteArray output(g_iOutputChunkSize, Qt::Uninitialized);
+	bool bOk = true;
+	size_t uLastResult = 0;
+	while (bOk)
+	{
+		qint64 iReadSize = m_File.read(input.data(), input.size());
+		if (iReadSize < 0)
+		{
+			strError = m_File.errorString();
+			bOk = false;
+			break;
+		}
+		if (iReadSize == 0)
+		{
+			break;
+		}
+
+		ZSTD_inBuffer inBuffer = { input.constData(), size_t(iReadSize), 0 };
+		bool bOutputFull = false;
+		// Keep calling while there is input left, or while the output was full (more data may be pending inside zstd).
+		while (bOk && (inBuffer.pos < inBuffer.size || bOutputFull))
+		{
+			ZSTD_outBuffer outBuffer = { output.data(), size_t(output.size()), 0 };
+			uLastResult = ZSTD_decompressStream(pStream, &outBuffer, &inBuffer);
+			if (ZSTD_isError(uLastResult))
+			{
+				strError = QString("Corrupt zstd data: %1").arg(ZSTD_getErrorName(uLastResult));
+				bOk = false;
+				break;
+			}
+			if (outBuffer.pos && !pushChunk(output.constData(), outBuffer.pos))
+			{
+				bOk = false;
+				break;
+			}
+			bOutputFull = (outBuffer.pos == outBuffer.size);
+		}
+	}
+	ZSTD_freeDStream(pStream);
+
+	// A non zero hint means the last frame is incomplete.
+	if (bOk && uLastResult != 0)
+	{
+		strError = "Unexpected end of zstd data, the file may be truncated.";
+		bOk = false;
+	}
+	return bOk;
+}
+
+//Append a decompressed chunk, waiting while the queue is full. Return false if the device is being closed.
+bool QxDecompressDevice::pushChunk(const char* pData, qint64 iSize)
+{
+	QByteArray chunk(pData, int(iSize));
+	QMutexLocker locker(&m_Mutex);
+	while (m_Chunks.size() >= g_iMaxQueuedChunks && !m_bAbort)
+	{
+		m_NotFull.wait(&m_Mutex);
+	}
+	if (m_bAbort)
+	{
+		return false;
+	}
+	m_Chunks.enqueue(chunk);
+	m_NotEmpty.wakeOne();
+	return true;
+}
@@ -0,0 +1,69 @@
+#ifndef _QX_DECOMPRESS_DEVICE_H_
+#define _QX_DECOMPRESS_DEVICE_H_
+
+#include <QByteArray>
+#include <QFile>
+#include <QIODevice>
+#include <QMutex>
+#include <QQueue>
+#include <QScopedPointer>
+#include <QWaitCondition>
+
+class QThread;
+
+/*
+	Read-only sequential device returning the decompressed content of a gzip (.gz) or zstd (.zst) file.
+	Decompression runs on a separate thread which feeds a small bounded queue of chunks, so the reader never
+	needs the whole decompressed file in memory or on disk.
+*/
+class QxDecompressDevice : public QIODevice
+{
+public:
+	enum Compression{ Gzip, Zstd };
+
+	QxDecompressDevice(const QString& strFileName, Compression compression, QObject* parent = NULL);
+	virtual ~QxDecompressDevice();
+
+	// Detect the compression from the file suffix. Return false for uncompressed files.
+	static bool compressionOf(const QString& strFileName, Compression& compression);
+
+	virtual bool atEnd() const;
+	virtual void close();
+	virtual bool isSequential() const;
+	virtual bool open(OpenMode mode);
+
+protected:
+	virtual qint64 readData(char* pData, qint64 iMaxSize);
+	virtual qint64 writeData(const char* pData, qint64 iMaxSize);
+
+private:
+	class Worker;
+
+	// Run on the worker thread: decompress the whole file into the chunk queue.
+	void decompress();
+	bool inflateGzip(QString& strError);
+	bool decompressZstd(QString& strError);
+	// Append a decompressed chunk, waiting while the queue is full. Return false if the device is being closed.
+	bool pushChunk(const char* pData, qint64 iSize);
+
+private:
+	QString m_strFileName;
+	Compression m_Compression;
+	QFile m_File;
+	QScopedPointer<QThread> m_pWorker;
+
+	// Shared between the reading thread and the worker thread.
+	mutable QMutex m_Mutex;
+	mutable QWaitCondition m_NotEmpty;
+	QWaitCondition m_NotFull;
+	QQueue<QByteArray> m_Chunks;
+	bool m_bFinished;
+	bool m_bAbort;
+	QString m_strError;
+
+	// Only used by the reading thread.
+	QByteArray m_CurrentChunk;
+	qint64 m_iChunkPos;
+};
+
+#endif
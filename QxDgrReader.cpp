@@ -0,0 +1,341 @@
+#include <limits.h>
+
+#include "QxDecompressDevice.h"
+#include "QxDgrReader.h"
+#include "QxGntReader.h"
+
+// Header size (4 bytes), format code (8), code type (20), code length (2) and bits per pixel (2), around the illustration.
+static const quint64 g_uMinHeaderSize = 36;
+// Image height, image width and line count of a page (4 bytes each).
+static const quint64 g_uPageHeaderSize = 12;
+// Top, left, height and width of a character (2 bytes each).
+static const quint64 g_uCharacterHeaderSize = 8;
+// Decompressed files are read in chunks of this size.
+static const qint64 g_iReadChunkSize = 1 << 20;
+
+static inline quint32 readUInt16(const uchar* pData)
+{
+	return pData[0] + quint32(pData[1]) * (1 << 8);
+}
+
+static inline quint32 readUInt32(const uchar* pData)
+{
+	return pData[0] + quint32(pData[1]) * (1 << 8) + quint32(pData[2]) * (1 << 16) + quint32(pData[3]) * (1 << 24);
+}
+
+QxDgrReader::QxDgrReader()
+	: m_pData(NULL)
+	, m_uSize(0)
+	, m_iCodeLength(0)
+	, m_uCharacterCount(0)
+	, m_bReadError(false)
+	, m_uErrorOffset(0)
+	, m_uErrorIndex(0)
+{
+}
+
+QxDgrReader::~QxDgrReader()
+{
+	close();
+}
+
+//Names of the files which can be read, to be used in file dialogs.
+QString QxDgrReader::fileFilter()
+{
+	return "DGR files (*.dgr *.dgr.gz *.dgr.zst)";
+}
+
+//Whether a file is a .dgr file (compressed or not), judging by its name.
+bool QxDgrReader::isDgrFile(const QString& strFileName)
+{
+	return strFileName.endsWith(".dgr", Qt::CaseInsensitive) || strFileName.endsWith(".dgr.gz", Qt::CaseInsensitive)
+		|| strFileName.endsWith(".dgr.zst", Qt::CaseInsensitive);
+}
+
+//Map the file and walk its pages.
+bool QxDgrReader::open(const QString& strFileName)
+{
+	close();
+	m_strErrorMessage.clear();
+	m_bReadError = false;
+
+	QxDecompressDevice::Compression compression;
+	if (QxDecompressDevice::compressionOf(strFileName, compression))
+	{
+		QxDecompressDevice device(strFileName, compression);
+		if (!device.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+		{
+			m_strErrorMessage = device.errorString();
+			return false;
+		}
+		for (;;)
+		{
+			int iSize = m_FileData.size();
+			if (iSize > INT_MAX - g_iReadChunkSize)
+			{
+				m_strErrorMessage = "The file decompresses to more than 2 GB, which can't be held in memory. "
+					"Decompress it to a .dgr file, which is memory-mapped instead.";
+				m_FileData.clear();
+				return false;
+			}
+			m_FileData.resize(iSize + int(g_iReadChunkSize));
+			qint64 iReadSize = device.read(m_FileData.data() + iSize, g_iReadChunkSize);
+			if (iReadSize < 0)
+			{
+				m_strErrorMessage = device.errorString();
+				m_FileData.clear();
+				return false;
+			}
+			m_FileData.resize(iSize + int(iReadSize));
+			if (iReadSize == 0)
+			{
+				break;
+			}
+		}
+		m_pData = reinterpret_cast<const uchar*>(m_FileData.constData());
+		m_uSize = m_FileData.size();
+	}
+	else
+	{
+		m_File.setFileName(strFileName);
+		if (!m_File.open(QIODevice::ReadOnly))
+		{
+			m_strErrorMessage = m_File.errorString();
+			return false;
+		}
+		m_uSize = m_File.size();
+		m_pData = m_uSize ? m_File.map(0, m_uSize) : NULL;
+		if (m_uSize && !m_pData)
+		{
+			// Mapping may not be supported by the file system, keep the file in memory instead.
+			if (m_uSize > quint64(INT_MAX))
+			{
+				m_strErrorMessage = "The file can't be memory-mapped, and is too large to be read into memory (over 2 GB).";
+				close();
+				return false;
+			}
+			m_FileData = m_File.readAll();
+			if (quint64(m_FileData.size()) != m_uSize)
+			{
+				m_strErrorMessage = m_File.errorString();
+				close();
+				return false;
+			}
+			m_pData = reinterpret_cast<const uchar*>(m_FileData.constData());
+		}
+	}
+
+	QString strError;
+	if (!parseFileHeader(strError))
+	{
+		close();
+		m_strErrorMessage = strError;
+		return false;
+	}
+	return true;
+}
+
+void QxDgrReader::close()
+{
+	// unmapped with the file
+	m_File.close();
+	m_FileData.clear();
+	m_pData = NULL;
+	m_uSize = 0;
+	m_Pages.clear();
+	m_uCharacterCount = 0;
+}
+
+int QxDgrReader::pageCount() const
+{
+	return m_Pages.size();
+}
+
+const QxDgrPage& QxDgrReader::page(int iPage) const
+{
+	return m_Pages.at(iPage);
+}
+
+quint64 QxDgrReader::characterCount() const
+{
+	return m_uCharacterCount;
+}
+
+//Fill the records of a page, their bitmaps pointing into the file. The page was checked by open().
+void QxDgrReader::readPage(int iPage, QxGntRecord* pRecords) const
+{
+	const QxDgrPage& page = m_Pages.at(iPage);
+	quint64 uPos = page.uOffset + g_uPageHeaderSize;
+	quint64 uIndex = page.uFirstIndex;
+	for (quint32 uLine = 0; uLine != page.uLineCount; ++uLine)
+	{
+		const quint32 uCharacterCount = readUInt32(m_pData + uPos);
+		const uchar* pLabels = m_pData + uPos + 4;
+		uPos += 4 + quint64(uCharacterCount) * m_iCodeLength;
+		for (quint32 c = 0; c != uCharacterCount; ++c, ++uIndex, ++pRecords)
+		{
+			// top and left (the position in the page) are not needed
+			const uchar* pHeader = m_pData + uPos;
+			QxGntRecord& record = *pRecords;
+			record.uTagCode = tagCode(pLabels + c * m_iCodeLength);
+			record.uHeight = readUInt16(pHeader + 4);
+			record.uWidth = readUInt16(pHeader + 6);
+			record.uOffset = uPos;
+			record.uIndex = uIndex;
+			const int iBitmapSize = int(record.uWidth * record.uHeight);
+			record.bitmap = QByteArray::fromRawData(reinterpret_cast<const char*>(pHeader + g_uCharacterHeaderSize), iBitmapSize);
+			uPos += g_uCharacterHeaderSize + iBitmapSize;
+		}
+	}
+}
+
+bool QxDgrReader::hasError() const
+{
+	return !m_strErrorMessage.isEmpty();
+}
+
+//Error message including the index and byte offset of the page where the error occurred.
+QString QxDgrReader::errorString() const
+{
+	if (!m_bReadError)
+	{
+		return m_strErrorMessage;
+	}
+	return QString("%1 (page %2 from sample %3, byte offset %4)").arg(m_strErrorMessage).arg(m_Pages.size()).arg(m_uErrorIndex).arg(m_uErrorOffset);
+}
+
+//Error message only.
+QString QxDgrReader::errorMessage() const
+{
+	return m_strErrorMessage;
+}
+
+quint64 QxDgrReader::offset() const
+{
+	return m_uErrorOffset;
+}
+
+quint64 QxDgrReader::sampleIndex() const
+{
+	return m_uErrorIndex;
+}
+
+//Decode and check the file header, then walk the pages up to the end of the file or the first corrupt page.
+bool QxDgrReader::parseFileHeader(QString& strError)
+{
+	if (m_uSize < g_uMinHeaderSize)
+	{
+		strError = QString("File of %1 bytes is smaller than a .dgr header.").arg(m_uSize);
+		return false;
+	}
+	const quint64 uHeaderSize = readUInt32(m_pData);
+	if (qstrnicmp(reinterpret_cast<const char*>(m_pData + 4), "DGR", 3) != 0)
+	{
+		strError = "Not a .dgr file (no DGR format code).";
+		return false;
+	}
+	if (uHeaderSize < g_uMinHeaderSize || uHeaderSize > m_uSize)
+	{
+		strError = QString("Header size %1 is out of the file (%2 bytes).").arg(uHeaderSize).arg(m_uSize);
+		return false;
+	}
+	m_iCodeLength = int(readUInt16(m_pData + uHeaderSize - 4));
+	const quint32 uBitsPerPixel = readUInt16(m_pData + uHeaderSize - 2);
+	if (m_iCodeLength == 0)
+	{
+		strError = "Labels have a code length of 0 bytes.";
+		return false;
+	}
+	if (uBitsPerPixel != 8)
+	{
+		strError = QString("Only 8-bit .dgr files can be decoded (%1 bits per pixel).").arg(uBitsPerPixel);
+		return false;
+	}
+
+	quint64 uPos = uHeaderSize;
+	while (uPos != m_uSize)
+	{
+		QxDgrPage page;
+		page.uOffset = uPos;
+		page.uFirstIndex = m_uCharacterCount;
+		QString strPageError;
+		if (!indexPage(page, uPos, strPageError))
+		{
+			// the pages before are fine, the decoding reports the error once they are done
+			m_strErrorMessage = strPageError;
+			m_bReadError = true;
+			m_uErrorOffset = page.uOffset;
+			m_uErrorIndex = page.uFirstIndex;
+			break;
+		}
+		m_Pages.append(page);
+		m_uCharacterCount += page.uCharacterCount;
+	}
+	return true;
+}
+
+//Walk the lines of a page without touching the bitmaps. uEnd is set to the offset after the page.
+bool QxDgrReader::indexPage(QxDgrPage& page, quint64& uEnd, QString& strError) const
+{
+	quint64 uPos = page.uOffset;
+	if (m_uSize - uPos < g_uPageHeaderSize)
+	{
+		strError = "Unexpected end of file in the header of a page.";
+		return false;
+	}
+	page.uHeight = readUInt32(m_pData + uPos);
+	page.uWidth = readUInt32(m_pData + uPos + 4);
+	page.uLineCount = readUInt32(m_pData + uPos + 8);
+	uPos += g_uPageHeaderSize;
+
+	quint64 uCharacterCount = 0;
+	for (quint32 uLine = 0; uLine != page.uLineCount; ++uLine)
+	{
+		if (m_uSize - uPos < 4)
+		{
+			strError = QString("Unexpected end of file in the header of line %1.").arg(uLine);
+			return false;
+		}
+		const quint32 uLineCharacterCount = readUInt32(m_pData + uPos);
+		const quint64 uLabelSize = quint64(uLineCharacterCount) * m_iCodeLength;
+		uPos += 4;
+		if (m_uSize - uPos < uLabelSize)
+		{
+			strError = QString("Unexpected end of file in the labels of line %1 (%2 characters).").arg(uLine).arg(uLineCharacterCount);
+			return false;
+		}
+		uPos += uLabelSize;
+		for (quint32 c = 0; c != uLineCharacterCount; ++c)
+		{
+			if (m_uSize - uPos < g_uCharacterHeaderSize)
+			{
+				strError = QString("Unexpected end of file in the header of character %1 of line %2.").arg(c).arg(uLine);
+				return false;
+			}
+			const quint64 uBitmapSize = quint64(readUInt16(m_pData + uPos + 4)) * readUInt16(m_pData + uPos + 6);
+			uPos += g_uCharacterHeaderSize;
+			if (m_uSize - uPos < uBitmapSize)
+			{
+				strError = QString("Character %1 of line %2 needs %3 bytes but only %4 bytes are left, the file may be truncated.")
+					.arg(c).arg(uLine).arg(uBitmapSize).arg(m_uSize - uPos);
+				return false;
+			}
+			uPos += uBitmapSize;
+		}
+		uCharacterCount += uLineCharacterCount;
+	}
+	if (uCharacterCount > 0xFFFFFFFFu)
+	{
+		strError = QString("Page has %1 characters.").arg(uCharacterCount);
+		return false;
+	}
+	page.uCharacterCount = quint32(uCharacterCount);
+	uEnd = uPos;
+	return true;
+}
+
+//Tag code of a label: its first 2 bytes (or its only byte), in the same order as the tag codes of .gnt files.
+quint32 QxDgrReader::tagCode(const uchar* pLabel) const
+{
+	return m_iCodeLength == 1 ? pLabel[0] : readUInt16(pLabel);
+}
@@ -0,0 +1,96 @@
+#ifndef _QX_DGR_READER_H_
+#define _QX_DGR_READER_H_
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+struct QxGntRecord;
+
+/*
+	One page (image record) of a .dgr file, as found when the file is opened.
+*/
+struct QxDgrPage
+{
+	QxDgrPage() : uOffset(0), uFirstIndex(0), uCharacterCount(0), uWidth(0), uHeight(0), uLineCount(0) {}
+
+	// Byte offset of the page in the file and index of its first character in the file.
+	quint64 uOffset;
+	quint64 uFirstIndex;
+	quint32 uCharacterCount;
+	// Size of the page image and number of text lines.
+	quint32 uWidth;
+	quint32 uHeight;
+	quint32 uLineCount;
+};
+
+/*
+	Read the characters of a CASIA offline text line .dgr file (HWDB2.x) as .gnt-like records, without converting it first.
+	The file starts with a header:
+		header size (4 bytes), format code (8, "DGR"), illustration (header size - 36), code type (20),
+		code length (2, bytes of each label) and bits per pixel (2, only 8 is supported),
+	followed by the pages:
+		image height (4), image width (4), line count (4), then for each line its character count (4), the labels
+		of its characters (code length each), and for each character its top, left, height, width (2 each) and its bitmap.
+	All the fields are little-endian. The tag code of a character is made of the first 2 bytes of its label, like .gnt.
+	The file is memory-mapped (compressed .dgr.gz and .dgr.zst files are decompressed into memory once), and open() walks
+	the pages to find where each one starts, reading only the headers. The records of a page are views on the mapped
+	bitmaps, so pages are extracted without copying, and readPage() is thread-safe so that pages are extracted in parallel.
+*/
+class QxDgrReader
+{
+public:
+	QxDgrReader();
+	~QxDgrReader();
+
+	// Names of the files which can be read, to be used in file dialogs.
+	static QString fileFilter();
+	// Whether a file is a .dgr file (compressed or not), judging by its name.
+	static bool isDgrFile(const QString& strFileName);
+
+	// Map the file and find its pages. A corrupt page stops the walk: the pages before it can still be read, see hasError().
+	bool open(const QString& strFileName);
+	void close();
+
+	int pageCount() const;
+	const QxDgrPage& page(int iPage) const;
+	// Number of characters of all the pages found.
+	quint64 characterCount() const;
+	// Fill pRecords with the characters of a page, in file order. The bitmaps are views on the file, valid until close().
+	void readPage(int iPage, QxGntRecord* pRecords) const;
+
+	bool hasError() const;
+	// Error message including the index and byte offset of the page where the error occurred.
+	QString errorString() const;
+	// Error message only.
+	QString errorMessage() const;
+	// Byte offset of the corrupt page and index of its first character, after an error.
+	quint64 offset() const;
+	quint64 sampleIndex() const;
+
+private:
+	// Decode and check the file header, and find the first page.
+	bool parseFileHeader(QString& strError);
+	// Walk the lines of the page at page.uOffset, checking that every field and bitmap is within the file.
+	bool indexPage(QxDgrPage& page, quint64& uEnd, QString& strError) const;
+	// Tag code of a label.
+	quint32 tagCode(const uchar* pLabel) const;
+
+private:
+	QFile m_File;
+	// decompressed files, or files which can't be mapped
+	QByteArray m_FileData;
+	const uchar* m_pData;
+	quint64 m_uSize;
+	int m_iCodeLength;
+	QVector<QxDgrPage> m_Pages;
+	quint64 m_uCharacterCount;
+	QString m_strErrorMessage;
+	// Whether the error happened in a page (so offset() and sampleIndex() tell where).
+	bool m_bReadError;
+	quint64 m_uErrorOffset;
+	quint64 m_uErrorIndex;
+};
+
+#endif
@@ -0,0 +1,360 @@
+#include <QtGlobal>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <QDir>
+#include <QFile>
+#include <QLockFile>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include "QxEncodedCache.h"
+#include "QxGntReader.h"
+#include "QxHash.h"
+
+const qint64 QxEncodedCache::DefaultSizeLimit;
+
+// Index of the cache, one "key size last-use" line per image.
+static const QString g_IndexFileName = "index.txt";
+// Taken by the processes reading or saving the index.
+static const QString g_IndexLockFileName = "index.lock";
+// sync() saves the index at most this often (ms).
+static const qint64 g_iSaveInterval = 60 * 1000;
+// Images are spread over 256 sub-folders named after the first byte of their key.
+static const int g_iFolderCount = 256;
+
+QxEncodedCache::QxEncodedCache()
+	: m_iSizeLimit(DefaultSizeLimit)
+	, m_uUseClock(0)
+	, m_iTotalSize(0)
+	, m_bIndexChanged(false)
+{
+	m_uKeySeeds[0] = 0;
+	m_uKeySeeds[1] = 0;
+}
+
+QxEncodedCache::~QxEncodedCache()
+{
+	close();
+}
+
+//Open (or create) the cache in strCachePath for the images of settings.
+bool QxEncodedCache::open(const QString& strCachePath, const QxDecodeSettings& settings, qint64 iSizeLimit /*= DefaultSizeLimit*/)
+{
+	close();
+	m_strError.clear();
+	for (int i = 0; i != g_iFolderCount; ++i)
+	{
+		if (!QDir().mkpath(strCachePath + QString("/%1").arg(i, 2, 16, QChar('0'))))
+		{
+			m_strError = "Can not create the cache folder " + strCachePath;
+			return false;
+		}
+	}
+	m_strCachePath = strCachePath;
+	m_strSuffix = "." + settings.imageFormat;
+	m_iSizeLimit = iSizeLimit;
+
+	// Everything which changes the pixels or the bytes of the encoded image, but the sizes which are part of each key.
+	// QxSampleProcessor resizes the sample with bilinear interpolation, then downsamples smaller sizes with area interpolation.
+	QByteArray description;
+	QTextStream stream(&description);
+	stream << "format=" << settings.imageFormat << ":" << settings.iPngBitDepth << ";interpolation=linear,area;invert=" << settings.bInvert << ";binarize=" << settings.binarizeMode << ":" << settings.iThreshold
+		<< ";augment=" << settings.dMaxRotation << ":" << settings.dMaxScale << ":" << settings.dMaxShear << ":" << settings.dMaxShift
+		<< ":" << settings.dElasticAlpha << ":" << settings.dElasticSigma << ":" << settings.iMaxStrokeChange;
+	stream.flush();
+	m_uKeySeeds[0] = qxHash64(description, 0);
+	m_uKeySeeds[1] = qxHash64(description, 1);
+
+	m_iHitCount.store(0);
+	m_iMissCount.store(0);
+	if (!loadIndex())
+	{
+		m_strCachePath.clear();
+		return false;
+	}
+	m_bIndexChanged = false;
+	m_SaveTimer.start();
+	return true;
+}
+
+//Save the index, after evicting the images over the size limit.
+void QxEncodedCache::close()
+{
+	if (!isOpen())
+	{
+		return;
+	}
+	QMutexLocker locker(&m_Mutex);
+	saveIndex();
+	m_strCachePath.clear();
+	m_Entries.clear();
+	m_UseOrder.clear();
+	m_uUseClock = 0;
+	m_iTotalSize = 0;
+}
+
+//Save the index when it changed and was last saved more than a minute ago, or now with bForce.
+void QxEncodedCache::sync(bool bForce /*= false*/)
+{
+	if (!isOpen())
+	{
+		return;
+	}
+	QMutexLocker locker(&m_Mutex);
+	if (m_bIndexChanged && (bForce || m_SaveTimer.elapsed() >= g_iSaveInterval))
+	{
+		saveIndex();
+	}
+}
+
+bool QxEncodedCache::isOpen() const
+{
+	return !m_strCachePath.isEmpty();
+}
+
+QString QxEncodedCache::errorString() const
+{
+	return m_strError;
+}
+
+//Key of a processed sample: 32 hexadecimal digits.
+QByteArray QxEncodedCache::key(const QxGntRecord& record, const QList<int>& sides, int iVariant, quint64 uVariantSeed) const
+{
+	// Variant 0 is the original sample, whatever its seed.
+	quint64 uSampleSeed = qxMix64(quint64(record.uWidth) << 32 | record.uHeight) ^ (iVariant ? qxMix64(uVariantSeed) : 0);
+	for (QList<int>::const_iterator itr = sides.begin(); itr != sides.end(); ++itr)
+	{
+		uSampleSeed = qxMix64(uSampleSeed ^ quint64(*itr));
+	}
+	quint64 uHigh = qxHash64(record.bitmap, m_uKeySeeds[0] ^ uSampleSeed);
+	quint64 uLow = qxHash64(record.bitmap, m_uKeySeeds[1] ^ uSampleSeed);
+	return QByteArray::number(uHigh, 16).rightJustified(16, '0') + QByteArray::number(uLow, 16).rightJustified(16, '0');
+}
+
+//Put the cached image of key at strFileName.
+bool QxEncodedCache::fetch(const QByteArray& key, const QString& strFileName)
+{
+	{
+		QMutexLocker locker(&m_Mutex);
+		QHash<QByteArray, Entry>::iterator itr = m_Entries.find(key);
+		if (itr == m_Entries.end())
+		{
+			m_iMissCount.ref();
+			return false;
+		}
+		touch(key, *itr);
+	}
+	// The file system operations run without the lock, an image evicted meanwhile (by another process too) is just a miss.
+	if (!linkFile(entryFileName(key), strFileName))
+	{
+		QMutexLocker locker(&m_Mutex);
+		QHash<QByteArray, Entry>::iterator itr = m_Entries.find(key);
+		if (itr != m_Entries.end() && !QFile::exists(entryFileName(key)))
+		{
+			m_UseOrder.remove(itr->uLastUse);
+			m_iTotalSize -= itr->iSize;
+			m_Entries.erase(itr);
+		}
+		m_iMissCount.ref();
+		return false;
+	}
+	m_iHitCount.ref();
+	return true;
+}
+
+//Add the image file strFileName to the cache.
+void QxEncodedCache::store(const QByteArray& key, const QString& strFileName)
+{
+	qint64 iSize = QFile(strFileName).size();
+	{
+		// The entry is reserved first, so that the same sample met twice is only stored once.
+		QMutexLocker locker(&m_Mutex);
+		if (m_Entries.contains(key) || iSize <= 0 || iSize > m_iSizeLimit)
+		{
+			return;
+		}
+		Entry& entry = m_Entries[key];
+		entry.iSize = iSize;
+		entry.uLastUse = 0;
+		touch(key, entry);
+		m_iTotalSize += iSize;
+		evict(m_iSizeLimit);
+	}
+	if (!linkFile(strFileName, entryFileName(key)))
+	{
+		QMutexLocker locker(&m_Mutex);
+		QHash<QByteArray, Entry>::iterator itr = m_Entries.find(key);
+		if (itr != m_Entries.end())
+		{
+			m_UseOrder.remove(itr->uLastUse);
+			m_iTotalSize -= itr->iSize;
+			m_Entries.erase(itr);
+		}
+	}
+}
+
+int QxEncodedCache::hitCount() const
+{
+	return m_iHitCount.load();
+}
+
+int QxEncodedCache::missCount() const
+{
+	return m_iMissCount.load();
+}
+
+QString QxEncodedCache::entryFileName(const QByteArray& key) const
+{
+	return m_strCachePath + "/" + QString::fromLatin1(key.left(2)) + "/" + QString::fromLatin1(key) + m_strSuffix;
+}
+
+//Update the last use of an entry.
+void QxEncodedCache::touch(const QByteArray& key, Entry& entry)
+{
+	m_UseOrder.remove(entry.uLastUse);
+	entry.uLastUse = ++m_uUseClock;
+	m_UseOrder.insert(entry.uLastUse, key);
+	m_bIndexChanged = true;
+}
+
+//Remove the least recently used images until the cache fits in iSizeLimit.
+void QxEncodedCache::evict(qint64 iSizeLimit)
+{
+	while (m_iTotalSize > iSizeLimit && !m_UseOrder.isEmpty())
+	{
+		QByteArray key = m_UseOrder.take(m_UseOrder.firstKey());
+		// Output images linked to the file keep their content, only the cache's link is removed.
+		QFile::remove(entryFileName(key));
+		m_iTotalSize -= m_Entries.take(key).iSize;
+	}
+}
+
+//Read the index file, keeping the images whose file is still in the cache.
+bool QxEncodedCache::readIndex(QList<QByteArray>& keys, QHash<QByteArray, Entry>& entries) const
+{
+	QFile file(m_strCachePath + "/" + g_IndexFileName);
+	if (!file.exists())
+	{
+		return true;
+	}
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+	// The index lists the images from the least to the most recently used.
+	while (!file.atEnd())
+	{
+		QList<QByteArray> fields = file.readLine().trimmed().split(' ');
+		if (fields.size() != 3 || entries.contains(fields.at(0)))
+		{
+			continue;
+		}
+		Entry entry;
+		entry.iSize = fields.at(1).toLongLong();
+		entry.uLastUse = fields.at(2).toULongLong();
+		if (entry.iSize <= 0 || !QFile::exists(entryFileName(fields.at(0))))
+		{
+			continue;
+		}
+		keys.append(fields.at(0));
+		entries.insert(fields.at(0), entry);
+	}
+	return true;
+}
+
+bool QxEncodedCache::loadIndex()
+{
+	QLockFile lockFile(m_strCachePath + "/" + g_IndexLockFileName);
+	QList<QByteArray> keys;
+	QHash<QByteArray, Entry> entries;
+	if (!lockFile.lock() || !readIndex(keys, entries))
+	{
+		m_strError = QString("Can not read the index of the cache %1.").arg(m_strCachePath);
+		return false;
+	}
+	// the clock restarts from 1 on each load
+	for (QList<QByteArray>::const_iterator itr = keys.begin(); itr != keys.end(); ++itr)
+	{
+		Entry entry = entries.value(*itr);
+		entry.uLastUse = 0;
+		touch(*itr, m_Entries.insert(*itr, entry).value());
+		m_iTotalSize += entry.iSize;
+	}
+	return true;
+}
+
+//Merge the index with the one on disk, evict the images over the size limit and save it, all under the lock file.
+bool QxEncodedCache::saveIndex()
+{
+	QLockFile lockFile(m_strCachePath + "/" + g_IndexLockFileName);
+	if (!lockFile.lock())
+	{
+		return false;
+	}
+
+	// The images stored by the other processes since the index was loaded are added. Both clocks went on from the
+	// same load, so their last uses are interleaved by clock value, then the clock restarts from 1.
+	QList<QByteArray> savedKeys;
+	QHash<QByteArray, Entry> savedEntries;
+	readIndex(savedKeys, savedEntries);
+	QMultiMap<quint64, QByteArray> useOrder;
+	for (QMap<quint64, QByteArray>::const_iterator itr = m_UseOrder.begin(); itr != m_UseOrder.end(); ++itr)
+	{
+		useOrder.insert(itr.key(), itr.value());
+	}
+	for (QList<QByteArray>::const_iterator itr = savedKeys.begin(); itr != savedKeys.end(); ++itr)
+	{
+		if (!m_Entries.contains(*itr))
+		{
+			const Entry& entry = savedEntries.value(*itr);
+			useOrder.insert(entry.uLastUse, *itr);
+			m_Entries.insert(*itr, entry);
+			m_iTotalSize += entry.iSize;
+		}
+	}
+	m_UseOrder.clear();
+	m_uUseClock = 0;
+	for (QMultiMap<quint64, QByteArray>::const_iterator itr = useOrder.begin(); itr != useOrder.end(); ++itr)
+	{
+		Entry& entry = m_Entries[itr.value()];
+		entry.uLastUse = 0;
+		touch(itr.value(), entry);
+	}
+	evict(m_iSizeLimit);
+
+	// written to a temporary file first, so that a process killed meanwhile leaves the previous index
+	QSaveFile file(m_strCachePath + "/" + g_IndexFileName);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		return false;
+	}
+	for (QMap<quint64, QByteArray>::const_iterator itr = m_UseOrder.begin(); itr != m_UseOrder.end(); ++itr)
+	{
+		file.write(itr.value() + " " + QByteArray::number(m_Entries.value(itr.value()).iSize) + " " + QByteArray::number(itr.key()) + "\n");
+	}
+	if (!file.commit())
+	{
+		return false;
+	}
+	m_bIndexChanged = false;
+	m_SaveTimer.start();
+	return true;
+}
+
+//Hard link strSource to strTarget, or copy it when linking is not possible (e.g. different file systems).
+bool QxEncodedCache::linkFile(const QString& strSource, const QString& strTarget)
+{
+	QFile::remove(strTarget);
+#ifdef Q_OS_WIN
+	bool bLinked = CreateHardLinkW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(strTarget).utf16()),
+		reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(strSource).utf16()), NULL) != 0;
+#else
+	bool bLinked = ::link(QFile::encodeName(strSource).constData(), QFile::encodeName(strTarget).constData()) == 0;
+#endif
+	return bLinked || QFile::copy(strSource, strTarget);
+}
@@ -0,0 +1,102 @@
+#ifndef _QX_ENCODED_CACHE_H_
+#define _QX_ENCODED_CACHE_H_
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+
+#include "QxDecodeSettings.h"
+
+struct QxGntRecord;
+
+/*
+	On-disk cache of encoded image files, shared by the decodings of the same samples with the same image settings.
+	The key of an image is a 128-bit hash of the raw sample bitmap and of everything that changes its pixels or bytes
+	(sizes, format, interpolation, binarization, inversion, augmentation parameters and seed), so exports which only
+	differ in application type, split or label layout find all their images in the cache.
+	Images are hard linked between the cache and the output folders (copied when the cache is on another file system),
+	thus a hit costs a link instead of a resize and an encoding.
+	The cache is kept under a size limit by evicting the least recently used images, its index (key, size and last use
+	of each image) is saved in the cache folder by sync() between batches and by close(). Several processes may share
+	the cache (e.g. the shards of an export): the index is saved under a lock file, merged with the images the other
+	processes saved since. fetch() and store() are thread-safe.
+*/
+class QxEncodedCache
+{
+public:
+	static const qint64 DefaultSizeLimit = Q_INT64_C(4096) * 1024 * 1024;
+
+	QxEncodedCache();
+	~QxEncodedCache();
+
+	// Open (or create) the cache in strCachePath for the images of settings. Return false and set errorString() on error.
+	bool open(const QString& strCachePath, const QxDecodeSettings& settings, qint64 iSizeLimit = DefaultSizeLimit);
+	// Save the index, after evicting the images over the size limit.
+	void close();
+	// Save the index when it changed and was last saved more than a minute ago, or now with bForce.
+	void sync(bool bForce = false);
+	bool isOpen() const;
+	QString errorString() const;
+
+	// Key of a processed sample, see QxSampleProcessor::process(). sides are the successive sides the sample is resized to
+	// (a single one unless it's downsampled from a larger size), the last one being the side of the image.
+	QByteArray key(const QxGntRecord& record, const QList<int>& sides, int iVariant, quint64 uVariantSeed) const;
+	// Put the cached image of key at strFileName. Return false when it's not in the cache.
+	bool fetch(const QByteArray& key, const QString& strFileName);
+	// Add the image file strFileName to the cache.
+	void store(const QByteArray& key, const QString& strFileName);
+
+	int hitCount() const;
+	int missCount() const;
+
+private:
+	struct Entry
+	{
+		qint64 iSize;
+		// Value of the use clock at the last use of the image.
+		quint64 uLastUse;
+	};
+
+	QString entryFileName(const QByteArray& key) const;
+	// Update the last use of an entry. Called with the mutex locked.
+	void touch(const QByteArray& key, Entry& entry);
+	// Remove the least recently used images until the cache fits in iSizeLimit. Called with the mutex locked.
+	void evict(qint64 iSizeLimit);
+	// Read the index file into entries, listed from the least to the most recently used in keys.
+	// Only the images whose file is still in the cache are read. Called with the lock file taken.
+	bool readIndex(QList<QByteArray>& keys, QHash<QByteArray, Entry>& entries) const;
+	bool loadIndex();
+	// Merge the index with the one on disk, evict the images over the size limit and save it. Called with the mutex locked.
+	bool saveIndex();
+
+	// Hard link strSource to strTarget, or copy it when linking is not possible.
+	static bool linkFile(const QString& strSource, const QString& strTarget);
+
+private:
+	QString m_strCachePath;
+	QString m_strSuffix;
+	qint64 m_iSizeLimit;
+	// Seeds of the two halves of the keys, derived from the image settings.
+	quint64 m_uKeySeeds[2];
+	QString m_strError;
+
+	mutable QMutex m_Mutex;
+	QHash<QByteArray, Entry> m_Entries;
+	// Key of each entry by last use, the least recently used first.
+	QMap<quint64, QByteArray> m_UseOrder;
+	quint64 m_uUseClock;
+	qint64 m_iTotalSize;
+	// Whether the index changed since it was saved, and the time since it was.
+	bool m_bIndexChanged;
+	QElapsedTimer m_SaveTimer;
+
+	QAtomicInt m_iHitCount;
+	QAtomicInt m_iMissCount;
+};
+
+#endif
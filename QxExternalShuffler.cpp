@@ -0,0 +1,293 @@
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtEndian>
+
+#include "QxExternalShuffler.h"
+#include "QxHash.h"
+
+const int QxExternalShuffler::BucketCount;
+const qint64 QxExternalShuffler::DefaultMemoryBudget;
+
+// Size of the length in front of each record in the bucket files.
+static const int g_iLengthSize = sizeof(quint32);
+// Buckets still over the budget after this many splits (i.e. a few huge records) are loaded anyway.
+static const int g_iMaxSplitDepth = 4;
+
+QxExternalShuffler::QxExternalShuffler()
+	: m_uSeed(0)
+	, m_iMemoryBudget(DefaultMemoryBudget)
+	, m_iBufferSize(0)
+	, m_uRecordCount(0)
+	, m_bReading(false)
+	, m_iNextRecord(0)
+{
+}
+
+QxExternalShuffler::~QxExternalShuffler()
+{
+	close();
+}
+
+//Start a new shuffle, with the temporary bucket files in a new sub-folder of strTempPath.
+bool QxExternalShuffler::open(const QString& strTempPath, quint64 uSeed, qint64 iMemoryBudget /*= DefaultMemoryBudget*/)
+{
+	close();
+	m_pTempDir.reset(new QTemporaryDir(strTempPath + "/shuffle-XXXXXX"));
+	if (!m_pTempDir->isValid())
+	{
+		m_pTempDir.reset();
+		setError("Can not create a temporary folder in " + strTempPath);
+		return false;
+	}
+	m_uSeed = uSeed;
+	m_iMemoryBudget = iMemoryBudget;
+	// A quarter of the budget at most for the write buffers, the rest for the bucket being shuffled.
+	m_iBufferSize = int(qBound(qint64(4 * 1024), iMemoryBudget / (4 * BucketCount), qint64(64 * 1024)));
+	createBuckets(m_Buckets, "bucket");
+	return true;
+}
+
+//Remove the temporary files.
+void QxExternalShuffler::close()
+{
+	m_pTempDir.reset();
+	m_Buckets.clear();
+	m_uRecordCount = 0;
+	m_strError.clear();
+	m_bReading = false;
+	m_PendingFiles.clear();
+	m_PendingDepths.clear();
+	m_CurrentBucket.clear();
+	m_RecordOffsets.clear();
+	m_iNextRecord = 0;
+}
+
+bool QxExternalShuffler::isOpen() const
+{
+	return !m_pTempDir.isNull();
+}
+
+bool QxExternalShuffler::append(const char* pData, int iSize)
+{
+	if (!isOpen() || m_bReading || hasError())
+	{
+		return false;
+	}
+	// The bucket only depends on the seed and the position of the record.
+	int iBucket = int(qxMix64(qxMix64(m_uSeed) + m_uRecordCount) % BucketCount);
+	++m_uRecordCount;
+	return appendToBucket(m_Buckets[iBucket], pData, iSize);
+}
+
+bool QxExternalShuffler::append(const QByteArray& record)
+{
+	return append(record.constData(), record.size());
+}
+
+quint64 QxExternalShuffler::recordCount() const
+{
+	return m_uRecordCount;
+}
+
+//Get the records back in shuffled order, one after another.
+bool QxExternalShuffler::readRecord(QByteArray& record)
+{
+	if (!isOpen() || hasError())
+	{
+		return false;
+	}
+	if (!m_bReading)
+	{
+		m_bReading = true;
+		for (QVector<Bucket>::iterator itr = m_Buckets.begin(); itr != m_Buckets.end(); ++itr)
+		{
+			if (!flushBucket(*itr))
+			{
+				return false;
+			}
+			if (itr->iFileSize)
+			{
+				m_PendingFiles.append(itr->strFileName);
+				m_PendingDepths.append(0);
+			}
+		}
+		m_Buckets.clear();
+	}
+
+	while (m_iNextRecord == m_RecordOffsets.size())
+	{
+		if (!loadNextBucket())
+		{
+			return false;
+		}
+	}
+	int iOffset = m_RecordOffsets[m_iNextRecord++];
+	quint32 uSize = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(m_CurrentBucket.constData()) + iOffset);
+	record = QByteArray(m_CurrentBucket.constData() + iOffset + g_iLengthSize, int(uSize));
+	return true;
+}
+
+bool QxExternalShuffler::hasError() const
+{
+	return !m_strError.isEmpty();
+}
+
+QString QxExternalShuffler::errorString() const
+{
+	return m_strError;
+}
+
+//Create BucketCount empty buckets in the temporary folder, named after strPrefix.
+void QxExternalShuffler::createBuckets(QVector<Bucket>& buckets, const QString& strPrefix) const
+{
+	buckets.resize(BucketCount);
+	for (int i = 0; i != BucketCount; ++i)
+	{
+		buckets[i].strFileName = m_pTempDir->path() + "/" + strPrefix + "-" + QString::number(i);
+		buckets[i].buffer.clear();
+		buckets[i].iFileSize = 0;
+	}
+}
+
+//Append a length prefixed record to a bucket, writing its buffer to the file when it is full.
+bool QxExternalShuffler::appendToBucket(Bucket& bucket, const char* pData, int iSize)
+{
+	uchar length[g_iLengthSize];
+	qToLittleEndian(quint32(iSize), length);
+	bucket.buffer.append(reinterpret_cast<const char*>(length), g_iLengthSize);
+	bucket.buffer.append(pData, iSize);
+	return bucket.buffer.size() < m_iBufferSize || flushBucket(bucket);
+}
+
+bool QxExternalShuffler::flushBucket(Bucket& bucket)
+{
+	if (bucket.buffer.isEmpty())
+	{
+		return true;
+	}
+	// The files are only open while writing, so that hundreds of buckets don't use hundreds of file handles.
+	QFile file(bucket.strFileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append) || file.write(bucket.buffer) != bucket.buffer.size())
+	{
+		setError(QString("Can not write temporary file %1: %2").arg(bucket.strFileName).arg(file.errorString()));
+		return false;
+	}
+	bucket.iFileSize += bucket.buffer.size();
+	bucket.buffer.clear();
+	return true;
+}
+
+//Move to the next bucket and shuffle it in memory, splitting buckets over the budget first.
+bool QxExternalShuffler::loadNextBucket()
+{
+	m_CurrentBucket.clear();
+	m_RecordOffsets.clear();
+	m_iNextRecord = 0;
+	while (!m_PendingFiles.isEmpty())
+	{
+		QString strFileName = m_PendingFiles.takeFirst();
+		int iDepth = m_PendingDepths.takeFirst();
+		QFile file(strFileName);
+		if (file.size() > m_iMemoryBudget && iDepth < g_iMaxSplitDepth)
+		{
+			if (!splitBucket(strFileName, iDepth))
+			{
+				return false;
+			}
+			continue;
+		}
+
+		if (!file.open(QIODevice::ReadOnly))
+		{
+			setError(QString("Can not read temporary file %1: %2").arg(strFileName).arg(file.errorString()));
+			return false;
+		}
+		m_CurrentBucket = file.readAll();
+		file.remove();
+
+		// Index the records, then shuffle the index (Fisher-Yates) with a seed of its own for each bucket.
+		const uchar* pData = reinterpret_cast<const uchar*>(m_CurrentBucket.constData());
+		int iOffset = 0;
+		while (iOffset != m_CurrentBucket.size())
+		{
+			if (m_CurrentBucket.size() - iOffset < g_iLengthSize
+				|| qFromLittleEndian<quint32>(pData + iOffset) > quint32(m_CurrentBucket.size() - iOffset - g_iLengthSize))
+			{
+				setError("Corrupt temporary file " + strFileName);
+				return false;
+			}
+			m_RecordOffsets.append(iOffset);
+			iOffset += g_iLengthSize + int(qFromLittleEndian<quint32>(pData + iOffset));
+		}
+		const quint64 uBucketSeed = qxHash64(QFileInfo(strFileName).fileName().toUtf8(), m_uSeed);
+		for (int i = m_RecordOffsets.size() - 1; i > 0; --i)
+		{
+			int j = int(qxMix64(uBucketSeed + quint64(i)) % quint64(i + 1));
+			qSwap(m_RecordOffsets[i], m_RecordOffsets[j]);
+		}
+		if (!m_RecordOffsets.isEmpty())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//Distribute the records of an oversized bucket over new buckets, which replace it in the reading order.
+bool QxExternalShuffler::splitBucket(const QString& strFileName, int iDepth)
+{
+	QFile file(strFileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		setError(QString("Can not read temporary file %1: %2").arg(strFileName).arg(file.errorString()));
+		return false;
+	}
+
+	QVector<Bucket> buckets;
+	createBuckets(buckets, QFileInfo(strFileName).fileName());
+	const quint64 uSplitSeed = qxHash64(QFileInfo(strFileName).fileName().toUtf8(), m_uSeed);
+	quint64 uIndex = 0;
+	QByteArray record;
+	while (!file.atEnd())
+	{
+		uchar length[g_iLengthSize];
+		if (file.read(reinterpret_cast<char*>(length), g_iLengthSize) != g_iLengthSize)
+		{
+			setError("Corrupt temporary file " + strFileName);
+			return false;
+		}
+		record = file.read(qFromLittleEndian<quint32>(length));
+		if (quint32(record.size()) != qFromLittleEndian<quint32>(length))
+		{
+			setError("Corrupt temporary file " + strFileName);
+			return false;
+		}
+		int iBucket = int(qxMix64(uSplitSeed + uIndex++) % BucketCount);
+		if (!appendToBucket(buckets[iBucket], record.constData(), record.size()))
+		{
+			return false;
+		}
+	}
+	file.remove();
+
+	// The new buckets are read right away, in order, in place of the split one.
+	for (int i = BucketCount - 1; i >= 0; --i)
+	{
+		if (!flushBucket(buckets[i]))
+		{
+			return false;
+		}
+		if (buckets[i].iFileSize)
+		{
+			m_PendingFiles.prepend(buckets[i].strFileName);
+			m_PendingDepths.prepend(iDepth + 1);
+		}
+	}
+	return true;
+}
+
+void QxExternalShuffler::setError(const QString& strError)
+{
+	m_strError = strError;
+}
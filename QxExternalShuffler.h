@@ -0,0 +1,81 @@
+#ifndef _QX_EXTERNAL_SHUFFLER_H_
+#define _QX_EXTERNAL_SHUFFLER_H_
+
+#include <QByteArray>
+#include <QScopedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QTemporaryDir;
+
+/*
+	Seeded shuffle of more records than fit in memory (bucket shuffle).
+	append() sends each record to one of BucketCount temporary bucket files picked at random, through small write buffers.
+	Reading loads one bucket at a time and shuffles it in memory, buckets larger than the memory budget are first
+	split again into smaller buckets. Both the write buffers and the loaded bucket stay within the memory budget,
+	and the same seed and the same sequence of records always give the same order.
+*/
+class QxExternalShuffler
+{
+public:
+	static const int BucketCount = 256;
+	static const qint64 DefaultMemoryBudget = 256 * 1024 * 1024;
+
+	QxExternalShuffler();
+	~QxExternalShuffler();
+
+	// Start a new shuffle, with the temporary bucket files in a new sub-folder of strTempPath.
+	bool open(const QString& strTempPath, quint64 uSeed, qint64 iMemoryBudget = DefaultMemoryBudget);
+	// Remove the temporary files.
+	void close();
+	bool isOpen() const;
+
+	bool append(const char* pData, int iSize);
+	bool append(const QByteArray& record);
+	quint64 recordCount() const;
+
+	// Get the records back in shuffled order, one after another. Return false at the end or when an error occurred.
+	// No record can be appended once reading started.
+	bool readRecord(QByteArray& record);
+	bool hasError() const;
+	QString errorString() const;
+
+private:
+	struct Bucket
+	{
+		QString strFileName;
+		QByteArray buffer;
+		qint64 iFileSize;
+	};
+
+	// Create BucketCount empty buckets in the temporary folder, named after strPrefix.
+	void createBuckets(QVector<Bucket>& buckets, const QString& strPrefix) const;
+	// Append a length prefixed record to a bucket, writing its buffer to the file when it is full.
+	bool appendToBucket(Bucket& bucket, const char* pData, int iSize);
+	bool flushBucket(Bucket& bucket);
+	// Move to the next bucket and shuffle it in memory, splitting buckets over the budget first.
+	bool loadNextBucket();
+	// Distribute the records of an oversized bucket over new buckets, which replace it in the reading order.
+	bool splitBucket(const QString& strFileName, int iDepth);
+	void setError(const QString& strError);
+
+private:
+	QScopedPointer<QTemporaryDir> m_pTempDir;
+	quint64 m_uSeed;
+	qint64 m_iMemoryBudget;
+	int m_iBufferSize;
+	QVector<Bucket> m_Buckets;
+	quint64 m_uRecordCount;
+	QString m_strError;
+
+	// Reading: bucket files still to read (with their split depth), and the records of the current bucket.
+	bool m_bReading;
+	QStringList m_PendingFiles;
+	QVector<int> m_PendingDepths;
+	QByteArray m_CurrentBucket;
+	QVector<int> m_RecordOffsets;
+	int m_iNextRecord;
+};
+
+#endif
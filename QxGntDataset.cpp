@@ -0,0 +1,223 @@
+#include <limits.h>
+
+#include <QFile>
+
+#include "QxDecompressDevice.h"
+#include "QxGntDataset.h"
+#include "QxGntReader.h"
+
+const int QxGntDataset::MaxImageSide;
+
+//Decompressed files are read in chunks of this size.
+static const qint64 g_iReadChunkSize = 1 << 20;
+
+static inline quint32 readUInt16(const uchar* pData)
+{
+	return pData[0] + quint32(pData[1]) * (1 << 8);
+}
+
+QxGntDataset::QxGntDataset()
+	: m_Processor(QxDecodeSettings())
+{
+}
+
+QxGntDataset::~QxGntDataset()
+{
+	close();
+}
+
+//Map and index the files.
+bool QxGntDataset::open(const QStringList& fileList)
+{
+	close();
+	for (QStringList::const_iterator itr = fileList.begin(); itr != fileList.end(); ++itr)
+	{
+		QxDecompressDevice::Compression compression;
+		if (QxDecompressDevice::compressionOf(*itr, compression))
+		{
+			if (!readCompressedFile(*itr))
+			{
+				return false;
+			}
+			continue;
+		}
+
+		QFile* pFile = new QFile(*itr);
+		m_MappedFiles.append(pFile);
+		if (!pFile->open(QIODevice::ReadOnly))
+		{
+			m_strError = QString("%1: %2").arg(*itr).arg(pFile->errorString());
+			return false;
+		}
+		const quint64 uFileSize = pFile->size();
+		const uchar* pData = uFileSize ? pFile->map(0, uFileSize) : NULL;
+		if (uFileSize && !pData)
+		{
+			// Mapping may not be supported by the file system, keep the file in memory instead.
+			if (uFileSize > quint64(INT_MAX))
+			{
+				m_strError = QString("%1: can't be memory-mapped, and is too large to be read into memory (over 2 GB).").arg(*itr);
+				return false;
+			}
+			m_DecompressedFiles.append(pFile->readAll());
+			if (quint64(m_DecompressedFiles.last().size()) != uFileSize)
+			{
+				m_strError = QString("%1: %2").arg(*itr).arg(pFile->errorString());
+				return false;
+			}
+			pData = reinterpret_cast<const uchar*>(m_DecompressedFiles.last().constData());
+		}
+		if (!indexFile(*itr, pData, uFileSize))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void QxGntDataset::close()
+{
+	qDeleteAll(m_MappedFiles);
+	m_MappedFiles.clear();
+	m_DecompressedFiles.clear();
+	m_Samples.clear();
+	m_LabelCodes.clear();
+	m_CodeLabels.clear();
+	m_strError.clear();
+}
+
+QString QxGntDataset::errorString() const
+{
+	return m_strError;
+}
+
+quint64 QxGntDataset::sampleCount() const
+{
+	return m_Samples.size();
+}
+
+quint32 QxGntDataset::classCount() const
+{
+	return m_LabelCodes.size();
+}
+
+//Tag code of each label.
+const QVector<quint32>& QxGntDataset::labelCodes() const
+{
+	return m_LabelCodes;
+}
+
+quint32 QxGntDataset::label(quint64 uIndex) const
+{
+	return m_Samples[uIndex].uLabel;
+}
+
+quint32 QxGntDataset::tagCode(quint64 uIndex) const
+{
+	return readUInt16(m_Samples[uIndex].pRecord + 4);
+}
+
+//Raw bitmap of a sample, valid until close().
+const uchar* QxGntDataset::bitmap(quint64 uIndex, quint32& uWidth, quint32& uHeight) const
+{
+	const uchar* pRecord = m_Samples[uIndex].pRecord;
+	uWidth = readUInt16(pRecord + 6);
+	uHeight = readUInt16(pRecord + 8);
+	return pRecord + QxGntReader::RecordHeaderSize;
+}
+
+//Pad the sample to a white square and resize it to iSide x iSide like the decoder does, writing the pixels into pDst.
+void QxGntDataset::render(quint64 uIndex, int iSide, uchar* pDst) const
+{
+	QxGntRecord record;
+	const uchar* pBitmap = bitmap(uIndex, record.uWidth, record.uHeight);
+	record.uTagCode = tagCode(uIndex);
+	// A view on the mapped sample, only its data is read.
+	record.bitmap = QByteArray::fromRawData(reinterpret_cast<const char*>(pBitmap), int(qMin(quint64(record.uWidth) * record.uHeight, quint64(INT_MAX))));
+	QVector<cv::Mat> images;
+	m_Processor.process(record, 0, 0, QList<int>() << iSide, images);
+	cv::Mat dst(iSide, iSide, CV_8UC1, pDst);
+	images.first().copyTo(dst);
+}
+
+//Index a mapped or decompressed file.
+bool QxGntDataset::indexFile(const QString& strFileName, const uchar* pData, quint64 uSize)
+{
+	quint64 uOffset = 0;
+	quint64 uIndex = 0;
+	while (uOffset != uSize)
+	{
+		QString strError;
+		QxGntRecord record;
+		quint32 uDataLen = 0;
+		if (uSize - uOffset < QxGntReader::RecordHeaderSize)
+		{
+			strError = "Unexpected end of file in the header of a sample.";
+		}
+		else if (QxGntReader::parseHeader(pData + uOffset, record, uDataLen, strError) && uDataLen > uSize - uOffset)
+		{
+			strError = QString("Sample needs %1 bytes but only %2 bytes are left, the file may be truncated.").arg(uDataLen).arg(uSize - uOffset);
+		}
+		if (!strError.isEmpty())
+		{
+			m_strError = QString("%1: sample %2 at byte offset %3: %4").arg(strFileName).arg(uIndex).arg(uOffset).arg(strError);
+			return false;
+		}
+
+		// Labels start from 0 and are consecutive, in the order the tag codes are first met.
+		QHash<quint32, quint32>::const_iterator itrLabel = m_CodeLabels.constFind(record.uTagCode);
+		if (itrLabel == m_CodeLabels.constEnd())
+		{
+			itrLabel = m_CodeLabels.insert(record.uTagCode, m_LabelCodes.size());
+			m_LabelCodes.append(record.uTagCode);
+		}
+		Sample sample;
+		sample.pRecord = pData + uOffset;
+		sample.uLabel = itrLabel.value();
+		m_Samples.append(sample);
+
+		uOffset += uDataLen;
+		++uIndex;
+	}
+	return true;
+}
+
+bool QxGntDataset::readCompressedFile(const QString& strFileName)
+{
+	QxDecompressDevice::Compression compression;
+	QxDecompressDevice::compressionOf(strFileName, compression);
+	QxDecompressDevice device(strFileName, compression);
+	if (!device.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+	{
+		m_strError = QString("%1: %2").arg(strFileName).arg(device.errorString());
+		return false;
+	}
+
+	QByteArray data;
+	for (;;)
+	{
+		int iSize = data.size();
+		if (iSize > INT_MAX - g_iReadChunkSize)
+		{
+			m_strError = QString("%1: decompresses to more than 2 GB, which can't be held in memory. "
+				"Decompress it to a .gnt file, which is memory-mapped instead.").arg(strFileName);
+			return false;
+		}
+		data.resize(iSize + int(g_iReadChunkSize));
+		qint64 iReadSize = device.read(data.data() + iSize, g_iReadChunkSize);
+		if (iReadSize < 0)
+		{
+			m_strError = QString("%1: %2").arg(strFileName).arg(device.errorString());
+			return false;
+		}
+		data.resize(iSize + int(iReadSize));
+		if (iReadSize == 0)
+		{
+			break;
+		}
+	}
+	device.close();
+
+	m_DecompressedFiles.append(data);
+	return indexFile(strFileName, reinterpret_cast<const uchar*>(m_DecompressedFiles.last().constData()), data.size());
+}
@@ -0,0 +1,70 @@
+#ifndef _QX_GNT_DATASET_H_
+#define _QX_GNT_DATASET_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "QxSampleProcessor.h"
+
+class QFile;
+
+/*
+	Random access to all the samples of a list of .gnt files, for consumers which read samples directly instead of image files.
+	Uncompressed files are memory-mapped, compressed ones (.gnt.gz, .gnt.zst) are decompressed into memory once.
+	Labels are given in the order the tag codes are first met, like the label mapping written by the decoder.
+	Once open() returned, all the const member functions are thread-safe, and only render() allocates (the temporary
+	images of the sample).
+*/
+class QxGntDataset
+{
+public:
+	// Largest side of the images rendered by render().
+	static const int MaxImageSide = 1024;
+
+	QxGntDataset();
+	~QxGntDataset();
+
+	// Map and index the files. Return false and set errorString() if a file can't be read or holds a corrupt sample.
+	bool open(const QStringList& fileList);
+	void close();
+	QString errorString() const;
+
+	quint64 sampleCount() const;
+	quint32 classCount() const;
+	// Tag code of each label.
+	const QVector<quint32>& labelCodes() const;
+
+	quint32 label(quint64 uIndex) const;
+	quint32 tagCode(quint64 uIndex) const;
+	// Raw bitmap of a sample (uHeight rows of uWidth 8-bit pixels, white background), valid until close().
+	const uchar* bitmap(quint64 uIndex, quint32& uWidth, quint32& uHeight) const;
+	/* Pad the sample to a white square and resize it to iSide x iSide through the decoder's QxSampleProcessor with the
+	  default settings, writing the 8-bit pixels into pDst. iSide must be between 1 and MaxImageSide. */
+	void render(quint64 uIndex, int iSide, uchar* pDst) const;
+
+private:
+	// Index a mapped or decompressed file.
+	bool indexFile(const QString& strFileName, const uchar* pData, quint64 uSize);
+	bool readCompressedFile(const QString& strFileName);
+
+private:
+	struct Sample
+	{
+		const uchar* pRecord;
+		quint32 uLabel;
+	};
+
+	QList<QFile*> m_MappedFiles;
+	QList<QByteArray> m_DecompressedFiles;
+	QVector<Sample> m_Samples;
+	QVector<quint32> m_LabelCodes;
+	QHash<quint32, quint32> m_CodeLabels;
+	QString m_strError;
+	QxSampleProcessor m_Processor;
+};
+
+#endif
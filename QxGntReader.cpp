@@ -0,0 +1,307 @@
+#include <limits.h>
+
+#include <QFile>
+
+#include "QxDecompressDevice.h"
+#include "QxGntReader.h"
+#include "QxSampleStore.h"
+
+const quint32 QxGntReader::RecordHeaderSize;
+
+QxGntReader::QxGntReader()
+	: m_bStored(false)
+	, m_uStoredSampleCount(0)
+	, m_iNextStoredChunk(0)
+	, m_iStoredPosition(0)
+	, m_pStore(NULL)
+	, m_bReadError(false)
+	, m_uOffset(0)
+	, m_uIndex(0)
+{
+}
+
+QxGntReader::~QxGntReader()
+{
+	close();
+}
+
+//Names of the files which can be read, to be used in file dialogs.
+QString QxGntReader::fileFilter()
+{
+	return "GNT files (*.gnt *.gnt.gz *.gnt.zst)";
+}
+
+//Decode and check a sample header: the data length must be exactly the header size plus width x height.
+bool QxGntReader::parseHeader(const uchar* pHeader, QxGntRecord& record, quint32& uDataLen, QString& strError)
+{
+	// all the fields are little-endian
+	uDataLen = pHeader[0] + quint32(pHeader[1]) * (1 << 8) + quint32(pHeader[2]) * (1 << 16) + quint32(pHeader[3]) * (1 << 24);
+	record.uTagCode = pHeader[4] + quint32(pHeader[5]) * (1 << 8);
+	record.uWidth = pHeader[6] + quint32(pHeader[7]) * (1 << 8);
+	record.uHeight = pHeader[8] + quint32(pHeader[9]) * (1 << 8);
+
+	quint64 uExpectedLen = RecordHeaderSize + quint64(record.uWidth) * record.uHeight;
+	if (uDataLen != uExpectedLen)
+	{
+		strError = QString("Sample length %1 doesn't match its size %2 x %3 (expected length %4).")
+			.arg(uDataLen).arg(record.uWidth).arg(record.uHeight).arg(uExpectedLen);
+		return false;
+	}
+	return true;
+}
+
+bool QxGntReader::open(const QString& strFileName, QxSampleStore* pStore /*= NULL*/)
+{
+	close();
+	m_strErrorMessage.clear();
+	m_bReadError = false;
+	m_uOffset = 0;
+	m_uIndex = 0;
+	if (pStore && pStore->find(strFileName, m_StoredChunks, m_uStoredSampleCount))
+	{
+		m_bStored = true;
+		m_iNextStoredChunk = 0;
+		m_iStoredPosition = 0;
+		return true;
+	}
+
+	QIODevice::OpenMode mode = QIODevice::ReadOnly;
+	QxDecompressDevice::Compression compression;
+	if (QxDecompressDevice::compressionOf(strFileName, compression))
+	{
+		// The decompressed chunks are buffered already, there's no need for another buffer in QIODevice.
+		m_pDevice.reset(new QxDecompressDevice(strFileName, compression));
+		mode |= QIODevice::Unbuffered;
+	}
+	else
+	{
+		m_pDevice.reset(new QFile(strFileName));
+	}
+
+	if (!m_pDevice->open(mode))
+	{
+		m_strErrorMessage = m_pDevice->errorString();
+		m_pDevice.reset();
+		return false;
+	}
+	m_pStore = pStore;
+	m_strFileName = strFileName;
+	return true;
+}
+
+void QxGntReader::close()
+{
+	if (m_pDevice)
+	{
+		m_pDevice->close();
+		m_pDevice.reset();
+	}
+	m_bStored = false;
+	m_StoredChunks.clear();
+	m_pStoredSamples.clear();
+	stopStoring();
+}
+
+//Read the next sample. Return false at the end of the file or when an error occurred, see hasError().
+bool QxGntReader::readRecord(QxGntRecord& record)
+{
+	if (m_bStored)
+	{
+		return readStoredRecord(record);
+	}
+	if (!m_pDevice || hasError())
+	{
+		return false;
+	}
+
+	uchar header[RecordHeaderSize];
+	qint64 iHeaderSize = readFully(reinterpret_cast<char*>(header), RecordHeaderSize);
+	if (iHeaderSize == 0 && !hasError())
+	{
+		// end of file, the whole file is stored
+		if (m_pStore && !m_StoringSamples.isEmpty())
+		{
+			storeChunk();
+		}
+		if (m_pStore)
+		{
+			m_pStore->insert(m_strFileName, m_StoringChunks, m_uIndex, qint64(m_uOffset));
+			m_pStore = NULL;
+			m_StoringChunks.clear();
+		}
+		return false;
+	}
+	if (iHeaderSize != RecordHeaderSize)
+	{
+		setError("Unexpected end of file in the header of a sample.");
+		return false;
+	}
+
+	quint32 uDataLen = 0;
+	QString strError;
+	if (!parseHeader(header, record, uDataLen, strError))
+	{
+		setError(strError);
+		return false;
+	}
+	record.uOffset = m_uOffset;
+	record.uIndex = m_uIndex;
+
+	qint64 iBitmapSize = uDataLen - RecordHeaderSize;
+	// A consistent but corrupt header may announce more than a QByteArray holds, or than the file has left.
+	if (iBitmapSize > INT_MAX)
+	{
+		setError(QString("Bitmap of %1 x %2 pixels is too large to be read.").arg(record.uWidth).arg(record.uHeight));
+		return false;
+	}
+	if (!m_pDevice->isSequential() && iBitmapSize > m_pDevice->size() - m_pDevice->pos())
+	{
+		setError(QString("Sample needs %1 bytes but only %2 bytes are left, the file may be truncated.")
+			.arg(uDataLen).arg(RecordHeaderSize + m_pDevice->size() - m_pDevice->pos()));
+		return false;
+	}
+	record.bitmap.resize(int(iBitmapSize));
+	if (readFully(record.bitmap.data(), iBitmapSize) != iBitmapSize)
+	{
+		setError("Unexpected end of file in the bitmap of a sample.");
+		return false;
+	}
+
+	if (m_pStore && iBitmapSize > QxSampleStore::ChunkSize)
+	{
+		// its stored form wouldn't fit a chunk
+		stopStoring();
+	}
+	if (m_pStore)
+	{
+		QxSampleStore::appendRecord(m_StoringSamples, record);
+		if (m_StoringSamples.size() >= QxSampleStore::ChunkSize)
+		{
+			storeChunk();
+		}
+	}
+	m_uOffset += uDataLen;
+	++m_uIndex;
+	return true;
+}
+
+bool QxGntReader::hasError() const
+{
+	return !m_strErrorMessage.isEmpty();
+}
+
+//Error message including the index and byte offset of the sample where the error occurred.
+QString QxGntReader::errorString() const
+{
+	if (!m_bReadError)
+	{
+		return m_strErrorMessage;
+	}
+	return QString("%1 (sample %2, byte offset %3)").arg(m_strErrorMessage).arg(m_uIndex).arg(m_uOffset);
+}
+
+//Error message only.
+QString QxGntReader::errorMessage() const
+{
+	return m_strErrorMessage;
+}
+
+quint64 QxGntReader::offset() const
+{
+	return m_uOffset;
+}
+
+quint64 QxGntReader::sampleIndex() const
+{
+	return m_uIndex;
+}
+
+//Read exactly iSize bytes unless the end of the file is reached. Return the number of bytes read.
+qint64 QxGntReader::readFully(char* pData, qint64 iSize)
+{
+	qint64 iReadSize = 0;
+	while (iReadSize < iSize)
+	{
+		qint64 iChunkSize = m_pDevice->read(pData + iReadSize, iSize - iReadSize);
+		if (iChunkSize < 0)
+		{
+			setError(m_pDevice->errorString());
+			break;
+		}
+		if (iChunkSize == 0)
+		{
+			break;
+		}
+		iReadSize += iChunkSize;
+	}
+	return iReadSize;
+}
+
+void QxGntReader::setError(const QString& strError)
+{
+	m_strErrorMessage = strError;
+	m_bReadError = true;
+}
+
+//Read the next sample from the stored chunks, loading them one after another.
+bool QxGntReader::readStoredRecord(QxGntRecord& record)
+{
+	if (hasError())
+	{
+		return false;
+	}
+	while (!m_pStoredSamples || m_iStoredPosition == m_pStoredSamples->size())
+	{
+		if (m_iNextStoredChunk == m_StoredChunks.size())
+		{
+			if (m_uIndex != m_uStoredSampleCount)
+			{
+				setError(QString("The sample store has %1 of the %2 samples of the file.").arg(m_uIndex).arg(m_uStoredSampleCount));
+			}
+			return false;
+		}
+		if (!QxSampleStore::loadChunk(m_StoredChunks.at(m_iNextStoredChunk), m_pStoredSamples))
+		{
+			m_pStoredSamples.clear();
+			setError("Stored samples could not be read back from the spill folder.");
+			return false;
+		}
+		++m_iNextStoredChunk;
+		m_iStoredPosition = 0;
+	}
+	if (!QxSampleStore::readRecord(*m_pStoredSamples, m_iStoredPosition, record))
+	{
+		setError("Corrupt sample in the sample store.");
+		return false;
+	}
+	record.uOffset = m_uOffset;
+	record.uIndex = m_uIndex;
+	m_uOffset += RecordHeaderSize + quint64(record.uWidth) * record.uHeight;
+	++m_uIndex;
+	return true;
+}
+
+//Hand the samples read since the last chunk to the store. Without room for them, the file is not stored.
+void QxGntReader::storeChunk()
+{
+	QxSampleStore::Chunk chunk;
+	if (!m_pStore->makeChunk(m_StoringSamples, chunk))
+	{
+		stopStoring();
+		return;
+	}
+	m_StoringChunks.append(chunk);
+	m_StoringSamples.clear();
+}
+
+//Give up storing the file, giving back the chunks made so far.
+void QxGntReader::stopStoring()
+{
+	if (m_pStore)
+	{
+		m_pStore->release(m_StoringChunks);
+	}
+	m_pStore = NULL;
+	m_StoringChunks.clear();
+	m_StoringSamples.clear();
+}
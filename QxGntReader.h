@@ -0,0 +1,100 @@
+#ifndef _QX_GNT_READER_H_
+#define _QX_GNT_READER_H_
+
+#include <QByteArray>
+#include <QList>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QString>
+
+#include "QxSampleStore.h"
+
+class QIODevice;
+
+/*
+	One character sample of a .gnt file.
+*/
+struct QxGntRecord
+{
+	QxGntRecord() : uTagCode(0), uWidth(0), uHeight(0), uOffset(0), uIndex(0) {}
+
+	quint32 uTagCode;
+	quint32 uWidth;
+	quint32 uHeight;
+	// uHeight rows of uWidth 8-bit grayscale pixels, white (255) background.
+	QByteArray bitmap;
+	// Byte offset of the sample in the (decompressed) file and its index in the file.
+	quint64 uOffset;
+	quint64 uIndex;
+};
+
+/*
+	Read the samples of a .gnt file one after another.
+	Files compressed with gzip (.gnt.gz) or zstd (.gnt.zst) are decompressed on the fly by a separate thread,
+	so they never need to be decompressed to a temporary file first.
+	With a sample store, files already stored are read from the store instead, and the samples of the other files are
+	handed to it in chunks while they are read, the file being stored once read to its end without error.
+*/
+class QxGntReader
+{
+public:
+	QxGntReader();
+	~QxGntReader();
+
+	// Size of the header in front of each sample: data length(4 bytes), tag code(2), width(2) and height(2).
+	static const quint32 RecordHeaderSize = 10;
+
+	// Names of the files which can be read, to be used in file dialogs.
+	static QString fileFilter();
+	// Decode and check a sample header: the data length must be exactly the header size plus width x height.
+	// Return false and set strError for a corrupt header.
+	static bool parseHeader(const uchar* pHeader, QxGntRecord& record, quint32& uDataLen, QString& strError);
+
+	bool open(const QString& strFileName, QxSampleStore* pStore = NULL);
+	void close();
+	// Read the next sample. Return false at the end of the file or when an error occurred, see hasError().
+	bool readRecord(QxGntRecord& record);
+
+	bool hasError() const;
+	// Error message including the index and byte offset of the sample where the error occurred.
+	QString errorString() const;
+	// Error message only.
+	QString errorMessage() const;
+	// Byte offset and index of the next sample, or of the sample which could not be read after an error.
+	quint64 offset() const;
+	quint64 sampleIndex() const;
+
+private:
+	// Read exactly iSize bytes unless the end of the file is reached. Return the number of bytes read.
+	qint64 readFully(char* pData, qint64 iSize);
+	void setError(const QString& strError);
+	// Read the next sample from the chunks of a stored file.
+	bool readStoredRecord(QxGntRecord& record);
+	// Hand the samples read since the last chunk to the store.
+	void storeChunk();
+	// Give up storing the file, giving back the chunks made so far.
+	void stopStoring();
+
+private:
+	QScopedPointer<QIODevice> m_pDevice;
+	// Whether the file is read from the store: its chunks and samples, the next chunk to load, the samples of the
+	// current chunk and the position of the next sample in them.
+	bool m_bStored;
+	QList<QxSampleStore::Chunk> m_StoredChunks;
+	quint64 m_uStoredSampleCount;
+	int m_iNextStoredChunk;
+	QSharedPointer<const QByteArray> m_pStoredSamples;
+	qint64 m_iStoredPosition;
+	// Store the samples read from the file go to, the chunks made so far, and the samples read since.
+	QxSampleStore* m_pStore;
+	QString m_strFileName;
+	QList<QxSampleStore::Chunk> m_StoringChunks;
+	QByteArray m_StoringSamples;
+	QString m_strErrorMessage;
+	// Whether the error happened while reading samples (so offset() and sampleIndex() tell where).
+	bool m_bReadError;
+	quint64 m_uOffset;
+	quint64 m_uIndex;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include <QFile>
+#include <QtConcurrentMap>
+
+#include "QxDecompressDevice.h"
+#include "QxDgrReader.h"
+#include "QxGntReader.h"
+#include "QxGntVerifier.h"
+#include "QxPotReader.h"
+
+//One line report, e.g. "FAIL 1001-c.gnt: sample 12 at byte offset 34567: ..."
+QString QxGntVerifyResult::toString() const
+{
+	if (bOk)
+	{
+		return QString("OK   %1 (%2 samples)").arg(strFileName).arg(uSampleCount);
+	}
+	return QString("FAIL %1: sample %2 at byte offset %3: %4").arg(strFileName).arg(uErrorIndex).arg(uErrorOffset).arg(strError);
+}
+
+//Check a single file.
+QxGntVerifyResult QxGntVerifier::verifyFile(const QString& strFileName)
+{
+	if (QxPotReader::isPotFile(strFileName))
+	{
+		return verifyPotFile(strFileName);
+	}
+	if (QxDgrReader::isDgrFile(strFileName))
+	{
+		return verifyDgrFile(strFileName);
+	}
+	QxDecompressDevice::Compression compression;
+	if (QxDecompressDevice::compressionOf(strFileName, compression))
+	{
+		return verifyCompressedFile(strFileName);
+	}
+
+	QxGntVerifyResult result;
+	result.strFileName = strFileName;
+	QFile file(strFileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		result.strError = file.errorString();
+		return result;
+	}
+
+	// Walking the headers of a mapped file touches only the pages holding them. Fall back to seeking if mapping fails.
+	const quint64 uFileSize = file.size();
+	const uchar* pMappedData = uFileSize ? file.map(0, uFileSize) : NULL;
+	quint64 uOffset = 0;
+	quint64 uIndex = 0;
+	while (uOffset != uFileSize)
+	{
+		result.uSampleCount = uIndex;
+		result.uErrorIndex = uIndex;
+		result.uErrorOffset = uOffset;
+		if (uFileSize - uOffset < QxGntReader::RecordHeaderSize)
+		{
+			result.strError = "Unexpected end of file in the header of a sample.";
+			return result;
+		}
+
+		uchar header[QxGntReader::RecordHeaderSize];
+		const uchar* pHeader = header;
+		if (pMappedData)
+		{
+			pHeader = pMappedData + uOffset;
+		}
+		else if (!file.seek(uOffset) || file.read(reinterpret_cast<char*>(header), QxGntReader::RecordHeaderSize) != QxGntReader::RecordHeaderSize)
+		{
+			result.strError = file.errorString();
+			return result;
+		}
+
+		QxGntRecord record;
+		quint32 uDataLen = 0;
+		if (!QxGntReader::parseHeader(pHeader, record, uDataLen, result.strError))
+		{
+			return result;
+		}
+		if (uDataLen > uFileSize - uOffset)
+		{
+			result.strError = QString("Sample needs %1 bytes but only %2 bytes are left, the file may be truncated.").arg(uDataLen).arg(uFileSize - uOffset);
+			return result;
+		}
+		uOffset += uDataLen;
+		++uIndex;
+	}
+
+	result.bOk = true;
+	result.uSampleCount = uIndex;
+	result.uErrorIndex = 0;
+	result.uErrorOffset = 0;
+	return result;
+}
+
+//Check the files in parallel, using the global thread pool.
+QList<QxGntVerifyResult> QxGntVerifier::verifyFiles(const QStringList& fileList)
+{
+	return QtConcurrent::blockingMapped<QList<QxGntVerifyResult> >(fileList, &QxGntVerifier::verifyFile);
+}
+
+//Compressed files can't be skipped through, so every sample is read.
+QxGntVerifyResult QxGntVerifier::verifyCompressedFile(const QString& strFileName)
+{
+	QxGntVerifyResult result;
+	result.strFileName = strFileName;
+	QxGntReader reader;
+	if (!reader.open(strFileName))
+	{
+		result.strError = reader.errorMessage();
+		return result;
+	}
+
+	QxGntRecord record;
+	while (reader.readRecord(record))
+	{
+	}
+	if (reader.hasError())
+	{
+		result.uSampleCount = reader.sampleIndex();
+		result.uErrorIndex = reader.sampleIndex();
+		result.uErrorOffset = reader.offset();
+		result.strError = reader.errorMessage();
+		return result;
+	}
+	result.bOk = true;
+	result.uSampleCount = reader.sampleIndex();
+	return result;
+}
+
+//The strokes of each .pot sample are parsed, so every sample is read.
+QxGntVerifyResult QxGntVerifier::verifyPotFile(const QString& strFileName)
+{
+	QxGntVerifyResult result;
+	result.strFileName = strFileName;
+	QxPotReader reader;
+	if (!reader.open(strFileName))
+	{
+		result.strError = reader.errorMessage();
+		return result;
+	}
+
+	QxPotSample sample;
+	while (reader.readSample(sample))
+	{
+	}
+	if (reader.hasError())
+	{
+		result.uSampleCount = reader.sampleIndex();
+		result.uErrorIndex = reader.sampleIndex();
+		result.uErrorOffset = reader.offset();
+		result.strError = reader.errorMessage();
+		return result;
+	}
+	result.bOk = true;
+	result.uSampleCount = reader.sampleIndex();
+	return result;
+}
+
+//Opening a .dgr file walks all its pages, checking every field and bitmap against the end of the file.
+QxGntVerifyResult QxGntVerifier::verifyDgrFile(const QString& strFileName)
+{
+	QxGntVerifyResult result;
+	result.strFileName = strFileName;
+	QxDgrReader reader;
+	if (!reader.open(strFileName))
+	{
+		result.strError = reader.errorMessage();
+		return result;
+	}
+	result.uSampleCount = reader.characterCount();
+	if (reader.hasError())
+	{
+		result.uErrorIndex = reader.sampleIndex();
+		result.uErrorOffset = reader.offset();
+		result.strError = reader.errorMessage();
+		return result;
+	}
+	result.bOk = true;
+	return result;
+}
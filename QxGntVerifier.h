@@ -0,0 +1,49 @@
+#ifndef _QX_GNT_VERIFIER_H_
+#define _QX_GNT_VERIFIER_H_
+
+#include <QString>
+#include <QStringList>
+
+/*
+	Result of checking one .gnt file.
+*/
+struct QxGntVerifyResult
+{
+	QxGntVerifyResult() : bOk(false), uSampleCount(0), uErrorIndex(0), uErrorOffset(0) {}
+
+	// One line report, e.g. "FAIL 1001-c.gnt: sample 12 at byte offset 34567: ..."
+	QString toString() const;
+
+	QString strFileName;
+	bool bOk;
+	// Number of valid samples found (before the first problem, if any).
+	quint64 uSampleCount;
+	// Index and byte offset of the first corrupt sample.
+	quint64 uErrorIndex;
+	quint64 uErrorOffset;
+	QString strError;
+};
+
+/*
+	Fast check of .gnt files for corrupt or truncated samples. Only the sample headers are walked: every data length
+	must be 10 + width x height, and the last sample must end exactly at the end of the file.
+	Online .pot files and text line .dgr files are checked too, see QxPotReader and QxDgrReader.
+*/
+class QxGntVerifier
+{
+public:
+	// Check a single file. Thread-safe, so many files can be checked in parallel with QtConcurrent::mapped().
+	static QxGntVerifyResult verifyFile(const QString& strFileName);
+	// Check the files in parallel, using the global thread pool.
+	static QList<QxGntVerifyResult> verifyFiles(const QStringList& fileList);
+
+private:
+	// Compressed files can't be skipped through, so every sample is read.
+	static QxGntVerifyResult verifyCompressedFile(const QString& strFileName);
+	// Online (.pot) files are checked sample by sample, strokes included.
+	static QxGntVerifyResult verifyPotFile(const QString& strFileName);
+	// Text line (.dgr) files are checked page by page when they are opened.
+	static QxGntVerifyResult verifyDgrFile(const QString& strFileName);
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef _QX_HASH_H_
+#define _QX_HASH_H_
+
+#include <QByteArray>
+#include <QtGlobal>
+
+/*
+	Small, platform independent hash helpers. Unlike qHash(), the results never change between Qt versions or runs,
+	so they can be used to make reproducible decisions (dataset splits, random seeds, ...).
+*/
+
+//SplitMix64 finalizer: turns an integer (index, seed, ...) into a well distributed 64-bit value.
+inline quint64 qxMix64(quint64 uValue)
+{
+	uValue += Q_UINT64_C(0x9E3779B97F4A7C15);
+	uValue = (uValue ^ (uValue >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+	uValue = (uValue ^ (uValue >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+	return uValue ^ (uValue >> 31);
+}
+
+//Seeded 64-bit FNV-1a hash of a byte sequence.
+inline quint64 qxHash64(const char* pData, qint64 iLength, quint64 uSeed = 0)
+{
+	quint64 uHash = Q_UINT64_C(0xCBF29CE484222325) ^ qxMix64(uSeed);
+	for (qint64 i = 0; i != iLength; ++i)
+	{
+		uHash ^= uchar(pData[i]);
+		uHash *= Q_UINT64_C(0x100000001B3);
+	}
+	return qxMix64(uHash);
+}
+
+//Seeded 64-bit FNV-1a hash of a byte array.
+inline quint64 qxHash64(const QByteArray& data, quint64 uSeed = 0)
+{
+	return qxHash64(data.constData(), data.size(), uSeed);
+}
+
+#endif
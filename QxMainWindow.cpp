@@ -1,11 +1,12 @@
-#include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include <QApplication>
 #include <QByteArray>
 #include <QDir>
+#include <QEventLoop>
 #include <QFile>
 #include <QFileDialog>
+#include <QFutureWatcher>
 #include <QImage>
 #include <QLabel>
 #include <QListWidget>
@@ -18,180 +19,75 @@
 #include <QString>
 #include <QTextStream>
 #include <QToolBar>
+#include <QVector>
+#include <QtConcurrentMap>
 
 #include "QxAboutDialog.h"
+#include "QxDecoder.h"
+#include "QxDgrReader.h"
+#include "QxGntReader.h"
+#include "QxGntVerifier.h"
 #include "QxMainWindow.h"
+#include "QxPotReader.h"
+#include "QxSampleProcessor.h"
+#include "QxStrokeRasterizer.h"
 
-// Manage the directories.
-static QDir g_dirManager;
-// Create a sub-folder named "images" in the selected folder to save the decoded images.
-static const QString g_ImageFolderName = "images";
-// Use a .txt file named "image_labels.txt" to save path of images and corresponding labels.
-static const QString g_LabelFileName = "image_labels.txt";
-// Use a local file named "code_labels.txt" to save the mapping relationship between image labels and gbk code of Chinese characters.
-static const QString g_MappingFileName = "code_label.txt";
-
-
-//Decoded .gnt files based on the parameters. Return true when successfully decoding the files.
-bool QxMainWindow::decodeFiles(const QStringList& fileList, const QString& strDestinationPath, const QString& imageFormat, const cv::Size& imageSize, const QxDecodeOptionDlg::ApplicationType appType)
+// Decoder asking its questions in message boxes and showing its progress in a progress dialog.
+class QxGuiDecoder : public QxDecoder
 {
-	// Create a sub-folder in the selected folder to save the decoded images.
-	// If the folder already exists, ask user whether to append decoded images to it.
-	QString strImagePath = strDestinationPath + "/" + g_ImageFolderName;
-	if (!g_dirManager.exists(strImagePath)) 
-	{ 
-		g_dirManager.mkdir(strImagePath); 
-	}
-	else 
+public:
+	QxGuiDecoder(QWidget* pParent, int iFileCount)
+		: m_pParent(pParent)
+		, m_ProgressDlg("Decoding files...", "Cancel", 0, iFileCount, pParent)
 	{
-		QString strTitle("Folder already exists");
-		QString strMessage;
-		strMessage.append("There is already a floder named \"").append(g_ImageFolderName).append("\" in the selected folder.\n");
-		strMessage.append("Do you still want to save the decoded images to it?");
-		QMessageBox::StandardButton button = QMessageBox::question(this, strTitle, strMessage, QMessageBox::Yes | QMessageBox::No);
-		if (button != QMessageBox::Yes) { return false;	} 
+		m_ProgressDlg.setWindowModality(Qt::WindowModal);
+		m_ProgressDlg.setMinimumDuration(0);
 	}
 
-	// Remove former information, just in case the user does twice or more times decoding without restart the software.
-	m_LabelCodeMap.clear();
-	m_ImageLabelMap.clear();
-
-	// decode files
-	QStringList::size_type uFileAmount = fileList.size();
-	QProgressDialog progressDlg("Decoding files...", "Cancel", 0, uFileAmount, this);
-	progressDlg.setWindowModality(Qt::WindowModal);
-	progressDlg.setMinimumDuration(0);
-	quint64 uTempIndex = 0;
-	for (QStringList::size_type i = 0; i != fileList.size(); ++i)
+protected:
+	virtual bool confirm(const QString& strTitle, const QString& strMessage, bool /*bDefault*/)
 	{
-		//Update progress dialog
-		progressDlg.setValue(i);
-		QApplication::processEvents();
-		if (progressDlg.wasCanceled())
-		{
-			saveMappingFile(strDestinationPath, appType);
-			saveLabelFile(strDestinationPath, appType);
-			return false;
-		}
-
-		//Error handling
-		QString strFileName = fileList.at(i);
-		QFile file(strFileName);
-		if (!file.open(QIODevice::ReadOnly))
-		{
-			QString strTitle("Open file error");
-			QString strErrorMessage = "Cannot open selected file:\nFile name: " + strFileName + "\nContinue decoding the remaining files? ";
-			QMessageBox::StandardButton button = QMessageBox::information(this, strTitle, strErrorMessage, QMessageBox::Yes | QMessageBox::No);
-			if (button == QMessageBox::Yes) { continue; }
-			else { return false; }
-		}
-
-		//Decode .gnt file specified by strFileName.
-		quint64 uDecodedByteNum = 0;
-		quint64 uDecodedByteNumTotal = 0;
-		quint64 uTotalByteNum = file.bytesAvailable();
-		QByteArray rawData;
-		while (uDecodedByteNumTotal != uTotalByteNum)
-		{
-			rawData = file.read(4); // get data size of this character
-			quint32 uDataLen = uchar(rawData.at(0)) + quint32(uchar(rawData.at(1))) * (1 << 8) + quint32(uchar(rawData.at(2))) * (1 << 16) + quint32(uchar(rawData.at(3))) * (1 << 24);
-			rawData = file.read(uDataLen - 4); //4 bytes have beed decoded already
-			quint32 uTagCode = uchar(rawData.at(0)) + quint32(uchar(rawData.at(1))) * (1 << 8);
-			quint32 uWidth = uchar(rawData.at(2)) + quint32(uchar(rawData.at(3))) * (1 << 8);
-			quint32 uHeight = uchar(rawData.at(4)) + quint32(uchar(rawData.at(5))) * (1 << 8);
-			quint32 uArcLen = uWidth > uHeight ? uWidth : uHeight;
-			uDecodedByteNum = 6;
-			++uTempIndex;
-			/* A character should be presented in a square. However, decoded images are, in most cases, rectangle.
-			  Therefore, a decoded character image is padded to a square whose length of the side is uArcLen (longer edge of the rectangle). 
-			  As the background of the decoded images is white (pixel value 255 for 8-bit grayscale images), all the padded pixels are set to be 255.  */
-			cv::Mat img = 255 * cv::Mat::ones(uArcLen, uArcLen, CV_8UC1);
-			int iHalfPadRowNum = (uArcLen - uHeight) / 2;
-			int iHalfPadColNum = (uArcLen - uWidth) / 2;
-            for (quint32 row = iHalfPadRowNum; row < uHeight + iHalfPadRowNum; ++row)
-			{
-				uchar *pRow = img.ptr<uchar>(row);
-                for (quint32 col = iHalfPadColNum; col < uWidth + iHalfPadColNum; ++col)
-				{
-					pRow[col] = uchar(rawData.at(uDecodedByteNum++));
-				}
-			}
-			// update mapping table, because label of the input images should, optimally, start from 0 and be consecutive.
-			if (!m_LabelCodeMap.contains(uTagCode))
-			{
-				quint32 uNewLabel = m_LabelCodeMap.size();
-				m_LabelCodeMap[uTagCode] = uNewLabel;
-			}
-			// image normalization and saving
-			// For 1.0train-gb1.gnt, it's a single file containing a lot samples, i+i is not correct index for image names
-			// Temporary solution on 8th May, to update
-			QString strSaveFileName = getSaveImageName(strImagePath, uTagCode, uTempIndex, appType);
-			strSaveFileName += "." + imageFormat;
-			cv::resize(img, img, imageSize);
-			cv::imwrite(strSaveFileName.toStdString(), img);
-			m_ImageLabelMap[strSaveFileName] = m_LabelCodeMap[uTagCode];
-			uDecodedByteNumTotal += uDataLen;
-		}
-		file.close();
+		return QMessageBox::question(m_pParent, strTitle, strMessage, QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
 	}
-	// Save the .txt files for different software
-	saveMappingFile(strDestinationPath, appType);
-	saveLabelFile(strDestinationPath, appType);
-	progressDlg.setValue(uFileAmount); 
-	return true;
-}
 
-//Generate a proper file name according to application type.
-QString QxMainWindow::getSaveImageName(const QString& strImagePath, const quint32 uCode, const quint32 uIndex, QxDecodeOptionDlg::ApplicationType appType)
-{
-	QString strImageName;
-	if (appType == QxDecodeOptionDlg::Caffe)
+	virtual void reportError(const QString& strTitle, const QString& strMessage)
 	{
-		strImageName = strImagePath + "/" + QString::number(uCode) + "-" + QString::number(uIndex);
+		QMessageBox::critical(m_pParent, strTitle, strMessage, QMessageBox::Ok);
 	}
-	else if (appType == QxDecodeOptionDlg::CNTK)
+
+	virtual bool reportProgress(int iDone, int iTotal)
 	{
-		strImageName = strImagePath + "/" + QString::number(uCode) + "-" + QString::number(uIndex);
+		m_ProgressDlg.setMaximum(iTotal);
+		m_ProgressDlg.setValue(iDone);
+		QApplication::processEvents();
+		return !m_ProgressDlg.wasCanceled();
 	}
-	else if (appType == QxDecodeOptionDlg::TensorFlow)
+
+private:
+	QWidget* m_pParent;
+	QProgressDialog m_ProgressDlg;
+};
+
+//Decoded .gnt files based on the parameters, showing the progress. Return true when successfully decoding the files.
+bool QxMainWindow::decodeFiles(const QStringList& fileList, const QxDecodeSettings& settings, QString& strStatistics)
+{
+	m_Settings = settings;
+	QxGuiDecoder decoder(this, fileList.size());
+	decoder.setSampleStore(m_pKeepInMemoryAction->isChecked() ? &m_SampleStore : NULL);
+	if (!decoder.decodeFiles(fileList, settings))
 	{
-		strImageName = strImagePath + "/" + QString::number(uCode) + "-" + QString::number(uIndex);
+		return false;
 	}
-	else  //DIGITS
+	strStatistics.clear();
+	if (!settings.strCachePath.isEmpty())
 	{
-		// First, check whether the subfolder for this class exists.
-		strImageName = strImagePath + "/" + QString::number(uCode);
-		if (!g_dirManager.exists(strImageName))
-		{
-			g_dirManager.mkdir(strImageName);
-		}
-		g_dirManager.setPath(strImageName);
-		g_dirManager.setFilter(QDir::Files);
-		//For example, if there are already 5 images in the folder, the new image will be named 6 (plus image suffix).
-		strImageName = strImageName + "/" + QString::number(g_dirManager.count()+1);
+		strStatistics.append(QString("%1 images from the cache.\n").arg(decoder.cachedImageCount()));
 	}
-
-	return strImageName;
-}
-
-//Generate the "image name   label" format string.
-QString QxMainWindow::getLabelInfo(const QString& strImageName, const quint32 uLabel, QxDecodeOptionDlg::ApplicationType appType)
-{
-	QString strToken;
-	switch (appType)
+	if (m_pKeepInMemoryAction->isChecked())
 	{
-	case QxDecodeOptionDlg::Caffe:
-		strToken = " "; break;
-	case QxDecodeOptionDlg::CNTK:
-		strToken = "\t"; break;
-	case QxDecodeOptionDlg::TensorFlow:
-		strToken = " "; break;
-	case QxDecodeOptionDlg::DIGITS:
-		strToken = " "; break;
-	default:
-		strToken = " ";
+		strStatistics.append("Sample store: ").append(m_SampleStore.statistics()).append(".");
 	}
-	return strImageName + strToken + QString::number(uLabel);
+	return true;
 }
 
 //Constructor
@@ -218,9 +114,12 @@ void QxMainWindow::initDialog()
 	m_pOpenAction = pFileMenu->addAction("Open");
 	m_pDecodeAction = pFileMenu->addAction("Decode Selected");
 	m_pDecodeAllAction = pFileMenu->addAction("Decode All");
+	m_pVerifyAction = pFileMenu->addAction("Verify All");
 	m_pRemoveAction = pFileMenu->addAction("Remove Selected");
 	m_pClearListAction = pFileMenu->addAction("Remove All");
 	m_pHidePreviewAction = pViewMenu->addAction("Hide Preview");
+	m_pKeepInMemoryAction = pViewMenu->addAction("Keep Files in Memory");
+	m_pKeepInMemoryAction->setCheckable(true);
 	m_pAboutAction = pHelpMenu->addAction("About gntDecoder");
 
 	m_pOpenAction->setIcon(QIcon(":/Resources/open.ico"));
@@ -234,9 +133,11 @@ void QxMainWindow::initDialog()
 	m_pOpenAction->setToolTip("Add .gnt files to file list");
 	m_pDecodeAction->setToolTip("Decode selected file");
 	m_pDecodeAllAction->setToolTip("Decode all files in the file list");
+	m_pVerifyAction->setToolTip("Check all files in the file list for corrupt or truncated samples");
 	m_pRemoveAction->setToolTip("Remove selected file from file list(Do nothing with local files)");
 	m_pClearListAction->setToolTip("Clear file list(Do nothing with local files)");
 	m_pHidePreviewAction->setToolTip("Hide preview image");
+	m_pKeepInMemoryAction->setToolTip("Keep the samples of the decoded files in memory, so that later decodings and previews don't read the files again");
 	
 	// Toolbar
 	m_pToolBar = new QToolBar;
@@ -264,9 +165,11 @@ void QxMainWindow::initDialog()
     connect(m_pOpenAction.data(), &QAction::triggered, this, &QxMainWindow::setFileList);
     connect(m_pDecodeAction.data(), &QAction::triggered, this, &QxMainWindow::decodeSelected);
     connect(m_pDecodeAllAction.data(), &QAction::triggered, this, &QxMainWindow::decodeAll);
+    connect(m_pVerifyAction.data(), &QAction::triggered, this, &QxMainWindow::verifyAll);
     connect(m_pClearListAction.data(), &QAction::triggered, this, &QxMainWindow::clearFileList);
     connect(m_pRemoveAction.data(), &QAction::triggered, this, &QxMainWindow::removeSelectedFile);
     connect(m_pHidePreviewAction.data(), &QAction::triggered, this, &QxMainWindow::closePreview);
+    connect(m_pKeepInMemoryAction.data(), &QAction::toggled, this, &QxMainWindow::setKeepInMemory);
     connect(m_pFileListWidget.data(), &QListWidget::itemSelectionChanged, this, &QxMainWindow::preview);
     connect(m_pAboutAction.data(), &QAction::triggered, this, &QxMainWindow::showAboutDialog);
 }
@@ -274,7 +177,7 @@ void QxMainWindow::initDialog()
 //Update file list.
 void QxMainWindow::setFileList()
 {
-	QStringList fileList = QFileDialog::getOpenFileNames(this, "Select Files to decode", "..", "*.gnt");
+	QStringList fileList = QFileDialog::getOpenFileNames(this, "Select Files to decode", "..", QxGntReader::fileFilter() + ";;" + QxPotReader::fileFilter() + ";;" + QxDgrReader::fileFilter());
 
 	//If some files are already in the file list.
 	QStringList::size_type originalSize = m_FileList.size();
@@ -314,17 +217,12 @@ void QxMainWindow::decodeSelected()
 		return;
 	}
 
-	// get selected application, image size, as well as image format
-	unsigned uImageSize = dlg.imageSize();
-	cv::Size imageSize(uImageSize, uImageSize);
-	QString strImageFormat = dlg.imageFormat();
-	QString strDestinationPath = dlg.filePath();
-	QxDecodeOptionDlg::ApplicationType appType = dlg.application();
-
 	//If files are successfully decode, show a messagebox to inform user.
-	if (decodeFiles(fileList, strDestinationPath, strImageFormat, imageSize, appType))
+	QString strStatistics;
+	if (decodeFiles(fileList, dlg.settings(), strStatistics))
 	{
-		QString strMessage("Files successfully decoded.");
+		QString strMessage("Files successfully decoded.\n");
+		strMessage.append(strStatistics);
 		QMessageBox::information(this, "Result", strMessage, QMessageBox::Ok);
 	}
 }
@@ -347,76 +245,69 @@ void QxMainWindow::decodeAll()
 		return;
 	}
 
-	// get selected application, image size, as well as image format
-	unsigned uImageSize = dlg.imageSize();
-	cv::Size imageSize(uImageSize, uImageSize);
-	QString strImageFormat = dlg.imageFormat();
-	QString strDestinationPath = dlg.filePath();
-	QxDecodeOptionDlg::ApplicationType appType = dlg.application();
-
 	//If files are successfully decode, show a messagebox to inform user.
-	if (decodeFiles(m_FileList, strDestinationPath, strImageFormat, imageSize, appType))
+	QString strStatistics;
+	if (decodeFiles(m_FileList, dlg.settings(), strStatistics))
 	{
-		QString strMessage("Files successfully decoded.");
+		QString strMessage("Files successfully decoded.\n");
+		strMessage.append(strStatistics);
 		QMessageBox::information(this, "Result", strMessage, QMessageBox::Ok);
 	}
 }
 
-//Save the mapping relationship between image labels and the GBK code of Chinese characters into a .txt file.
-void QxMainWindow::saveMappingFile(const QString& strFilePath, QxDecodeOptionDlg::ApplicationType appType)
+//Check all the files in the file list for corrupt or truncated samples.
+void QxMainWindow::verifyAll()
 {
-	// There's no need to store label files for DIGITS.
-	if (appType == QxDecodeOptionDlg::DIGITS)
+	if (m_FileList.isEmpty())
 	{
+		QString strTitle("No selected files");
+		QString strMessage("No files selected yet. Please press \"Open\" to select files first.");
+		QMessageBox::information(this, strTitle, strMessage, QMessageBox::Ok);
 		return;
 	}
 
-	QString strFileName = strFilePath + "/" + g_MappingFileName;
-	QFile file(strFileName);
-	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	// Files are checked in parallel on the global thread pool, while the progress dialog keeps the window responsive.
+	QProgressDialog progressDlg("Verifying files...", "Cancel", 0, m_FileList.size(), this);
+	progressDlg.setWindowModality(Qt::WindowModal);
+	progressDlg.setMinimumDuration(0);
+	QFutureWatcher<QxGntVerifyResult> watcher;
+	QEventLoop loop;
+	connect(&watcher, &QFutureWatcher<QxGntVerifyResult>::progressValueChanged, &progressDlg, &QProgressDialog::setValue);
+	connect(&watcher, &QFutureWatcher<QxGntVerifyResult>::finished, &loop, &QEventLoop::quit);
+	connect(&progressDlg, &QProgressDialog::canceled, &watcher, &QFutureWatcher<QxGntVerifyResult>::cancel);
+	watcher.setFuture(QtConcurrent::mapped(m_FileList, &QxGntVerifier::verifyFile));
+	loop.exec();
+	progressDlg.setValue(m_FileList.size());
+	if (watcher.isCanceled())
 	{
 		return;
 	}
 
-	const int iWordWidth = 10;
-	QTextStream textStream(&file);
-	textStream << qSetFieldWidth(iWordWidth) << left << "Code" << "Label" << qSetFieldWidth(0) << "\n";
-	for (QMap<quint32, quint32>::iterator itr = m_LabelCodeMap.begin(); itr != m_LabelCodeMap.end(); ++itr)
-	{
-		textStream << qSetFieldWidth(iWordWidth) << left << itr.key() << itr.value() << qSetFieldWidth(0) << "\n";
-	}
-	file.close();
-}
-
-//Save the image names and corresponding labels into a .txt file for Caffe/CNTK/TensorFlow
-void QxMainWindow::saveLabelFile(const QString& strFilePath, QxDecodeOptionDlg::ApplicationType appType)
-{
-	// There's no need to store label files for DIGITS.
-	if (appType == QxDecodeOptionDlg::DIGITS)
+	QList<QxGntVerifyResult> results = watcher.future().results();
+	QString strDetails;
+	int iFailedCount = 0;
+	quint64 uSampleCount = 0;
+	for (QList<QxGntVerifyResult>::const_iterator itr = results.begin(); itr != results.end(); ++itr)
 	{
-		return;
+		strDetails.append(itr->toString()).append("\n");
+		uSampleCount += itr->uSampleCount;
+		if (!itr->bOk)
+		{
+			++iFailedCount;
+		}
 	}
 
-	// Use a local file to save path of images and corresponding labels.
-	QString strLabelFileName = strFilePath + "/" + g_LabelFileName;
-	QFile labelFile(strLabelFileName);
-	if (!labelFile.open(QIODevice::WriteOnly | QIODevice::Text))
+	QMessageBox box(iFailedCount ? QMessageBox::Warning : QMessageBox::Information, "Verification result", QString(), QMessageBox::Ok, this);
+	if (iFailedCount)
 	{
-		QString strTitle("Open file error");
-		QString strMessage("Can not open label file:\n");
-		strMessage.append(strLabelFileName);
-		strMessage.append("\nMaybe you do not have permission to create a new file in the selected folder?");
-		strMessage.append("\nOr maybe there is a Read-Only file named \"").append(g_LabelFileName).append("\" in the selected folder?");
-		QMessageBox::critical(this, strTitle, strMessage, QMessageBox::Ok);
-		return;
+		box.setText(QString("%1 of %2 files are corrupt or truncated.\nSee details for the first problem found in each file.").arg(iFailedCount).arg(results.size()));
 	}
-
-	QTextStream textStream(&labelFile);
-	for (QMap<QString, quint32>::iterator itr = m_ImageLabelMap.begin(); itr != m_ImageLabelMap.end(); ++itr)
+	else
 	{
-		textStream << getLabelInfo(itr.key(), itr.value(), appType) << "\n";
+		box.setText(QString("All %1 files are valid (%2 samples).").arg(results.size()).arg(uSampleCount));
 	}
-	labelFile.close();
+	box.setDetailedText(strDetails);
+	box.exec();
 }
 
 //Clear file list.
@@ -424,6 +315,7 @@ void QxMainWindow::clearFileList()
 {
 	m_pFileListWidget->clear();
 	m_FileList.clear();
+	m_SampleStore.clear();
 	m_pPreviewLabel->hide();
 }
 
@@ -442,6 +334,7 @@ void QxMainWindow::removeSelectedFile()
 	int iCurrentIndex = m_pFileListWidget->row(pCurrentItem);
 
 	m_FileList.removeOne(pCurrentItem->text());
+	m_SampleStore.remove(pCurrentItem->text());
 	m_pFileListWidget->removeItemWidget(pCurrentItem);
 	delete pCurrentItem;
 
@@ -470,8 +363,13 @@ void QxMainWindow::preview()
 		return;
 	}
 	QString strFileName = pCurrentItem->text();
-	QFile file(strFileName);
-	if (!file.open(QIODevice::ReadOnly))
+	QxGntReader reader;
+	QxPotReader potReader;
+	QxDgrReader dgrReader;
+	const bool bPot = QxPotReader::isPotFile(strFileName);
+	const bool bDgr = QxDgrReader::isDgrFile(strFileName);
+	if (bPot ? !potReader.open(strFileName) : bDgr ? !dgrReader.open(strFileName)
+		: !reader.open(strFileName, m_pKeepInMemoryAction->isChecked() ? &m_SampleStore : NULL))
 	{
 		return;
 	}
@@ -485,30 +383,47 @@ void QxMainWindow::preview()
 	quint32 uCharacterPerCol = imageSize.height / uCharacterHeight;
 	cv::Mat img = 255 * cv::Mat::ones(imageSize, CV_8UC1);
 
-	quint32 uDecodedByteNum = 0;	//As the data is read as a stream, this variable tells how many bytes are processed already
+	QxGntRecord record;
+	QxPotSample potSample;
+	// online samples are drawn at the preview size, with the stroke width of the last decoding (the default one before)
+	QxStrokeRasterizer rasterizer(smallerSize.width, m_Settings.dStrokeWidth);
+	// characters of the current .dgr page
+	QVector<QxGntRecord> pageRecords;
+	int iPageRecord = 0;
+	int iPage = 0;
 	for (quint32 i = 0; i != uCharacterPerRow; ++i)
 	{
 		for (quint32 j = 0; j != uCharacterPerCol; ++j)
 		{
-			QByteArray rawData = file.read(4);
-			quint32 uDataLen = uchar(rawData.at(0)) + quint32(uchar(rawData.at(1))) * (1 << 8) + quint32(uchar(rawData.at(2))) * (1 << 16) + quint32(uchar(rawData.at(3))) * (1 << 24);
-			rawData = file.read(uDataLen - 4); //4 bytes have beed decoded already
-			quint32 uWidth = uchar(rawData.at(2)) + quint32(uchar(rawData.at(3))) * (1 << 8);
-			quint32 uHeight = uchar(rawData.at(4)) + quint32(uchar(rawData.at(5))) * (1 << 8);
-			quint32 uArcLen = uWidth > uHeight ? uWidth : uHeight;
-			uDecodedByteNum = 6;
-
-			// save data to a pre-defined white image(all pixel values are pre-defined to be 255)
-			cv::Mat characterImage = 255 * cv::Mat::ones(uArcLen, uArcLen, CV_8UC1);
-			quint32 uHalfPadRowNum = (uArcLen - uHeight) / 2;
-			quint32 uHalfPadColNum = (uArcLen - uWidth) / 2;
-			for (quint32 row = uHalfPadRowNum; row != uHeight + uHalfPadRowNum; ++row)
+			// Files with less samples than the preview can show, or broken files, simply leave the rest of the preview blank.
+			if (bDgr)
 			{
-				uchar *pRow = characterImage.ptr<uchar>(row);
-				for (quint32 col = uHalfPadColNum; col != uWidth + uHalfPadColNum; ++col)
+				// the next page is extracted once the characters of the current one are all shown
+				while (iPageRecord == pageRecords.size() && iPage != dgrReader.pageCount())
+				{
+					pageRecords.resize(int(dgrReader.page(iPage).uCharacterCount));
+					dgrReader.readPage(iPage++, pageRecords.data());
+					iPageRecord = 0;
+				}
+				if (iPageRecord == pageRecords.size())
 				{
-					pRow[col] = uchar(rawData.at(uDecodedByteNum++));
+					break;
 				}
+				record = pageRecords.at(iPageRecord++);
+			}
+			else if (bPot ? !potReader.readSample(potSample) : !reader.readRecord(record))
+			{
+				break;
+			}
+			if (bPot)
+			{
+				rasterizer.rasterize(potSample, record);
+			}
+			// save data to a pre-defined white image(all pixel values are pre-defined to be 255)
+			cv::Mat characterImage = QxSampleProcessor::paddedImage(record);
+			if (characterImage.empty())
+			{
+				continue;
 			}
 			// image normalization and filling
 			cv::resize(characterImage, characterImage, smallerSize);
@@ -528,7 +443,9 @@ void QxMainWindow::preview()
 			}
 		}
 	}
-	file.close();
+	reader.close();
+	potReader.close();
+	dgrReader.close();
 
 	QImage previewImage(img.data, img.cols, img.rows, img.step, QImage::Format_Grayscale8);
 	QPixmap pixmap = QPixmap::fromImage(previewImage);
@@ -542,6 +459,15 @@ void QxMainWindow::closePreview()
 	m_pPreviewLabel->hide();
 }
 
+//Start or stop keeping the samples of the listed files in memory, the stored samples are dropped when stopping.
+void QxMainWindow::setKeepInMemory(bool bKeep)
+{
+	if (!bKeep)
+	{
+		m_SampleStore.clear();
+	}
+}
+
 //Show "about" dialog
 void QxMainWindow::showAboutDialog()
 {
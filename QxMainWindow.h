@@ -8,6 +8,8 @@
 #include <QPointer>
 
 #include "QxDecodeOptionDlg.h"
+#include "QxDecodeSettings.h"
+#include "QxSampleStore.h"
 
 class QLabel;
 class QListWidget;
@@ -23,26 +25,20 @@ public:
 	virtual ~QxMainWindow();
 
 private:
-	//Decoded .gnt files based on the parameters. Return true when successfully decoding the files.
-	bool decodeFiles(const QStringList& fileList, const QString& strDestinationPath, const QString& imageFormat, const cv::Size& imageSize, const QxDecodeOptionDlg::ApplicationType appType);
-
-    //Generate the "image name   label" format string.
-    QString getLabelInfo(const QString& strImageName, const quint32 uLabel, QxDecodeOptionDlg::ApplicationType appType);
-	//Generate a proper file name according to application type.
-	QString getSaveImageName(const QString& strImagePath, const quint32 uCode, const quint32 uIndex, QxDecodeOptionDlg::ApplicationType appType);
+	//Decoded .gnt files based on the parameters, showing the progress. Return true when successfully decoding the files,
+	//with the statistics of the decoding in strStatistics.
+	bool decodeFiles(const QStringList& fileList, const QxDecodeSettings& settings, QString& strStatistics);
 
     //Init the widget.
     void initDialog();
-    //Save the image names and corresponding labels into a .txt file for Caffe/CNTK/TensorFlow
-    void saveLabelFile(const QString& strFilePath, QxDecodeOptionDlg::ApplicationType appType);
-    //Save the mapping relationship between image labels and the GBK code of Chinese characters into a .txt file.
-    void saveMappingFile(const QString& strFilePath, QxDecodeOptionDlg::ApplicationType appType);
 
 private slots:
     //Clear file list.
     void clearFileList();
     //Hide preview image
     void closePreview();
+    //Start or stop keeping the samples of the listed files in memory.
+    void setKeepInMemory(bool bKeep);
     //Decode all the .gnt files in the file list.
     void decodeAll();
 	//Decode selected .gnt file. in the file list.
@@ -55,23 +51,28 @@ private slots:
     void showAboutDialog();
     //Update file list.
     void setFileList();
+    //Check all the files in the file list for corrupt or truncated samples.
+    void verifyAll();
 
 private:
-    QMap<quint32, quint32> m_LabelCodeMap;
-    QMap<QString, quint32> m_ImageLabelMap;
-
 	QPointer<QAction> m_pAboutAction;
     QPointer<QAction> m_pClearListAction;
 	QPointer<QAction> m_pDecodeAction;
 	QPointer<QAction> m_pDecodeAllAction;
     QPointer<QAction> m_pHidePreviewAction;
+	QPointer<QAction> m_pKeepInMemoryAction;
     QPointer<QAction> m_pOpenAction;
 	QPointer<QAction> m_pRemoveAction;
+	QPointer<QAction> m_pVerifyAction;
 
 	QPointer<QLabel> m_pPreviewLabel;
 	QPointer<QListWidget> m_pFileListWidget;
 	QPointer<QToolBar> m_pToolBar;
 
 	QStringList m_FileList;
+	//Settings of the last decoding, the preview draws online samples with their stroke width.
+	QxDecodeSettings m_Settings;
+	//Samples of the listed files already read, when "Keep Files in Memory" is checked.
+	QxSampleStore m_SampleStore;
 };
 #endif
@@ -0,0 +1,107 @@
+#include "QxNpyWriter.h"
+
+// Fixed header size (magic, version, header length and the padded dictionary), large enough for any sample count.
+static const int g_iHeaderSize = 128;
+
+QxNpyWriter::QxNpyWriter()
+	: m_ElementType(UInt8)
+	, m_iSampleByteSize(0)
+	, m_uSampleCount(0)
+{
+}
+
+QxNpyWriter::~QxNpyWriter()
+{
+	close();
+}
+
+//Create the file.
+bool QxNpyWriter::open(const QString& strFileName, ElementType type, const QList<int>& sampleShape)
+{
+	close();
+	m_File.setFileName(strFileName);
+	m_ElementType = type;
+	m_SampleShape = sampleShape;
+	m_uSampleCount = 0;
+	m_iSampleByteSize = (type == UInt8) ? 1 : 4;
+	for (QList<int>::const_iterator itr = sampleShape.begin(); itr != sampleShape.end(); ++itr)
+	{
+		m_iSampleByteSize *= *itr;
+	}
+
+	if (!m_File.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		return false;
+	}
+	return m_File.write(header()) == g_iHeaderSize;
+}
+
+//Append one sample of the shape given to open().
+bool QxNpyWriter::append(const void* pData)
+{
+	if (m_File.write(static_cast<const char*>(pData), m_iSampleByteSize) != m_iSampleByteSize)
+	{
+		return false;
+	}
+	++m_uSampleCount;
+	return true;
+}
+
+//Write the final sample count into the header and close the file.
+bool QxNpyWriter::close()
+{
+	if (!m_File.isOpen())
+	{
+		return true;
+	}
+	bool bOk = m_File.seek(0) && m_File.write(header()) == g_iHeaderSize;
+	m_File.close();
+	return bOk;
+}
+
+bool QxNpyWriter::isOpen() const
+{
+	return m_File.isOpen();
+}
+
+quint64 QxNpyWriter::sampleCount() const
+{
+	return m_uSampleCount;
+}
+
+QString QxNpyWriter::errorString() const
+{
+	return m_File.errorString();
+}
+
+QByteArray QxNpyWriter::header() const
+{
+	QByteArray descr;
+	switch (m_ElementType)
+	{
+	case UInt8:
+		descr = "|u1"; break;
+	case Int32:
+		descr = "<i4"; break;
+	case Float32:
+		descr = "<f4"; break;
+	}
+
+	// e.g. {'descr': '<f4', 'fortran_order': False, 'shape': (1000, 64, 64), }
+	QByteArray shape = "(" + QByteArray::number(m_uSampleCount);
+	for (QList<int>::const_iterator itr = m_SampleShape.begin(); itr != m_SampleShape.end(); ++itr)
+	{
+		shape += ", " + QByteArray::number(*itr);
+	}
+	shape += m_SampleShape.isEmpty() ? ",)" : ")";
+	QByteArray dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': " + shape + ", }";
+
+	// magic string, version 1.0, little-endian header length, then the dictionary padded with spaces and ended by '\n'.
+	QByteArray header("\x93NUMPY\x01\x00", 8);
+	quint16 uDictLen = g_iHeaderSize - 10;
+	header.append(char(uDictLen & 0xFF)).append(char(uDictLen >> 8));
+	header.append(dict);
+	header.append(QByteArray(g_iHeaderSize - 1 - header.size(), ' '));
+	header.append('\n');
+	return header;
+}
@@ -0,0 +1,43 @@
+#ifndef _QX_NPY_WRITER_H_
+#define _QX_NPY_WRITER_H_
+
+#include <QFile>
+#include <QList>
+#include <QString>
+
+/*
+	Write a packed tensor file in NumPy .npy format (little-endian, C order), one sample after another.
+	The number of samples doesn't need to be known in advance: the header reserves room for it and is updated by close().
+	The files can be loaded with numpy.load(), optionally memory-mapped, or read directly after the 128-byte header.
+*/
+class QxNpyWriter
+{
+public:
+	enum ElementType{ UInt8, Int32, Float32 };
+
+	QxNpyWriter();
+	~QxNpyWriter();
+
+	// Create the file. sampleShape is the shape of one sample, e.g. (64, 64) for 64x64 images, or empty for scalars.
+	bool open(const QString& strFileName, ElementType type, const QList<int>& sampleShape);
+	// Append one sample of the shape given to open().
+	bool append(const void* pData);
+	// Write the final sample count into the header and close the file.
+	bool close();
+
+	bool isOpen() const;
+	quint64 sampleCount() const;
+	QString errorString() const;
+
+private:
+	QByteArray header() const;
+
+private:
+	QFile m_File;
+	ElementType m_ElementType;
+	QList<int> m_SampleShape;
+	qint64 m_iSampleByteSize;
+	quint64 m_uSampleCount;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include <zlib.h>
+
+#include <QFile>
+#include <QtEndian>
+
+#include "QxPngWriter.h"
+
+// First bytes of every PNG file.
+static const char g_PngSignature[] = "\x89PNG\r\n\x1a\n";
+// PNG color type of grayscale images without alpha.
+static const uchar g_uGrayColorType = 0;
+
+//Pack the levels of 8 / BITS pixels per byte, most significant bits first.
+template<int BITS>
+static void packLevels(const uchar* pSrc, int iWidth, const uchar* pLevels, uchar* pDst)
+{
+	const int iPixelsPerByte = 8 / BITS;
+	int x = 0;
+	// whole bytes, no branch in the loop body
+	for (; x + iPixelsPerByte <= iWidth; x += iPixelsPerByte)
+	{
+		uint uByte = 0;
+		for (int i = 0; i != iPixelsPerByte; ++i)
+		{
+			uByte = (uByte << BITS) | pLevels[pSrc[x + i]];
+		}
+		*pDst++ = uchar(uByte);
+	}
+	// last partial byte, padded with 0 bits
+	if (x != iWidth)
+	{
+		uint uByte = 0;
+		for (int i = 0; i != iPixelsPerByte; ++i)
+		{
+			uByte = (uByte << BITS) | (x + i < iWidth ? pLevels[pSrc[x + i]] : 0);
+		}
+		*pDst = uchar(uByte);
+	}
+}
+
+//Append a chunk (length, type, data, CRC of type and data).
+static void appendChunk(QByteArray& png, const char* pType, const QByteArray& data)
+{
+	uchar length[4];
+	qToBigEndian(quint32(data.size()), length);
+	png.append(reinterpret_cast<const char*>(length), 4);
+	int iTypeOffset = png.size();
+	png.append(pType, 4);
+	png.append(data);
+	uchar crc[4];
+	qToBigEndian(quint32(crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(png.constData() + iTypeOffset), uInt(png.size() - iTypeOffset))), crc);
+	png.append(reinterpret_cast<const char*>(crc), 4);
+}
+
+QxPngWriter::QxPngWriter(int iBitDepth, int iThreshold)
+	: m_iBitDepth(iBitDepth)
+{
+	const int iMaxLevel = (1 << iBitDepth) - 1;
+	for (int i = 0; i != 256; ++i)
+	{
+		m_Levels[i] = uchar(iBitDepth == 1 ? (i > iThreshold ? 1 : 0) : (i * iMaxLevel + 127) / 255);
+	}
+}
+
+bool QxPngWriter::write(const QString& strFileName, const cv::Mat& image) const
+{
+	QByteArray png = encode(image);
+	QFile file(strFileName);
+	return !png.isEmpty() && file.open(QIODevice::WriteOnly) && file.write(png) == png.size();
+}
+
+//Encode an 8-bit single channel image into a PNG file in memory.
+QByteArray QxPngWriter::encode(const cv::Mat& image) const
+{
+	if (image.type() != CV_8UC1 || image.empty())
+	{
+		return QByteArray();
+	}
+
+	// Each row is its filter type (0, none: the packed bits don't predict well) followed by the packed pixels.
+	const int iRowSize = (image.cols * m_iBitDepth + 7) / 8;
+	QByteArray rows((iRowSize + 1) * image.rows, '\0');
+	for (int y = 0; y != image.rows; ++y)
+	{
+		packRow(image.ptr<uchar>(y), image.cols, reinterpret_cast<uchar*>(rows.data()) + (iRowSize + 1) * y + 1);
+	}
+	uLongf uCompressedSize = compressBound(uLong(rows.size()));
+	QByteArray compressed(int(uCompressedSize), Qt::Uninitialized);
+	if (compress2(reinterpret_cast<Bytef*>(compressed.data()), &uCompressedSize, reinterpret_cast<const Bytef*>(rows.constData()), uLong(rows.size()), Z_DEFAULT_COMPRESSION) != Z_OK)
+	{
+		return QByteArray();
+	}
+	compressed.resize(int(uCompressedSize));
+
+	// IHDR: width, height, bit depth, color type, compression, filter and interlace methods.
+	uchar header[13];
+	qToBigEndian(quint32(image.cols), header);
+	qToBigEndian(quint32(image.rows), header + 4);
+	header[8] = uchar(m_iBitDepth);
+	header[9] = g_uGrayColorType;
+	header[10] = 0;
+	header[11] = 0;
+	header[12] = 0;
+
+	QByteArray png(g_PngSignature, sizeof(g_PngSignature) - 1);
+	appendChunk(png, "IHDR", QByteArray(reinterpret_cast<const char*>(header), sizeof(header)));
+	appendChunk(png, "IDAT", compressed);
+	appendChunk(png, "IEND", QByteArray());
+	return png;
+}
+
+//Quantize and pack a row of iWidth pixels.
+void QxPngWriter::packRow(const uchar* pSrc, int iWidth, uchar* pDst) const
+{
+	switch (m_iBitDepth)
+	{
+	case 1:
+		packLevels<1>(pSrc, iWidth, m_Levels, pDst);
+		break;
+	case 2:
+		packLevels<2>(pSrc, iWidth, m_Levels, pDst);
+		break;
+	default:
+		packLevels<4>(pSrc, iWidth, m_Levels, pDst);
+	}
+}
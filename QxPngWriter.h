@@ -0,0 +1,34 @@
+#ifndef _QX_PNG_WRITER_H_
+#define _QX_PNG_WRITER_H_
+
+#include <opencv2/core/core.hpp>
+
+#include <QByteArray>
+#include <QString>
+
+/*
+	Write 8-bit grayscale samples as 1, 2 or 4-bit grayscale PNG files, which OpenCV can't write.
+	Glyphs are almost bilevel, so 1 bit per pixel (threshold) or a few gray levels are enough, for 2 to 8 times less data
+	to compress, store and read back. Pixels are quantized through a lookup table and packed several per byte in a single
+	pass, then the rows are deflated with zlib. The member functions are const and thread-safe.
+*/
+class QxPngWriter
+{
+public:
+	// iBitDepth is 1, 2 or 4. 1-bit images are thresholded: pixels above iThreshold are white, like cv::THRESH_BINARY.
+	// 2 and 4-bit images keep 4 or 16 evenly spaced gray levels (0 is black, the last level white).
+	QxPngWriter(int iBitDepth, int iThreshold);
+
+	bool write(const QString& strFileName, const cv::Mat& image) const;
+	// Encode an 8-bit single channel image into a PNG file in memory.
+	QByteArray encode(const cv::Mat& image) const;
+	// Quantize and pack a row of iWidth pixels into (iWidth * bit depth + 7) / 8 bytes, most significant bits first.
+	void packRow(const uchar* pSrc, int iWidth, uchar* pDst) const;
+
+private:
+	int m_iBitDepth;
+	// Quantized level of each 8-bit value.
+	uchar m_Levels[256];
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include <string.h>
+
+#include <QFile>
+
+#include "QxDecompressDevice.h"
+#include "QxPotReader.h"
+
+// Sample size (2 bytes), tag code (4) and stroke count (2).
+static const int g_iSampleHeaderSize = 8;
+// Bytes of each (x, y) point.
+static const int g_iPointSize = 4;
+
+//Read a little-endian 16-bit field.
+static quint16 readUInt16(const uchar* pData)
+{
+	return quint16(pData[0] + (quint32(pData[1]) << 8));
+}
+
+QxPotReader::QxPotReader()
+	: m_bReadError(false)
+	, m_uOffset(0)
+	, m_uIndex(0)
+{
+}
+
+QxPotReader::~QxPotReader()
+{
+	close();
+}
+
+//Names of the files which can be read, to be used in file dialogs.
+QString QxPotReader::fileFilter()
+{
+	return "POT files (*.pot *.pot.gz *.pot.zst)";
+}
+
+//Whether a file is a .pot file (compressed or not), judging by its name.
+bool QxPotReader::isPotFile(const QString& strFileName)
+{
+	return strFileName.endsWith(".pot", Qt::CaseInsensitive) || strFileName.endsWith(".pot.gz", Qt::CaseInsensitive)
+		|| strFileName.endsWith(".pot.zst", Qt::CaseInsensitive);
+}
+
+bool QxPotReader::open(const QString& strFileName)
+{
+	close();
+	m_strErrorMessage.clear();
+	m_bReadError = false;
+	m_uOffset = 0;
+	m_uIndex = 0;
+
+	QIODevice::OpenMode mode = QIODevice::ReadOnly;
+	QxDecompressDevice::Compression compression;
+	if (QxDecompressDevice::compressionOf(strFileName, compression))
+	{
+		// The decompressed chunks are buffered already, there's no need for another buffer in QIODevice.
+		m_pDevice.reset(new QxDecompressDevice(strFileName, compression));
+		mode |= QIODevice::Unbuffered;
+	}
+	else
+	{
+		m_pDevice.reset(new QFile(strFileName));
+	}
+
+	if (!m_pDevice->open(mode))
+	{
+		m_strErrorMessage = m_pDevice->errorString();
+		m_pDevice.reset();
+		return false;
+	}
+	return true;
+}
+
+void QxPotReader::close()
+{
+	if (m_pDevice)
+	{
+		m_pDevice->close();
+		m_pDevice.reset();
+	}
+}
+
+//Read the next sample. Return false at the end of the file or when an error occurred, see hasError().
+bool QxPotReader::readSample(QxPotSample& sample)
+{
+	if (!m_pDevice || hasError())
+	{
+		return false;
+	}
+
+	// The whole sample is read at once, its size comes first.
+	uchar size[2];
+	qint64 iSizeSize = readFully(reinterpret_cast<char*>(size), sizeof(size));
+	if (iSizeSize == 0 && !hasError())
+	{
+		return false; // end of file
+	}
+	if (iSizeSize != sizeof(size))
+	{
+		setError("Unexpected end of file in the header of a sample.");
+		return false;
+	}
+	const int iSampleSize = readUInt16(size);
+	if (iSampleSize < g_iSampleHeaderSize + g_iPointSize)
+	{
+		setError(QString("Sample size %1 is smaller than the smallest sample (%2 bytes).").arg(iSampleSize).arg(g_iSampleHeaderSize + g_iPointSize));
+		return false;
+	}
+	m_Buffer.resize(iSampleSize);
+	memcpy(m_Buffer.data(), size, sizeof(size));
+	if (readFully(m_Buffer.data() + sizeof(size), iSampleSize - sizeof(size)) != qint64(iSampleSize - sizeof(size)))
+	{
+		setError("Unexpected end of file in the strokes of a sample.");
+		return false;
+	}
+
+	QString strError;
+	if (!parseSample(reinterpret_cast<const uchar*>(m_Buffer.constData()), iSampleSize, sample, strError))
+	{
+		setError(strError);
+		return false;
+	}
+	sample.uOffset = m_uOffset;
+	sample.uIndex = m_uIndex;
+	m_uOffset += iSampleSize;
+	++m_uIndex;
+	return true;
+}
+
+bool QxPotReader::hasError() const
+{
+	return !m_strErrorMessage.isEmpty();
+}
+
+//Error message including the index and byte offset of the sample where the error occurred.
+QString QxPotReader::errorString() const
+{
+	if (!m_bReadError)
+	{
+		return m_strErrorMessage;
+	}
+	return QString("%1 (sample %2, byte offset %3)").arg(m_strErrorMessage).arg(m_uIndex).arg(m_uOffset);
+}
+
+//Error message only.
+QString QxPotReader::errorMessage() const
+{
+	return m_strErrorMessage;
+}
+
+quint64 QxPotReader::offset() const
+{
+	return m_uOffset;
+}
+
+quint64 QxPotReader::sampleIndex() const
+{
+	return m_uIndex;
+}
+
+//Read exactly iSize bytes unless the end of the file is reached. Return the number of bytes read.
+qint64 QxPotReader::readFully(char* pData, qint64 iSize)
+{
+	qint64 iReadSize = 0;
+	while (iReadSize < iSize)
+	{
+		qint64 iChunkSize = m_pDevice->read(pData + iReadSize, iSize - iReadSize);
+		if (iChunkSize < 0)
+		{
+			setError(m_pDevice->errorString());
+			break;
+		}
+		if (iChunkSize == 0)
+		{
+			break;
+		}
+		iReadSize += iChunkSize;
+	}
+	return iReadSize;
+}
+
+//Decode the tag code and the strokes of a sample: the points of each stroke up to (-1, 0), then (-1, -1).
+bool QxPotReader::parseSample(const uchar* pData, int iSize, QxPotSample& sample, QString& strError)
+{
+	// Same tag code as the .gnt samples of the same character.
+	sample.uTagCode = readUInt16(pData + 2);
+	const int iStrokeCount = readUInt16(pData + 6);
+	sample.points.clear();
+	sample.strokeEnds.clear();
+	sample.points.reserve((iSize - g_iSampleHeaderSize) / g_iPointSize);
+	sample.strokeEnds.reserve(iStrokeCount);
+
+	for (int iPos = g_iSampleHeaderSize; iPos + g_iPointSize <= iSize; iPos += g_iPointSize)
+	{
+		const int x = qint16(readUInt16(pData + iPos));
+		const int y = qint16(readUInt16(pData + iPos + 2));
+		if (x == -1 && y == -1)
+		{
+			if (iPos + g_iPointSize != iSize)
+			{
+				strError = QString("End of the character at byte %1 of a sample of %2 bytes.").arg(iPos).arg(iSize);
+				return false;
+			}
+			if (sample.strokeEnds.size() != iStrokeCount)
+			{
+				strError = QString("Sample has %1 strokes instead of %2.").arg(sample.strokeEnds.size()).arg(iStrokeCount);
+				return false;
+			}
+			return true;
+		}
+		if (x == -1 && y == 0)
+		{
+			sample.strokeEnds.append(sample.points.size());
+		}
+		else
+		{
+			sample.points.append(QPoint(x, y));
+		}
+	}
+	strError = "Sample has no end of character mark (-1, -1).";
+	return false;
+}
+
+void QxPotReader::setError(const QString& strError)
+{
+	m_strErrorMessage = strError;
+	m_bReadError = true;
+}
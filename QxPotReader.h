@@ -0,0 +1,77 @@
+#ifndef _QX_POT_READER_H_
+#define _QX_POT_READER_H_
+
+#include <QByteArray>
+#include <QPoint>
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+/*
+	One character sample of a .pot (online handwriting) file: the pen trajectory of each stroke.
+*/
+struct QxPotSample
+{
+	QxPotSample() : uTagCode(0), uOffset(0), uIndex(0) {}
+
+	quint32 uTagCode;
+	// Points of all the strokes in tablet coordinates, and the index of the point after the last one of each stroke.
+	QVector<QPoint> points;
+	QVector<int> strokeEnds;
+	// Byte offset of the sample in the (decompressed) file and its index in the file.
+	quint64 uOffset;
+	quint64 uIndex;
+};
+
+/*
+	Read the samples of a CASIA online handwriting .pot file one after another. Each sample is:
+		sample size (2 bytes, including these 2), tag code (4 bytes, GB code in the first 2 like .gnt), stroke count (2),
+		then the (x, y) points of each stroke (2 + 2 bytes, signed) ended by (-1, 0), and (-1, -1) after the last stroke.
+	All the fields are little-endian. Compressed files (.pot.gz, .pot.zst) are decompressed on the fly, like .gnt files.
+	The samples are turned into bitmaps by QxStrokeRasterizer.
+*/
+class QxPotReader
+{
+public:
+	QxPotReader();
+	~QxPotReader();
+
+	// Names of the files which can be read, to be used in file dialogs.
+	static QString fileFilter();
+	// Whether a file is a .pot file (compressed or not), judging by its name.
+	static bool isPotFile(const QString& strFileName);
+
+	bool open(const QString& strFileName);
+	void close();
+	// Read the next sample. Return false at the end of the file or when an error occurred, see hasError().
+	bool readSample(QxPotSample& sample);
+
+	bool hasError() const;
+	// Error message including the index and byte offset of the sample where the error occurred.
+	QString errorString() const;
+	// Error message only.
+	QString errorMessage() const;
+	// Byte offset and index of the next sample, or of the sample which could not be read after an error.
+	quint64 offset() const;
+	quint64 sampleIndex() const;
+
+private:
+	// Read exactly iSize bytes unless the end of the file is reached. Return the number of bytes read.
+	qint64 readFully(char* pData, qint64 iSize);
+	// Decode the tag code and the strokes of a sample. Return false and set strError when it is corrupt.
+	static bool parseSample(const uchar* pData, int iSize, QxPotSample& sample, QString& strError);
+	void setError(const QString& strError);
+
+private:
+	QScopedPointer<QIODevice> m_pDevice;
+	QByteArray m_Buffer;
+	QString m_strErrorMessage;
+	// Whether the error happened while reading samples (so offset() and sampleIndex() tell where).
+	bool m_bReadError;
+	quint64 m_uOffset;
+	quint64 m_uIndex;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include <string.h>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "QxGntReader.h"
+#include "QxSampleProcessor.h"
+
+QxSampleProcessor::QxSampleProcessor(const QxDecodeSettings& settings)
+	: m_Settings(settings)
+	, m_Augmenter(settings)
+{
+}
+
+//Pad the sample to a white square.
+cv::Mat QxSampleProcessor::paddedImage(const QxGntRecord& record)
+{
+	quint32 uWidth = record.uWidth;
+	quint32 uHeight = record.uHeight;
+	quint32 uArcLen = uWidth > uHeight ? uWidth : uHeight;
+	const uchar* pData = reinterpret_cast<const uchar*>(record.bitmap.constData());
+
+	cv::Mat img(uArcLen, uArcLen, CV_8UC1, cv::Scalar(255));
+	quint32 uHalfPadRowNum = (uArcLen - uHeight) / 2;
+	quint32 uHalfPadColNum = (uArcLen - uWidth) / 2;
+	for (quint32 row = 0; row != uHeight; ++row)
+	{
+		memcpy(img.ptr<uchar>(row + uHalfPadRowNum) + uHalfPadColNum, pData + row * uWidth, uWidth);
+	}
+	return img;
+}
+
+//Pad, augment, resize, binarize and invert the sample for several sides at once, downsampling each size from the previous one.
+void QxSampleProcessor::process(const QxGntRecord& record, int iVariant, quint64 uVariantSeed, const QList<int>& sides, QVector<cv::Mat>& images) const
+{
+	images.resize(sides.size());
+	cv::Mat source = sourceImage(record, iVariant, uVariantSeed);
+	for (int i = 0; i != sides.size(); ++i)
+	{
+		cv::Size size(sides.at(i), sides.at(i));
+		if (source.empty())
+		{
+			images[i] = cv::Mat(size, CV_8UC1, cv::Scalar(255));
+		}
+		else if (i == 0)
+		{
+			cv::resize(source, images[i], size);
+		}
+		else
+		{
+			// The previous size is not post-processed yet, area interpolation averages it without aliasing.
+			cv::resize(images[i - 1], images[i], size, 0, 0, cv::INTER_AREA);
+		}
+	}
+	// Post-processing comes last, each size is binarized from its own gray levels.
+	for (int i = 0; i != images.size(); ++i)
+	{
+		postProcess(images[i]);
+	}
+}
+
+//Pad and augment the sample.
+cv::Mat QxSampleProcessor::sourceImage(const QxGntRecord& record, int iVariant, quint64 uVariantSeed) const
+{
+	cv::Mat img = paddedImage(record);
+	// Augmentation works on the source resolution, so that strokes can be changed by a single pixel.
+	if (iVariant > 0)
+	{
+		img = m_Augmenter.augment(img, uVariantSeed);
+	}
+	return img;
+}
+
+//Binarize and invert a resized image, in place.
+void QxSampleProcessor::postProcess(cv::Mat& image) const
+{
+	// The OpenCV kernels used below are vectorized, and work in place on the resized image.
+	if (m_Settings.binarizeMode == QxDecodeSettings::GlobalThreshold)
+	{
+		cv::threshold(image, image, m_Settings.iThreshold, 255, cv::THRESH_BINARY);
+	}
+	else if (m_Settings.binarizeMode == QxDecodeSettings::OtsuThreshold)
+	{
+		cv::threshold(image, image, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+	}
+	if (m_Settings.bInvert)
+	{
+		cv::bitwise_not(image, image);
+	}
+}
+
+//Convert a processed image into the selected tensor type, writing straight into pDst.
+void QxSampleProcessor::toTensor(const cv::Mat& image, void* pDst) const
+{
+	if (m_Settings.tensorType == QxDecodeSettings::UInt8Tensor)
+	{
+		cv::Mat dst(image.size(), CV_8UC1, pDst);
+		image.copyTo(dst);
+		return;
+	}
+
+	// dst = pixel * dAlpha + dBeta, in a single vectorized pass.
+	double dAlpha = 1.0;
+	double dBeta = 0.0;
+	if (m_Settings.normalizeMode == QxDecodeSettings::UnitRange)
+	{
+		dAlpha = 1.0 / 255.0;
+	}
+	else if (m_Settings.normalizeMode == QxDecodeSettings::MeanStd)
+	{
+		dAlpha = 1.0 / (255.0 * m_Settings.dStd);
+		dBeta = -m_Settings.dMean / m_Settings.dStd;
+	}
+	cv::Mat dst(image.size(), CV_32FC1, pDst);
+	image.convertTo(dst, CV_32F, dAlpha, dBeta);
+}
+
+//Size in bytes of one tensor of side x side elements.
+size_t QxSampleProcessor::tensorByteSize(int iSide) const
+{
+	size_t uElementSize = m_Settings.tensorType == QxDecodeSettings::Float32Tensor ? sizeof(float) : sizeof(uchar);
+	return size_t(iSide) * size_t(iSide) * uElementSize;
+}
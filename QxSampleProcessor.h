@@ -0,0 +1,50 @@
+#ifndef _QX_SAMPLE_PROCESSOR_H_
+#define _QX_SAMPLE_PROCESSOR_H_
+
+#include <opencv2/core/core.hpp>
+
+#include <QList>
+#include <QVector>
+
+#include "QxAugmenter.h"
+#include "QxDecodeSettings.h"
+
+struct QxGntRecord;
+
+/*
+	Turn a decoded sample into the image/tensor written to the output: padding, resizing and the per-sample
+	post-processing (inversion, binarization, normalization) all happen in one pass over the sample.
+	The member functions are const and thread-safe.
+*/
+class QxSampleProcessor
+{
+public:
+	explicit QxSampleProcessor(const QxDecodeSettings& settings);
+
+	/* A character should be presented in a square. However, decoded images are, in most cases, rectangle.
+	  Therefore, a decoded character image is padded to a square whose length of the side is the longer edge of the rectangle.
+	  As the background of the decoded images is white (pixel value 255 for 8-bit grayscale images), all the padded pixels are set to be 255.  */
+	static cv::Mat paddedImage(const QxGntRecord& record);
+
+	// Pad, augment (iVariant > 0, with the seed from QxAugmenter::variantSeed()), resize, binarize and invert the sample,
+	// into an 8-bit image for each of sides (sorted from the largest): the sample is padded and augmented once, resized
+	// to the largest side (bilinear), then each smaller size is downsampled from the previous one (area interpolation).
+	void process(const QxGntRecord& record, int iVariant, quint64 uVariantSeed, const QList<int>& sides, QVector<cv::Mat>& images) const;
+	// Convert a processed image into the selected tensor type, writing straight into pDst
+	// (imageSize.area() elements of uchar or float).
+	void toTensor(const cv::Mat& image, void* pDst) const;
+	// Size in bytes of one tensor of side x side elements.
+	size_t tensorByteSize(int iSide) const;
+
+private:
+	// Pad and augment the sample.
+	cv::Mat sourceImage(const QxGntRecord& record, int iVariant, quint64 uVariantSeed) const;
+	// Binarize and invert a resized image, in place.
+	void postProcess(cv::Mat& image) const;
+
+private:
+	QxDecodeSettings m_Settings;
+	QxAugmenter m_Augmenter;
+};
+
+#endif
@@ -0,0 +1,253 @@
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QtConcurrentRun>
+#include <QtEndian>
+
+#include "QxGntDataset.h"
+#include "QxHash.h"
+#include "QxSampleServer.h"
+
+static const quint32 g_uProtocolVersion = 1;
+static const int g_iRequestSize = 24;
+static const quint32 g_uMaxBatchSize = 65536;
+static const quint64 g_uMaxBatchPixels = 256 * 1024 * 1024;
+static const quint32 g_uShuffleFlag = 1;
+static const quint32 g_uDropLastFlag = 2;
+//Number of batches prepared ahead for each client.
+static const int g_iPrefetchBatchCount = 8;
+//Stop sending while the client hasn't read that many bytes yet.
+static const qint64 g_iMaxBufferedBytes = 64 * 1024 * 1024;
+
+static void appendUInt32(QByteArray& data, quint32 uValue)
+{
+	uchar bytes[sizeof(quint32)];
+	qToLittleEndian(uValue, bytes);
+	data.append(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+}
+
+static void appendUInt64(QByteArray& data, quint64 uValue)
+{
+	uchar bytes[sizeof(quint64)];
+	qToLittleEndian(uValue, bytes);
+	data.append(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+}
+
+//Batch header followed by the sample indices, the labels and the pixels. Run on the thread pool.
+static QByteArray buildBatch(const QxGntDataset* pDataset, QVector<quint64> indices, int iImageSide, quint32 uBatchIndex)
+{
+	const int iSampleCount = indices.size();
+	const int iHeaderSize = 16;
+	const int iPixelOffset = iHeaderSize + iSampleCount * int(sizeof(quint64) + sizeof(qint32));
+	const int iImageSize = iImageSide * iImageSide;
+
+	QByteArray batch;
+	batch.reserve(iPixelOffset + iSampleCount * iImageSize);
+	batch.append("GNTB", 4);
+	appendUInt32(batch, iSampleCount);
+	appendUInt32(batch, iImageSide);
+	appendUInt32(batch, uBatchIndex);
+	for (int i = 0; i != iSampleCount; ++i)
+	{
+		appendUInt64(batch, indices[i]);
+	}
+	for (int i = 0; i != iSampleCount; ++i)
+	{
+		appendUInt32(batch, pDataset->label(indices[i]));
+	}
+	batch.resize(iPixelOffset + iSampleCount * iImageSize);
+	uchar* pPixels = reinterpret_cast<uchar*>(batch.data()) + iPixelOffset;
+	for (int i = 0; i != iSampleCount; ++i)
+	{
+		pDataset->render(indices[i], iImageSide, pPixels + size_t(i) * iImageSize);
+	}
+	return batch;
+}
+
+QxSampleServer::QxSampleServer(const QxGntDataset* pDataset, QObject* parent /*= 0*/)
+	: QObject(parent)
+	, m_pDataset(pDataset)
+{
+	m_pServer = new QLocalServer(this);
+	connect(m_pServer, &QLocalServer::newConnection, this, &QxSampleServer::acceptConnections);
+}
+
+QxSampleServer::~QxSampleServer()
+{
+}
+
+//Listen on a socket file path or name.
+bool QxSampleServer::listen(const QString& strName)
+{
+	// A socket file left by a server which was killed would make listen() fail.
+	QLocalServer::removeServer(strName);
+	return m_pServer->listen(strName);
+}
+
+QString QxSampleServer::errorString() const
+{
+	return m_pServer->errorString();
+}
+
+//Full path of the socket clients connect to.
+QString QxSampleServer::fullServerName() const
+{
+	return m_pServer->fullServerName();
+}
+
+void QxSampleServer::acceptConnections()
+{
+	while (QLocalSocket* pSocket = m_pServer->nextPendingConnection())
+	{
+		new QxSampleSession(m_pDataset, pSocket, this);
+	}
+}
+
+QxSampleSession::QxSampleSession(const QxGntDataset* pDataset, QLocalSocket* pSocket, QObject* parent /*= 0*/)
+	: QObject(parent)
+	, m_pDataset(pDataset)
+	, m_pSocket(pSocket)
+	, m_bEpochRunning(false)
+	, m_uBatchSize(0)
+	, m_iImageSide(0)
+	, m_iNextSample(0)
+	, m_iEndSample(0)
+	, m_uNextBatchIndex(0)
+{
+	pSocket->setParent(this);
+	connect(pSocket, &QLocalSocket::readyRead, this, &QxSampleSession::readRequests);
+	connect(pSocket, &QLocalSocket::bytesWritten, this, &QxSampleSession::writeBatches);
+	connect(pSocket, &QLocalSocket::disconnected, this, &QObject::deleteLater);
+
+	QByteArray hello("GNTS", 4);
+	appendUInt32(hello, g_uProtocolVersion);
+	appendUInt64(hello, m_pDataset->sampleCount());
+	appendUInt32(hello, m_pDataset->classCount());
+	const QVector<quint32>& labelCodes = m_pDataset->labelCodes();
+	for (QVector<quint32>::const_iterator itr = labelCodes.begin(); itr != labelCodes.end(); ++itr)
+	{
+		appendUInt32(hello, *itr);
+	}
+	pSocket->write(hello);
+}
+
+QxSampleSession::~QxSampleSession()
+{
+	// Batches still being prepared are simply dropped.
+	qDeleteAll(m_PendingBatches);
+}
+
+void QxSampleSession::readRequests()
+{
+	m_Requests.append(m_pSocket->readAll());
+	if (!m_bEpochRunning)
+	{
+		processRequest();
+	}
+}
+
+//Start the next requested epoch, if any.
+void QxSampleSession::processRequest()
+{
+	if (m_Requests.size() < g_iRequestSize)
+	{
+		return;
+	}
+	const uchar* pRequest = reinterpret_cast<const uchar*>(m_Requests.constData());
+	bool bMagicOk = m_Requests.startsWith("GNTQ");
+	quint32 uBatchSize = qFromLittleEndian<quint32>(pRequest + 4);
+	quint32 uImageSide = qFromLittleEndian<quint32>(pRequest + 8);
+	quint32 uFlags = qFromLittleEndian<quint32>(pRequest + 12);
+	quint64 uSeed = qFromLittleEndian<quint64>(pRequest + 16);
+	m_Requests.remove(0, g_iRequestSize);
+	if (!bMagicOk)
+	{
+		sendError("Invalid request.");
+		return;
+	}
+	if (uBatchSize < 1 || uBatchSize > g_uMaxBatchSize || uImageSide < 1 || uImageSide > quint32(QxGntDataset::MaxImageSide)
+		|| quint64(uBatchSize) * uImageSide * uImageSide > g_uMaxBatchPixels)
+	{
+		sendError(QString("Invalid batch size %1 or image side %2.").arg(uBatchSize).arg(uImageSide));
+		return;
+	}
+
+	const int iSampleCount = int(m_pDataset->sampleCount());
+	m_Order.resize(iSampleCount);
+	for (int i = 0; i != iSampleCount; ++i)
+	{
+		m_Order[i] = i;
+	}
+	if (uFlags & g_uShuffleFlag)
+	{
+		// Fisher-Yates shuffle driven by a SplitMix64 sequence, so the order only depends on the seed.
+		const quint64 uState = qxMix64(uSeed);
+		for (int i = iSampleCount - 1; i > 0; --i)
+		{
+			int j = int(qxMix64(uState + quint64(i)) % quint64(i + 1));
+			qSwap(m_Order[i], m_Order[j]);
+		}
+	}
+
+	m_bEpochRunning = true;
+	m_uBatchSize = uBatchSize;
+	m_iImageSide = int(uImageSide);
+	m_iNextSample = 0;
+	m_iEndSample = (uFlags & g_uDropLastFlag) ? iSampleCount - iSampleCount % int(uBatchSize) : iSampleCount;
+	m_uNextBatchIndex = 0;
+	scheduleBatches();
+	writeBatches();
+}
+
+//Prepare batches on the thread pool until enough of them are in flight.
+void QxSampleSession::scheduleBatches()
+{
+	while (m_PendingBatches.size() < g_iPrefetchBatchCount && m_iNextSample < m_iEndSample)
+	{
+		int iCount = qMin(int(m_uBatchSize), m_iEndSample - m_iNextSample);
+		QFutureWatcher<QByteArray>* pWatcher = new QFutureWatcher<QByteArray>(this);
+		connect(pWatcher, &QFutureWatcher<QByteArray>::finished, this, &QxSampleSession::writeBatches);
+		pWatcher->setFuture(QtConcurrent::run(buildBatch, m_pDataset, m_Order.mid(m_iNextSample, iCount), m_iImageSide, m_uNextBatchIndex));
+		m_PendingBatches.enqueue(pWatcher);
+		m_iNextSample += iCount;
+		++m_uNextBatchIndex;
+	}
+}
+
+//Send the prepared batches in order, as long as the client keeps up.
+void QxSampleSession::writeBatches()
+{
+	if (!m_bEpochRunning || !m_pSocket)
+	{
+		return;
+	}
+	while (!m_PendingBatches.isEmpty() && m_PendingBatches.head()->isFinished() && m_pSocket->bytesToWrite() < g_iMaxBufferedBytes)
+	{
+		QFutureWatcher<QByteArray>* pWatcher = m_PendingBatches.dequeue();
+		m_pSocket->write(pWatcher->result());
+		pWatcher->deleteLater();
+		scheduleBatches();
+	}
+
+	if (m_PendingBatches.isEmpty() && m_iNextSample == m_iEndSample)
+	{
+		// end of the epoch: an empty batch
+		QByteArray endOfEpoch("GNTB", 4);
+		appendUInt32(endOfEpoch, 0);
+		appendUInt32(endOfEpoch, m_iImageSide);
+		appendUInt32(endOfEpoch, m_uNextBatchIndex);
+		m_pSocket->write(endOfEpoch);
+		m_bEpochRunning = false;
+		m_Order.clear();
+		processRequest();
+	}
+}
+
+void QxSampleSession::sendError(const QString& strError)
+{
+	QByteArray message = strError.toUtf8();
+	QByteArray error("GNTE", 4);
+	appendUInt32(error, message.size());
+	error.append(message);
+	m_pSocket->write(error);
+	m_pSocket->disconnectFromServer();
+}
@@ -0,0 +1,112 @@
+#ifndef _QX_SAMPLE_SERVER_H_
+#define _QX_SAMPLE_SERVER_H_
+
+#include <QByteArray>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QVector>
+
+class QLocalServer;
+class QLocalSocket;
+class QxGntDataset;
+
+/*
+	Serve decoded, resized batches of a QxGntDataset to local clients (a Unix-domain socket, or a named pipe on Windows),
+	so that a training process on the same machine doesn't need the samples to be written to image files first.
+	Each connection prepares its next batches ahead of time on the global thread pool.
+
+	Wire format, all integers little-endian:
+
+	Server hello, sent once when a client connects:
+		char[4]   "GNTS"
+		uint32    protocol version (1)
+		uint64    number of samples
+		uint32    number of classes C
+		uint32[C] tag code of each label (the "Code" column of code_label.txt)
+
+	Epoch request, sent by the client (24 bytes):
+		char[4]   "GNTQ"
+		uint32    batch size, 1 to 65536
+		uint32    image side S, 1 to 1024 (at most 256 MB of pixels per batch)
+		uint32    flags: 1 = shuffle the samples, 2 = drop the last incomplete batch
+		uint64    shuffle seed, the same seed always gives the same order
+
+	The server answers an epoch request with its batches, followed by an empty batch (N = 0) marking the end of the epoch:
+		char[4]   "GNTB"
+		uint32    number of samples N in the batch
+		uint32    image side S
+		uint32    index of the batch in the epoch
+		uint64[N] sample indices (the order of the samples in the listed files, counting from 0)
+		int32[N]  labels
+		uint8[N x S x S] pixels, row by row, white (255) background
+
+	Requests sent during an epoch are answered when the epoch is over. An invalid request is answered with
+		char[4]   "GNTE"
+		uint32    length L of the message
+		char[L]   error message (UTF-8)
+	and the connection is closed.
+*/
+class QxSampleServer : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit QxSampleServer(const QxGntDataset* pDataset, QObject* parent = 0);
+	virtual ~QxSampleServer();
+
+	// Listen on a socket file path or name (the previous socket file is removed).
+	bool listen(const QString& strName);
+	QString errorString() const;
+	// Full path of the socket clients connect to.
+	QString fullServerName() const;
+
+private slots:
+	void acceptConnections();
+
+private:
+	const QxGntDataset* m_pDataset;
+	QPointer<QLocalServer> m_pServer;
+};
+
+/*
+	One client connection of QxSampleServer.
+*/
+class QxSampleSession : public QObject
+{
+	Q_OBJECT
+
+public:
+	QxSampleSession(const QxGntDataset* pDataset, QLocalSocket* pSocket, QObject* parent = 0);
+	virtual ~QxSampleSession();
+
+private slots:
+	void readRequests();
+	// Send the prepared batches in order, as long as the client keeps up.
+	void writeBatches();
+
+private:
+	// Start the next requested epoch, if any.
+	void processRequest();
+	// Prepare batches on the thread pool until enough of them are in flight.
+	void scheduleBatches();
+	void sendError(const QString& strError);
+
+private:
+	const QxGntDataset* m_pDataset;
+	QPointer<QLocalSocket> m_pSocket;
+	QByteArray m_Requests;
+
+	// Current epoch
+	bool m_bEpochRunning;
+	QVector<quint64> m_Order;
+	quint32 m_uBatchSize;
+	int m_iImageSide;
+	int m_iNextSample;
+	int m_iEndSample;
+	quint32 m_uNextBatchIndex;
+	QQueue<QFutureWatcher<QByteArray>*> m_PendingBatches;
+};
+
+#endif
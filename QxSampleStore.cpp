@@ -0,0 +1,320 @@
+#include <limits.h>
+#include <string.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QTemporaryDir>
+
+#include "QxGntReader.h"
+#include "QxSampleStore.h"
+
+// Tag code, width and height of each stored sample, 2 bytes each (little-endian), before its rows.
+static const int g_iStoredHeaderSize = 6;
+// Longest run of a row token.
+static const int g_iMaxRun = 255;
+
+QxSampleStore::QxSampleStore(qint64 iMemoryBudget /*= DefaultMemoryBudget*/)
+	: m_iMemoryBudget(iMemoryBudget)
+	, m_iMemorySize(0)
+	, m_iSpillFileCount(0)
+	, m_iGeneration(0)
+{
+}
+
+QxSampleStore::~QxSampleStore()
+{
+	clear();
+}
+
+//Forget all the files, removing the spill folder. The chunks of the files being read are dropped too.
+void QxSampleStore::clear()
+{
+	QMutexLocker locker(&m_Mutex);
+	m_Entries.clear();
+	m_iMemorySize = 0;
+	m_pSpillDir.reset();
+	++m_iGeneration;
+}
+
+void QxSampleStore::remove(const QString& strFileName)
+{
+	QMutexLocker locker(&m_Mutex);
+	removeEntry(strFileName);
+}
+
+//Chunks and number of samples of a stored file, unless the file changed since it was stored.
+bool QxSampleStore::find(const QString& strFileName, QList<Chunk>& chunks, quint64& uSampleCount) const
+{
+	QFileInfo fileInfo(strFileName);
+	QMutexLocker locker(&m_Mutex);
+	QHash<QString, Entry>::const_iterator itr = m_Entries.constFind(strFileName);
+	if (itr == m_Entries.constEnd() || itr->iFileSize != fileInfo.size() || itr->lastModified != fileInfo.lastModified())
+	{
+		return false;
+	}
+	chunks = itr->chunks;
+	uSampleCount = itr->uSampleCount;
+	return true;
+}
+
+//Samples of a chunk, read back from its spill file when needed.
+bool QxSampleStore::loadChunk(const Chunk& chunk, QSharedPointer<const QByteArray>& pSamples)
+{
+	if (chunk.pSamples)
+	{
+		pSamples = chunk.pSamples;
+		return true;
+	}
+	QFile spillFile(chunk.strSpillFileName);
+	if (!spillFile.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+	QSharedPointer<const QByteArray> pSpilledSamples(new QByteArray(spillFile.readAll()));
+	if (pSpilledSamples->size() != chunk.iSize)
+	{
+		return false;
+	}
+	pSamples = pSpilledSamples;
+	return true;
+}
+
+//Make a chunk of samples, in memory within the budget, in the spill folder otherwise.
+bool QxSampleStore::makeChunk(const QByteArray& samples, Chunk& chunk)
+{
+	QMutexLocker locker(&m_Mutex);
+	chunk.iSize = samples.size();
+	chunk.iGeneration = m_iGeneration;
+	if (m_iMemorySize + chunk.iSize <= m_iMemoryBudget)
+	{
+		// without the spare capacity left by the appends
+		QByteArray* pSamples = new QByteArray(samples);
+		pSamples->squeeze();
+		chunk.pSamples = QSharedPointer<const QByteArray>(pSamples);
+		m_iMemorySize += chunk.iSize;
+		return true;
+	}
+	if (!m_pSpillDir)
+	{
+		m_pSpillDir.reset(new QTemporaryDir);
+	}
+	chunk.strSpillFileName = m_pSpillDir->path() + QString("/%1.samples").arg(m_iSpillFileCount++);
+	QFile spillFile(chunk.strSpillFileName);
+	if (!m_pSpillDir->isValid() || !spillFile.open(QIODevice::WriteOnly) || spillFile.write(samples) != samples.size())
+	{
+		spillFile.remove();
+		return false;
+	}
+	return true;
+}
+
+//Store the chunks of a file read from its beginning to its end.
+void QxSampleStore::insert(const QString& strFileName, const QList<Chunk>& chunks, quint64 uSampleCount, qint64 iRawSize)
+{
+	QFileInfo fileInfo(strFileName);
+	QMutexLocker locker(&m_Mutex);
+	for (int i = 0; i != chunks.size(); ++i)
+	{
+		if (chunks.at(i).iGeneration != m_iGeneration)
+		{
+			// made before clear(), they are gone already
+			return;
+		}
+	}
+	removeEntry(strFileName);
+
+	Entry entry;
+	entry.iFileSize = fileInfo.size();
+	entry.lastModified = fileInfo.lastModified();
+	entry.uSampleCount = uSampleCount;
+	entry.iRawSize = iRawSize;
+	entry.chunks = chunks;
+	m_Entries.insert(strFileName, entry);
+}
+
+void QxSampleStore::release(const QList<Chunk>& chunks)
+{
+	QMutexLocker locker(&m_Mutex);
+	releaseChunks(chunks);
+}
+
+//Append a sample in the stored form: header, then the runs of each row.
+void QxSampleStore::appendRecord(QByteArray& samples, const QxGntRecord& record)
+{
+	uchar header[g_iStoredHeaderSize];
+	const quint32 fields[] = { record.uTagCode, record.uWidth, record.uHeight };
+	for (int i = 0; i != 3; ++i)
+	{
+		header[2 * i] = uchar(fields[i]);
+		header[2 * i + 1] = uchar(fields[i] >> 8);
+	}
+	samples.append(reinterpret_cast<const char*>(header), g_iStoredHeaderSize);
+
+	const int iWidth = int(record.uWidth);
+	const uchar* pPixels = reinterpret_cast<const uchar*>(record.bitmap.constData());
+	for (quint32 row = 0; row != record.uHeight; ++row, pPixels += iWidth)
+	{
+		// white run, then ink run and its pixels, until the row is filled
+		int x = 0;
+		while (x != iWidth)
+		{
+			int iWhite = 0;
+			while (x + iWhite != iWidth && iWhite != g_iMaxRun && pPixels[x + iWhite] == 255)
+			{
+				++iWhite;
+			}
+			x += iWhite;
+			int iInk = 0;
+			while (x + iInk != iWidth && iInk != g_iMaxRun && pPixels[x + iInk] != 255)
+			{
+				++iInk;
+			}
+			samples.append(char(iWhite)).append(char(iInk));
+			samples.append(reinterpret_cast<const char*>(pPixels + x), iInk);
+			x += iInk;
+		}
+	}
+}
+
+//Read a stored sample and move iPosition to the next one.
+bool QxSampleStore::readRecord(const QByteArray& samples, qint64& iPosition, QxGntRecord& record)
+{
+	const uchar* pData = reinterpret_cast<const uchar*>(samples.constData());
+	const qint64 iSize = samples.size();
+	if (iSize - iPosition < g_iStoredHeaderSize)
+	{
+		return false;
+	}
+	const uchar* pHeader = pData + iPosition;
+	record.uTagCode = pHeader[0] + quint32(pHeader[1]) * (1 << 8);
+	record.uWidth = pHeader[2] + quint32(pHeader[3]) * (1 << 8);
+	record.uHeight = pHeader[4] + quint32(pHeader[5]) * (1 << 8);
+	qint64 iPos = iPosition + g_iStoredHeaderSize;
+	// every row takes a token at least, check before allocating the bitmap of a corrupt header
+	if (quint64(record.uWidth) * record.uHeight > INT_MAX || (record.uWidth && 2 * qint64(record.uHeight) > iSize - iPos))
+	{
+		return false;
+	}
+
+	const int iWidth = int(record.uWidth);
+	record.bitmap.resize(int(record.uWidth * record.uHeight));
+	uchar* pPixels = reinterpret_cast<uchar*>(record.bitmap.data());
+	for (quint32 row = 0; row != record.uHeight; ++row, pPixels += iWidth)
+	{
+		int x = 0;
+		while (x != iWidth)
+		{
+			if (iSize - iPos < 2)
+			{
+				return false;
+			}
+			int iWhite = pData[iPos];
+			int iInk = pData[iPos + 1];
+			iPos += 2;
+			if (x + iWhite + iInk > iWidth || iSize - iPos < iInk)
+			{
+				return false;
+			}
+			memset(pPixels + x, 255, iWhite);
+			x += iWhite;
+			memcpy(pPixels + x, pData + iPos, iInk);
+			x += iInk;
+			iPos += iInk;
+		}
+	}
+	iPosition = iPos;
+	return true;
+}
+
+int QxSampleStore::fileCount() const
+{
+	QMutexLocker locker(&m_Mutex);
+	return m_Entries.size();
+}
+
+quint64 QxSampleStore::sampleCount() const
+{
+	QMutexLocker locker(&m_Mutex);
+	quint64 uSampleCount = 0;
+	for (QHash<QString, Entry>::const_iterator itr = m_Entries.constBegin(); itr != m_Entries.constEnd(); ++itr)
+	{
+		uSampleCount += itr->uSampleCount;
+	}
+	return uSampleCount;
+}
+
+qint64 QxSampleStore::rawSize() const
+{
+	QMutexLocker locker(&m_Mutex);
+	qint64 iRawSize = 0;
+	for (QHash<QString, Entry>::const_iterator itr = m_Entries.constBegin(); itr != m_Entries.constEnd(); ++itr)
+	{
+		iRawSize += itr->iRawSize;
+	}
+	return iRawSize;
+}
+
+qint64 QxSampleStore::memorySize() const
+{
+	QMutexLocker locker(&m_Mutex);
+	return m_iMemorySize;
+}
+
+qint64 QxSampleStore::spilledSize() const
+{
+	QMutexLocker locker(&m_Mutex);
+	qint64 iSpilledSize = 0;
+	for (QHash<QString, Entry>::const_iterator itr = m_Entries.constBegin(); itr != m_Entries.constEnd(); ++itr)
+	{
+		for (int i = 0; i != itr->chunks.size(); ++i)
+		{
+			if (!itr->chunks.at(i).pSamples)
+			{
+				iSpilledSize += itr->chunks.at(i).iSize;
+			}
+		}
+	}
+	return iSpilledSize;
+}
+
+//One line summary of the statistics, e.g. "12 files stored (3456 samples of 31.0 MB: 10.2 MB in memory, 0.0 MB on disk)".
+QString QxSampleStore::statistics() const
+{
+	const double dMegaByte = 1024.0 * 1024.0;
+	return QString("%1 files stored (%2 samples of %3 MB: %4 MB in memory, %5 MB on disk)").arg(fileCount()).arg(sampleCount())
+		.arg(rawSize() / dMegaByte, 0, 'f', 1).arg(memorySize() / dMegaByte, 0, 'f', 1).arg(spilledSize() / dMegaByte, 0, 'f', 1);
+}
+
+//Forget an entry, removing its spill files.
+void QxSampleStore::removeEntry(const QString& strFileName)
+{
+	QHash<QString, Entry>::iterator itr = m_Entries.find(strFileName);
+	if (itr == m_Entries.end())
+	{
+		return;
+	}
+	releaseChunks(itr->chunks);
+	m_Entries.erase(itr);
+}
+
+//Give back the memory and the spill files of chunks, unless they were made before clear().
+void QxSampleStore::releaseChunks(const QList<Chunk>& chunks)
+{
+	for (int i = 0; i != chunks.size(); ++i)
+	{
+		const Chunk& chunk = chunks.at(i);
+		if (chunk.iGeneration != m_iGeneration)
+		{
+			continue;
+		}
+		if (chunk.pSamples)
+		{
+			m_iMemorySize -= chunk.iSize;
+		}
+		else
+		{
+			QFile::remove(chunk.strSpillFileName);
+		}
+	}
+}
@@ -0,0 +1,103 @@
+#ifndef _QX_SAMPLE_STORE_H_
+#define _QX_SAMPLE_STORE_H_
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QString>
+
+class QTemporaryDir;
+struct QxGntRecord;
+
+/*
+	Samples of the .gnt files read so far, kept in memory in a compact form, so that repeated decodings and previews
+	of the same file list don't read and parse the files again (see QxGntReader::open()).
+	Each sample keeps its tag code and size, and its bitmap as row runs: the number of white (255) pixels, then the number
+	of other pixels followed by their values, as many times as needed to fill the row. The glyphs are mostly white
+	background, thus a sample takes a fraction of its raw size, and nothing is lost.
+	The samples of a file are handed to the store in chunks while it is read, so that the memory budget holds even for
+	files larger than it, and the file is stored once it has been read to its end without error. Beyond the memory budget,
+	the next chunks are spilled to a temporary folder, which is still faster than parsing and decompressing them again.
+	A file which changed on disk (size or modification time) is read again. The member functions are thread-safe.
+*/
+class QxSampleStore
+{
+public:
+	static const qint64 DefaultMemoryBudget = Q_INT64_C(1024) * 1024 * 1024;
+	// Size from which the samples read are handed to the store as a chunk.
+	static const int ChunkSize = 16 * 1024 * 1024;
+
+	// Part of the samples of a file, in memory or in a spill file.
+	struct Chunk
+	{
+		Chunk() : iSize(0), iGeneration(0) {}
+
+		QSharedPointer<const QByteArray> pSamples;
+		QString strSpillFileName;
+		qint64 iSize;
+		// clear() drops the chunks made before it
+		int iGeneration;
+	};
+
+	explicit QxSampleStore(qint64 iMemoryBudget = DefaultMemoryBudget);
+	~QxSampleStore();
+
+	void clear();
+	void remove(const QString& strFileName);
+	// Chunks and number of samples of a stored file. Return false when the file is not stored.
+	bool find(const QString& strFileName, QList<Chunk>& chunks, quint64& uSampleCount) const;
+	// Samples of a chunk, read back from its spill file when needed. Return false when the spill file can't be read.
+	static bool loadChunk(const Chunk& chunk, QSharedPointer<const QByteArray>& pSamples);
+	// Make a chunk of the samples of a file being read, in memory within the budget, in the spill folder otherwise.
+	// Return false when it can't be spilled either, the file is then not stored (release() the chunks made so far).
+	bool makeChunk(const QByteArray& samples, Chunk& chunk);
+	// Store the chunks of a file read from its beginning to its end, iRawSize bytes of .gnt samples.
+	void insert(const QString& strFileName, const QList<Chunk>& chunks, quint64 uSampleCount, qint64 iRawSize);
+	// Give back the memory and the spill files of chunks which are not inserted.
+	void release(const QList<Chunk>& chunks);
+
+	// Append a sample to the samples of a file, in the stored form.
+	static void appendRecord(QByteArray& samples, const QxGntRecord& record);
+	// Read the sample at iPosition of the samples of a file, and move iPosition to the next one. uOffset and uIndex
+	// of the record are not set. Return false when no complete sample is left at iPosition, which is then unchanged:
+	// at the end of the samples iPosition is their size, anywhere else the sample is corrupt.
+	static bool readRecord(const QByteArray& samples, qint64& iPosition, QxGntRecord& record);
+
+	// Statistics: stored files and samples, and bytes of the raw samples, in memory and spilled to disk.
+	int fileCount() const;
+	quint64 sampleCount() const;
+	qint64 rawSize() const;
+	qint64 memorySize() const;
+	qint64 spilledSize() const;
+	QString statistics() const;
+
+private:
+	struct Entry
+	{
+		qint64 iFileSize;
+		QDateTime lastModified;
+		quint64 uSampleCount;
+		qint64 iRawSize;
+		QList<Chunk> chunks;
+	};
+
+	// Forget an entry, removing its spill files. Called with the mutex locked.
+	void removeEntry(const QString& strFileName);
+	// Give back the memory and the spill files of chunks. Called with the mutex locked.
+	void releaseChunks(const QList<Chunk>& chunks);
+
+private:
+	mutable QMutex m_Mutex;
+	qint64 m_iMemoryBudget;
+	QHash<QString, Entry> m_Entries;
+	qint64 m_iMemorySize;
+	QScopedPointer<QTemporaryDir> m_pSpillDir;
+	int m_iSpillFileCount;
+	int m_iGeneration;
+};
+
+#endif
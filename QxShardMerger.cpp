@@ -0,0 +1,348 @@
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include "QxDecoder.h"
+#include "QxNpyWriter.h"
+#include "QxShardMerger.h"
+
+// Magic string of the .npy files, followed by the format version (2 bytes).
+static const QByteArray g_NpyMagic("\x93NUMPY", 6);
+
+QxShardMerger::QxShardMerger()
+	: m_uSampleCount(0)
+{
+}
+
+//Merge the output folders of the shards into strDestinationPath.
+bool QxShardMerger::merge(const QStringList& shardPaths, const QString& strDestinationPath)
+{
+	m_CodeLabelMap.clear();
+	m_uSampleCount = 0;
+	m_strError.clear();
+	for (QStringList::const_iterator itr = shardPaths.begin(); itr != shardPaths.end(); ++itr)
+	{
+		// The label files of the shard would be overwritten while being read.
+		if (QFileInfo(*itr).canonicalFilePath() == QFileInfo(strDestinationPath).canonicalFilePath())
+		{
+			m_strError = "The merged files must go to a folder which is not one of the shards: " + strDestinationPath;
+			return false;
+		}
+	}
+
+	// Global labels: all the tag codes of all the shards, sorted.
+	QList<QHash<quint32, quint32> > shardLabelCodes;
+	for (QStringList::const_iterator itr = shardPaths.begin(); itr != shardPaths.end(); ++itr)
+	{
+		shardLabelCodes.append(QHash<quint32, quint32>());
+		if (!readMappingFile(*itr, shardLabelCodes.last()))
+		{
+			return false;
+		}
+		for (QHash<quint32, quint32>::const_iterator itrCode = shardLabelCodes.last().begin(); itrCode != shardLabelCodes.last().end(); ++itrCode)
+		{
+			m_CodeLabelMap.insert(itrCode.value(), 0);
+		}
+	}
+	quint32 uLabel = 0;
+	for (QMap<quint32, quint32>::iterator itr = m_CodeLabelMap.begin(); itr != m_CodeLabelMap.end(); ++itr)
+	{
+		itr.value() = uLabel++;
+	}
+	if (!writeMappingFile(strDestinationPath))
+	{
+		return false;
+	}
+
+	// Every label file found in at least one shard.
+	for (int iSet = -1; iSet != QxDecodeSettings::SplitSetCount; ++iSet)
+	{
+		QString strLabelFileName = (iSet < 0) ? QxDecoder::labelFileName(QxDecodeSettings::NoSplit, QxDecodeSettings::TrainSet)
+			: QxDecoder::labelFileName(QxDecodeSettings::SplitBySample, QxDecodeSettings::SplitSet(iSet));
+		QString strManifestFileName = (iSet < 0) ? QxDecoder::manifestFileName(QxDecodeSettings::NoSplit, QxDecodeSettings::TrainSet)
+			: QxDecoder::manifestFileName(QxDecodeSettings::SplitBySample, QxDecodeSettings::SplitSet(iSet));
+		QString strTensorLabelFileName = (iSet < 0) ? QxDecoder::tensorLabelFileName(QxDecodeSettings::NoSplit, QxDecodeSettings::TrainSet)
+			: QxDecoder::tensorLabelFileName(QxDecodeSettings::SplitBySample, QxDecodeSettings::SplitSet(iSet));
+		if (!mergeLabelFile(shardPaths, shardLabelCodes, strLabelFileName, strDestinationPath)
+			|| !mergeManifestFile(shardPaths, shardLabelCodes, strManifestFileName, strDestinationPath)
+			|| !mergeTensorLabelFile(shardPaths, shardLabelCodes, strTensorLabelFileName, strDestinationPath))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+QString QxShardMerger::errorString() const
+{
+	return m_strError;
+}
+
+quint32 QxShardMerger::classCount() const
+{
+	return m_CodeLabelMap.size();
+}
+
+quint64 QxShardMerger::sampleCount() const
+{
+	return m_uSampleCount;
+}
+
+//Read the code_label.txt file of a shard: tag code of each label of the shard.
+bool QxShardMerger::readMappingFile(const QString& strShardPath, QHash<quint32, quint32>& labelCodes)
+{
+	QFile file(strShardPath + "/" + QxDecoder::mappingFileName());
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		m_strError = QString("Can not open %1: %2").arg(file.fileName()).arg(file.errorString());
+		return false;
+	}
+
+	// "Code      Label" header, then one "code label" line per class.
+	QTextStream textStream(&file);
+	textStream.readLine();
+	while (!textStream.atEnd())
+	{
+		QStringList fields = textStream.readLine().split(' ', QString::SkipEmptyParts);
+		if (fields.isEmpty())
+		{
+			continue;
+		}
+		bool bCodeOk = false;
+		bool bLabelOk = false;
+		quint32 uCode = fields.first().toUInt(&bCodeOk);
+		quint32 uLabel = fields.size() == 2 ? fields.last().toUInt(&bLabelOk) : 0;
+		if (!bCodeOk || !bLabelOk)
+		{
+			m_strError = "Invalid line in " + file.fileName();
+			return false;
+		}
+		labelCodes.insert(uLabel, uCode);
+	}
+	return true;
+}
+
+bool QxShardMerger::writeMappingFile(const QString& strDestinationPath)
+{
+	// Same layout as the files written by QxDecoder.
+	QFile file(strDestinationPath + "/" + QxDecoder::mappingFileName());
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		m_strError = QString("Can not create %1: %2").arg(file.fileName()).arg(file.errorString());
+		return false;
+	}
+	const int iWordWidth = 10;
+	QTextStream textStream(&file);
+	textStream << qSetFieldWidth(iWordWidth) << left << "Code" << "Label" << qSetFieldWidth(0) << "\n";
+	for (QMap<quint32, quint32>::const_iterator itr = m_CodeLabelMap.begin(); itr != m_CodeLabelMap.end(); ++itr)
+	{
+		textStream << qSetFieldWidth(iWordWidth) << left << itr.key() << itr.value() << qSetFieldWidth(0) << "\n";
+	}
+	return true;
+}
+
+//Concatenate a label file of all the shards, with the labels translated to the global ones.
+bool QxShardMerger::mergeLabelFile(const QStringList& shardPaths, const QList<QHash<quint32, quint32> >& shardLabelCodes,
+	const QString& strLabelFileName, const QString& strDestinationPath)
+{
+	QFile outputFile(strDestinationPath + "/" + strLabelFileName);
+	for (int iShard = 0; iShard != shardPaths.size(); ++iShard)
+	{
+		QFile inputFile(shardPaths.at(iShard) + "/" + strLabelFileName);
+		if (!inputFile.exists())
+		{
+			continue;
+		}
+		if (!inputFile.open(QIODevice::ReadOnly) || (!outputFile.isOpen() && !outputFile.open(QIODevice::WriteOnly)))
+		{
+			m_strError = QString("Can not merge %1: %2").arg(inputFile.fileName()).arg(inputFile.isOpen() ? outputFile.errorString() : inputFile.errorString());
+			return false;
+		}
+
+		// "image name<separator>label" lines: only the label after the last separator changes.
+		while (!inputFile.atEnd())
+		{
+			QByteArray line = inputFile.readLine();
+			while (line.endsWith('\n') || line.endsWith('\r'))
+			{
+				line.chop(1);
+			}
+			if (line.isEmpty())
+			{
+				continue;
+			}
+			int iSeparator = qMax(line.lastIndexOf(' '), line.lastIndexOf('\t'));
+			bool bLabelOk = false;
+			quint32 uShardLabel = line.mid(iSeparator + 1).toUInt(&bLabelOk);
+			QHash<quint32, quint32>::const_iterator itrCode = shardLabelCodes.at(iShard).constFind(uShardLabel);
+			if (iSeparator < 0 || !bLabelOk || itrCode == shardLabelCodes.at(iShard).constEnd())
+			{
+				m_strError = QString("Unknown label in %1: %2").arg(inputFile.fileName()).arg(QString::fromUtf8(line));
+				return false;
+			}
+			line.truncate(iSeparator + 1);
+			line.append(QByteArray::number(m_CodeLabelMap.value(itrCode.value()))).append('\n');
+			outputFile.write(line);
+			++m_uSampleCount;
+		}
+	}
+	if (outputFile.isOpen() && outputFile.error() != QFile::NoError)
+	{
+		m_strError = QString("Can not write %1: %2").arg(outputFile.fileName()).arg(outputFile.errorString());
+		return false;
+	}
+	return true;
+}
+
+//Concatenate an atlas manifest of all the shards: global sample indexes and labels, and the shard holding each sheet.
+bool QxShardMerger::mergeManifestFile(const QStringList& shardPaths, const QList<QHash<quint32, quint32> >& shardLabelCodes,
+	const QString& strManifestFileName, const QString& strDestinationPath)
+{
+	QFile outputFile(strDestinationPath + "/" + strManifestFileName);
+	quint64 uIndex = 0;
+	for (int iShard = 0; iShard != shardPaths.size(); ++iShard)
+	{
+		QFile inputFile(shardPaths.at(iShard) + "/" + strManifestFileName);
+		if (!inputFile.exists())
+		{
+			continue;
+		}
+		if (!inputFile.open(QIODevice::ReadOnly) || (!outputFile.isOpen() && !outputFile.open(QIODevice::WriteOnly)))
+		{
+			m_strError = QString("Can not merge %1: %2").arg(inputFile.fileName()).arg(inputFile.isOpen() ? outputFile.errorString() : inputFile.errorString());
+			return false;
+		}
+		if (outputFile.pos() == 0)
+		{
+			outputFile.write("index shard sheet row col label\n");
+		}
+
+		// "index sheet row col label" lines after the header line.
+		inputFile.readLine();
+		while (!inputFile.atEnd())
+		{
+			QList<QByteArray> fields = inputFile.readLine().simplified().split(' ');
+			if (fields.size() == 1 && fields.first().isEmpty())
+			{
+				continue;
+			}
+			bool bLabelOk = false;
+			quint32 uShardLabel = fields.size() == 5 ? fields.last().toUInt(&bLabelOk) : 0;
+			QHash<quint32, quint32>::const_iterator itrCode = shardLabelCodes.at(iShard).constFind(uShardLabel);
+			if (!bLabelOk || itrCode == shardLabelCodes.at(iShard).constEnd())
+			{
+				m_strError = QString("Unknown label in %1: %2").arg(inputFile.fileName()).arg(QString::fromUtf8(fields.join(' ')));
+				return false;
+			}
+			QByteArray line;
+			line.append(QByteArray::number(uIndex++)).append(' ').append(QByteArray::number(iShard)).append(' ')
+				.append(fields.at(1)).append(' ').append(fields.at(2)).append(' ').append(fields.at(3)).append(' ')
+				.append(QByteArray::number(m_CodeLabelMap.value(itrCode.value()))).append('\n');
+			outputFile.write(line);
+			++m_uSampleCount;
+		}
+	}
+	if (outputFile.isOpen() && outputFile.error() != QFile::NoError)
+	{
+		m_strError = QString("Can not write %1: %2").arg(outputFile.fileName()).arg(outputFile.errorString());
+		return false;
+	}
+	return true;
+}
+
+//Concatenate the packed labels of all the shards, with the labels translated to the global ones.
+bool QxShardMerger::mergeTensorLabelFile(const QStringList& shardPaths, const QList<QHash<quint32, quint32> >& shardLabelCodes,
+	const QString& strLabelFileName, const QString& strDestinationPath)
+{
+	QxNpyWriter writer;
+	const QString strOutputFileName = strDestinationPath + "/" + strLabelFileName;
+	for (int iShard = 0; iShard != shardPaths.size(); ++iShard)
+	{
+		QFile inputFile(shardPaths.at(iShard) + "/" + strLabelFileName);
+		if (!inputFile.exists())
+		{
+			continue;
+		}
+		if (!openTensorLabelFile(inputFile))
+		{
+			return false;
+		}
+		if (!writer.isOpen() && !writer.open(strOutputFileName, QxNpyWriter::Int32, QList<int>()))
+		{
+			m_strError = QString("Can not create %1: %2").arg(strOutputFileName).arg(writer.errorString());
+			return false;
+		}
+
+		// little-endian int32 labels up to the end of the file
+		char label[4];
+		while (inputFile.read(label, 4) == 4)
+		{
+			const quint32 uShardLabel = uchar(label[0]) + quint32(uchar(label[1])) * (1 << 8) + quint32(uchar(label[2])) * (1 << 16)
+				+ quint32(uchar(label[3])) * (1 << 24);
+			QHash<quint32, quint32>::const_iterator itrCode = shardLabelCodes.at(iShard).constFind(uShardLabel);
+			if (itrCode == shardLabelCodes.at(iShard).constEnd())
+			{
+				m_strError = QString("Unknown label in %1: %2").arg(inputFile.fileName()).arg(qint32(uShardLabel));
+				return false;
+			}
+			const quint32 uLabel = m_CodeLabelMap.value(itrCode.value());
+			const uchar globalLabel[4] = { uchar(uLabel), uchar(uLabel >> 8), uchar(uLabel >> 16), uchar(uLabel >> 24) };
+			if (!writer.append(globalLabel))
+			{
+				m_strError = QString("Can not write %1: %2").arg(strOutputFileName).arg(writer.errorString());
+				return false;
+			}
+			++m_uSampleCount;
+		}
+		if (!inputFile.atEnd())
+		{
+			m_strError = QString("Can not read %1: %2").arg(inputFile.fileName()).arg(inputFile.errorString());
+			return false;
+		}
+	}
+	// the sample count goes into the header
+	if (!writer.close())
+	{
+		m_strError = QString("Can not write %1: %2").arg(strOutputFileName).arg(writer.errorString());
+		return false;
+	}
+	return true;
+}
+
+//Open a .npy file of int32 labels (a 1-D array in C order) and move it to its first label.
+bool QxShardMerger::openTensorLabelFile(QFile& file)
+{
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		m_strError = QString("Can not open %1: %2").arg(file.fileName()).arg(file.errorString());
+		return false;
+	}
+	// magic, version, then the header length on 2 bytes (version 1) or 4 bytes (versions 2 and 3)
+	const QByteArray start = file.read(12);
+	const bool bVersion1 = start.size() >= 10 && start.at(6) == 1;
+	const int iLengthSize = bVersion1 ? 2 : 4;
+	if (start.size() < 8 + iLengthSize || !start.startsWith(g_NpyMagic) || start.at(6) < 1 || start.at(6) > 3)
+	{
+		m_strError = "Not a .npy file: " + file.fileName();
+		return false;
+	}
+	qint64 iDictSize = 0;
+	for (int i = iLengthSize - 1; i >= 0; --i)
+	{
+		iDictSize = iDictSize * 256 + uchar(start.at(8 + i));
+	}
+	if (!file.seek(8 + iLengthSize))
+	{
+		m_strError = QString("Can not read %1: %2").arg(file.fileName()).arg(file.errorString());
+		return false;
+	}
+	// e.g. {'descr': '<i4', 'fortran_order': False, 'shape': (1000,), }
+	const QByteArray dict = file.read(iDictSize);
+	if (dict.size() != iDictSize || !dict.contains("'descr': '<i4'") || !dict.contains("'fortran_order': False")
+		|| !dict.contains("'shape': (") || !dict.contains(",)"))
+	{
+		m_strError = "Not a .npy file of int32 labels: " + file.fileName();
+		return false;
+	}
+	return true;
+}
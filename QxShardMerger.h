@@ -0,0 +1,56 @@
+#ifndef _QX_SHARD_MERGER_H_
+#define _QX_SHARD_MERGER_H_
+
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/*
+	Merge the label files of the shards of a decoding (see QxDecodeSettings::iShardCount) into one global labeling.
+	Each shard labels the characters in the order it meets them, so the global labels are given by sorting all the
+	tag codes instead: the result doesn't depend on how the samples were sharded. Only the small code_label.txt files
+	and the label lists are read and rewritten, the images stay where they are.
+	Atlas manifests are merged too. The sheets stay in the shard folders, so each merged line tells the shard its sheet is in:
+		index shard sheet row col label
+	with the shards numbered in the order they are given.
+	Packed labels (labels.npy) are concatenated in the same order with the global labels, thus they match the shards'
+	images.npy files concatenated in the order the shards are given. The images.npy files stay in the shard folders.
+*/
+class QxShardMerger
+{
+public:
+	QxShardMerger();
+
+	// Merge the output folders of the shards into strDestinationPath. Return false and set errorString() on error.
+	bool merge(const QStringList& shardPaths, const QString& strDestinationPath);
+	QString errorString() const;
+
+	quint32 classCount() const;
+	quint64 sampleCount() const;
+
+private:
+	// Read the code_label.txt file of a shard: tag code of each label of the shard.
+	bool readMappingFile(const QString& strShardPath, QHash<quint32, quint32>& labelCodes);
+	bool writeMappingFile(const QString& strDestinationPath);
+	// Concatenate the label file strLabelFileName of all the shards, with the labels translated to the global ones.
+	bool mergeLabelFile(const QStringList& shardPaths, const QList<QHash<quint32, quint32> >& shardLabelCodes,
+		const QString& strLabelFileName, const QString& strDestinationPath);
+	// Concatenate the atlas manifest strManifestFileName of all the shards, with global indexes and labels and the shard of each sheet.
+	bool mergeManifestFile(const QStringList& shardPaths, const QList<QHash<quint32, quint32> >& shardLabelCodes,
+		const QString& strManifestFileName, const QString& strDestinationPath);
+	// Concatenate the packed labels strLabelFileName (.npy of int32) of all the shards, translated to the global labels.
+	bool mergeTensorLabelFile(const QStringList& shardPaths, const QList<QHash<quint32, quint32> >& shardLabelCodes,
+		const QString& strLabelFileName, const QString& strDestinationPath);
+	// Open a .npy file of int32 labels and move it to its first label. Return false and set m_strError when it's not one.
+	bool openTensorLabelFile(QFile& file);
+
+private:
+	// Global label of each tag code.
+	QMap<quint32, quint32> m_CodeLabelMap;
+	quint64 m_uSampleCount;
+	QString m_strError;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include <math.h>
+
+#include <QVector>
+
+#include "QxGntReader.h"
+#include "QxPotReader.h"
+#include "QxStrokeRasterizer.h"
+
+QxStrokeRasterizer::QxStrokeRasterizer(int iSide, double dStrokeWidth)
+	: m_iSide(qMax(iSide, 1))
+	, m_fStrokeWidth(float(qMax(dStrokeWidth, 0.0)))
+{
+}
+
+//Rasterize the strokes of a sample into a white bitmap with black ink.
+void QxStrokeRasterizer::rasterize(const QxPotSample& sample, QxGntRecord& record) const
+{
+	record.uTagCode = sample.uTagCode;
+	record.uOffset = sample.uOffset;
+	record.uIndex = sample.uIndex;
+	const int iPointCount = sample.strokeEnds.isEmpty() ? 0 : sample.strokeEnds.last();
+	if (iPointCount == 0)
+	{
+		// no stroke, like a 0 x 0 .gnt sample
+		record.uWidth = 0;
+		record.uHeight = 0;
+		record.bitmap.clear();
+		return;
+	}
+
+	// Box of the trajectory, scaled so that the longer side plus the stroke width fills iSide pixels.
+	int iMinX = sample.points.at(0).x();
+	int iMaxX = iMinX;
+	int iMinY = sample.points.at(0).y();
+	int iMaxY = iMinY;
+	for (int i = 1; i != iPointCount; ++i)
+	{
+		const QPoint& point = sample.points.at(i);
+		iMinX = qMin(iMinX, point.x());
+		iMaxX = qMax(iMaxX, point.x());
+		iMinY = qMin(iMinY, point.y());
+		iMaxY = qMax(iMaxY, point.y());
+	}
+	const float fRadius = m_fStrokeWidth / 2;
+	const float fScale = qMax(m_iSide - m_fStrokeWidth - 1, 1.0f) / qMax(qMax(iMaxX - iMinX, iMaxY - iMinY), 1);
+	const int iWidth = int(ceil((iMaxX - iMinX) * fScale + m_fStrokeWidth + 1));
+	const int iHeight = int(ceil((iMaxY - iMinY) * fScale + m_fStrokeWidth + 1));
+	// Points are moved in by the stroke radius and half a pixel, so that the strokes fit in the bitmap.
+	const float fShift = fRadius + 0.5f;
+
+	QVector<float> coverage(iWidth * iHeight, 0.0f);
+	int iStart = 0;
+	for (int s = 0; s != sample.strokeEnds.size(); ++s)
+	{
+		const int iEnd = sample.strokeEnds.at(s);
+		// A single point stroke is a dot: a segment from the point to itself.
+		for (int i = iStart; i < iEnd; ++i)
+		{
+			const QPoint& from = sample.points.at(i);
+			const QPoint& to = sample.points.at(qMin(i + 1, iEnd - 1));
+			drawSegment((from.x() - iMinX) * fScale + fShift, (from.y() - iMinY) * fScale + fShift,
+				(to.x() - iMinX) * fScale + fShift, (to.y() - iMinY) * fScale + fShift, coverage.data(), iWidth, iHeight);
+			if (i + 2 >= iEnd)
+			{
+				break;
+			}
+		}
+		iStart = iEnd;
+	}
+
+	record.uWidth = iWidth;
+	record.uHeight = iHeight;
+	record.bitmap.resize(iWidth * iHeight);
+	uchar* pPixels = reinterpret_cast<uchar*>(record.bitmap.data());
+	for (int i = 0; i != iWidth * iHeight; ++i)
+	{
+		pPixels[i] = uchar(255.0f - 255.0f * coverage[i] + 0.5f);
+	}
+}
+
+//Add the coverage of a round-capped segment, scanning each row over the span the segment can cover.
+void QxStrokeRasterizer::drawSegment(float x0, float y0, float x1, float y1, float* pCoverage, int iWidth, int iHeight) const
+{
+	// Coverage goes from 1 to 0 over the pixel across the edge of the band, centered on the stroke radius.
+	const float fReach = m_fStrokeWidth / 2 + 0.5f;
+	const float dx = x1 - x0;
+	const float dy = y1 - y0;
+	const float fLength2 = dx * dx + dy * dy;
+
+	const int iTop = qMax(0, int(floor(qMin(y0, y1) - fReach)));
+	const int iBottom = qMin(iHeight - 1, int(ceil(qMax(y0, y1) + fReach)));
+	for (int y = iTop; y <= iBottom; ++y)
+	{
+		const float fY = y + 0.5f;
+		// Part of the segment within reach of this row, then the columns within reach of that part.
+		float fLeft = qMin(x0, x1);
+		float fRight = qMax(x0, x1);
+		if (fabs(dy) > 1e-6f)
+		{
+			float t0 = (fY - fReach - y0) / dy;
+			float t1 = (fY + fReach - y0) / dy;
+			if (t0 > t1)
+			{
+				qSwap(t0, t1);
+			}
+			t0 = qMax(t0, 0.0f);
+			t1 = qMin(t1, 1.0f);
+			if (t0 > t1)
+			{
+				continue;
+			}
+			fLeft = qMin(x0 + t0 * dx, x0 + t1 * dx);
+			fRight = qMax(x0 + t0 * dx, x0 + t1 * dx);
+		}
+		else if (fabs(fY - y0) > fReach)
+		{
+			continue;
+		}
+		const int iLeft = qMax(0, int(floor(fLeft - fReach)));
+		const int iRight = qMin(iWidth - 1, int(ceil(fRight + fReach)));
+
+		float* pRow = pCoverage + y * iWidth;
+		for (int x = iLeft; x <= iRight; ++x)
+		{
+			// distance from the pixel center to the closest point of the segment
+			const float fX = x + 0.5f;
+			float t = fLength2 > 0.0f ? ((fX - x0) * dx + (fY - y0) * dy) / fLength2 : 0.0f;
+			t = qBound(0.0f, t, 1.0f);
+			const float ex = fX - (x0 + t * dx);
+			const float ey = fY - (y0 + t * dy);
+			const float fCoverage = qMin(fReach - sqrtf(ex * ex + ey * ey), 1.0f);
+			if (fCoverage > pRow[x])
+			{
+				pRow[x] = fCoverage;
+			}
+		}
+	}
+}
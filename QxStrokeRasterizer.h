@@ -0,0 +1,34 @@
+#ifndef _QX_STROKE_RASTERIZER_H_
+#define _QX_STROKE_RASTERIZER_H_
+
+struct QxGntRecord;
+struct QxPotSample;
+
+/*
+	Draw the strokes of an online (.pot) sample into a grayscale bitmap like the ones of .gnt samples (black ink on white),
+	so that online samples go through the same padding, resizing and outputs as offline ones.
+	The sample is scaled so that the longer side of its box, strokes included, is about iSide pixels.
+	Each stroke segment is a round-capped band of the stroke width: it is scanned row by row over the span it can cover,
+	and each pixel gets its coverage from its distance to the segment (linear over one pixel across the edge, which is the
+	anti-aliasing). Overlapping segments keep the darkest coverage, so joints and crossings don't get darker.
+	The member functions are const and thread-safe, samples are rasterized on the worker threads.
+*/
+class QxStrokeRasterizer
+{
+public:
+	// dStrokeWidth is in pixels of the bitmap.
+	QxStrokeRasterizer(int iSide, double dStrokeWidth);
+
+	// Rasterize the strokes into record (bitmap, size), also copying the tag code, offset and index of the sample.
+	void rasterize(const QxPotSample& sample, QxGntRecord& record) const;
+
+private:
+	// Add the coverage of a segment (a dot when both ends are the same) to an iWidth x iHeight coverage map.
+	void drawSegment(float x0, float y0, float x1, float y1, float* pCoverage, int iWidth, int iHeight) const;
+
+private:
+	int m_iSide;
+	float m_fStrokeWidth;
+};
+
+#endif
@@ -1,11 +1,20 @@
 
+#include <QCoreApplication>
 #include <QtWidgets/QApplication>
 
+#include "QxCommandLine.h"
 #include "QxDecodeOptionDlg.h"
 #include "QxMainWindow.h"
 
 int main(int argc, char* argv[])
 {
+	// Command line mode (e.g. "GntDecoder --verify *.gnt") runs without any window.
+	if (QxCommandLine::isRequested(argc, argv))
+	{
+		QCoreApplication app(argc, argv);
+		return QxCommandLine::run(app.arguments());
+	}
+
 	QApplication app(argc, argv);
 
 	QxMainWindow mainWindow;
@@ -0,0 +1,153 @@
+#ifndef _QX_TEST_DATA_H_
+#define _QX_TEST_DATA_H_
+
+#include <string.h>
+#include <zlib.h>
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QPoint>
+#include <QString>
+#include <QVector>
+
+#include "QxGntReader.h"
+
+/*
+	Small .gnt, .pot, .dgr and gzip files made up by the tests, in the layouts documented by the readers.
+*/
+
+inline void qxAppendUInt16(QByteArray& data, quint32 uValue)
+{
+	data.append(char(uValue)).append(char(uValue >> 8));
+}
+
+inline void qxAppendUInt32(QByteArray& data, quint32 uValue)
+{
+	qxAppendUInt16(data, uValue & 0xFFFF);
+	qxAppendUInt16(data, uValue >> 16);
+}
+
+//Sample of uWidth x uHeight pixels: white background, with ink pixels which depend on iSeed.
+inline QxGntRecord qxMakeRecord(quint32 uTagCode, quint32 uWidth, quint32 uHeight, int iSeed)
+{
+	QxGntRecord record;
+	record.uTagCode = uTagCode;
+	record.uWidth = uWidth;
+	record.uHeight = uHeight;
+	record.bitmap.fill(char(255), int(uWidth * uHeight));
+	for (quint32 y = 0; y != uHeight; ++y)
+	{
+		for (quint32 x = 0; x != uWidth; ++x)
+		{
+			if ((x + y * 3 + quint32(iSeed)) % 5 < 2)
+			{
+				record.bitmap[int(y * uWidth + x)] = char((x * 7 + y * 13 + quint32(iSeed)) % 200);
+			}
+		}
+	}
+	return record;
+}
+
+//Samples in the .gnt layout: data length, tag code, width and height, then the bitmap.
+inline QByteArray qxGntData(const QList<QxGntRecord>& records)
+{
+	QByteArray data;
+	for (QList<QxGntRecord>::const_iterator itr = records.begin(); itr != records.end(); ++itr)
+	{
+		qxAppendUInt32(data, QxGntReader::RecordHeaderSize + itr->uWidth * itr->uHeight);
+		qxAppendUInt16(data, itr->uTagCode);
+		qxAppendUInt16(data, itr->uWidth);
+		qxAppendUInt16(data, itr->uHeight);
+		data.append(itr->bitmap);
+	}
+	return data;
+}
+
+//Sample in the .pot layout: the points of each stroke ended by (-1, 0), then (-1, -1).
+inline QByteArray qxPotData(quint32 uTagCode, const QList<QVector<QPoint> >& strokes)
+{
+	QByteArray points;
+	for (QList<QVector<QPoint> >::const_iterator itr = strokes.begin(); itr != strokes.end(); ++itr)
+	{
+		for (QVector<QPoint>::const_iterator itrPoint = itr->begin(); itrPoint != itr->end(); ++itrPoint)
+		{
+			qxAppendUInt16(points, quint16(itrPoint->x()));
+			qxAppendUInt16(points, quint16(itrPoint->y()));
+		}
+		qxAppendUInt16(points, 0xFFFF);
+		qxAppendUInt16(points, 0);
+	}
+	qxAppendUInt16(points, 0xFFFF);
+	qxAppendUInt16(points, 0xFFFF);
+
+	QByteArray data;
+	qxAppendUInt16(data, 8 + points.size());
+	qxAppendUInt32(data, uTagCode);
+	qxAppendUInt16(data, strokes.size());
+	data.append(points);
+	return data;
+}
+
+//Header of a .dgr file with 2-byte labels and 8 bits per pixel.
+inline QByteArray qxDgrHeader()
+{
+	QByteArray data;
+	qxAppendUInt32(data, 36);
+	data.append("DGR", 3).append(QByteArray(5, '\0'));
+	data.append(QByteArray(20, '\0'));
+	qxAppendUInt16(data, 2);
+	qxAppendUInt16(data, 8);
+	return data;
+}
+
+//Page of a .dgr file, one text line per list of samples.
+inline QByteArray qxDgrPage(const QList<QList<QxGntRecord> >& lines)
+{
+	QByteArray data;
+	qxAppendUInt32(data, 100);
+	qxAppendUInt32(data, 400);
+	qxAppendUInt32(data, lines.size());
+	for (QList<QList<QxGntRecord> >::const_iterator itr = lines.begin(); itr != lines.end(); ++itr)
+	{
+		qxAppendUInt32(data, itr->size());
+		for (QList<QxGntRecord>::const_iterator itrRecord = itr->begin(); itrRecord != itr->end(); ++itrRecord)
+		{
+			qxAppendUInt16(data, itrRecord->uTagCode);
+		}
+		for (QList<QxGntRecord>::const_iterator itrRecord = itr->begin(); itrRecord != itr->end(); ++itrRecord)
+		{
+			qxAppendUInt16(data, 0);
+			qxAppendUInt16(data, 0);
+			qxAppendUInt16(data, itrRecord->uHeight);
+			qxAppendUInt16(data, itrRecord->uWidth);
+			data.append(itrRecord->bitmap);
+		}
+	}
+	return data;
+}
+
+//One gzip member holding data.
+inline QByteArray qxGzipData(const QByteArray& data)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+	QByteArray compressed(int(deflateBound(&stream, uLong(data.size()))), '\0');
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+	stream.avail_in = uInt(data.size());
+	stream.next_out = reinterpret_cast<Bytef*>(compressed.data());
+	stream.avail_out = uInt(compressed.size());
+	deflate(&stream, Z_FINISH);
+	compressed.resize(int(stream.total_out));
+	deflateEnd(&stream);
+	return compressed;
+}
+
+inline bool qxWriteFile(const QString& strFileName, const QByteArray& data)
+{
+	QFile file(strFileName);
+	return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+#endif
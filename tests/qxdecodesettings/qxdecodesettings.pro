@@ -0,0 +1,21 @@
+include(../tests.pri)
+
+# QxDecodeSettings.h names the application types of the option dialog.
+QT += widgets
+
+TARGET = tst_qxdecodesettings
+
+SOURCES += tst_qxdecodesettings.cpp \
+    $$SOURCE_PATH/QxAugmenter.cpp \
+    $$SOURCE_PATH/QxDecodeSettings.cpp
+
+HEADERS += \
+    $$SOURCE_PATH/QxAugmenter.h \
+    $$SOURCE_PATH/QxDecodeOptionDlg.h \
+    $$SOURCE_PATH/QxDecodeSettings.h \
+    $$SOURCE_PATH/QxHash.h
+
+
+unix:!macx: LIBS += -lopencv_core
+
+unix:!macx: LIBS += -lopencv_imgproc
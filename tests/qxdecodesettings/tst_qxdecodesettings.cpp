@@ -0,0 +1,204 @@
+#include <QtTest>
+
+#include "QxAugmenter.h"
+#include "QxDecodeSettings.h"
+
+/*
+	File keys, and the split, shard and augmentation decisions made from them: they only depend on the file name
+	(not its folder or compression) and the sample index, and never change between versions.
+*/
+class tst_QxDecodeSettings : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void fileKey_data();
+	void fileKey();
+
+	void splitSetStable_data();
+	void splitSetStable();
+	void splitSetIgnoresFolder();
+	void splitSetPercentages();
+	void splitByFileKeepsFilesTogether();
+
+	void inShardStable_data();
+	void inShardStable();
+	void inShardPartition();
+
+	void variantSeed();
+};
+
+void tst_QxDecodeSettings::fileKey_data()
+{
+	QTest::addColumn<QString>("strFileName");
+	QTest::addColumn<QByteArray>("key");
+
+	QTest::newRow("gnt") << "/data/1001-c.gnt" << QByteArray("1001-c");
+	QTest::newRow("dots") << "/data/1.0train-gb1.gnt.gz" << QByteArray("1.0train-gb1");
+	QTest::newRow("zstd") << "C:/HWDB2.0/001-P16.dgr.zst" << QByteArray("001-P16");
+	QTest::newRow("upper case") << "relative/PotSimple01.POT.GZ" << QByteArray("PotSimple01");
+	QTest::newRow("compression only") << "archive.tar.gz" << QByteArray("archive.tar");
+	QTest::newRow("other suffix") << "notes.txt" << QByteArray("notes.txt");
+	QTest::newRow("no folder") << "1001-c.gnt" << QByteArray("1001-c");
+}
+
+void tst_QxDecodeSettings::fileKey()
+{
+	QFETCH(QString, strFileName);
+	QFETCH(QByteArray, key);
+	QCOMPARE(QxDecodeSettings::fileKey(strFileName), key);
+}
+
+void tst_QxDecodeSettings::splitSetStable_data()
+{
+	QTest::addColumn<int>("splitMode");
+	QTest::addColumn<QString>("strFileName");
+	QTest::addColumn<quint64>("uIndex");
+	QTest::addColumn<int>("set");
+
+	// 80/10/10 with seed 0: the hash bucket (0..99) of the key picks the set
+	QTest::newRow("file, bucket 72") << int(QxDecodeSettings::SplitByFile) << "1001-c.gnt" << quint64(5) << int(QxDecodeSettings::TrainSet);
+	QTest::newRow("file, bucket 83") << int(QxDecodeSettings::SplitByFile) << "PotSimple01.pot" << quint64(0) << int(QxDecodeSettings::ValidationSet);
+	QTest::newRow("sample, bucket 0") << int(QxDecodeSettings::SplitBySample) << "1001-c.gnt" << quint64(2) << int(QxDecodeSettings::TrainSet);
+	QTest::newRow("sample, bucket 75") << int(QxDecodeSettings::SplitBySample) << "1001-c.gnt" << quint64(4) << int(QxDecodeSettings::TrainSet);
+	QTest::newRow("sample, bucket 98") << int(QxDecodeSettings::SplitBySample) << "1001-c.gnt" << quint64(5) << int(QxDecodeSettings::TestSet);
+	QTest::newRow("no split") << int(QxDecodeSettings::NoSplit) << "1001-c.gnt" << quint64(5) << int(QxDecodeSettings::TrainSet);
+}
+
+void tst_QxDecodeSettings::splitSetStable()
+{
+	QFETCH(int, splitMode);
+	QFETCH(QString, strFileName);
+	QFETCH(quint64, uIndex);
+	QFETCH(int, set);
+
+	QxDecodeSettings settings;
+	settings.splitMode = QxDecodeSettings::SplitMode(splitMode);
+	QCOMPARE(int(settings.splitSet(strFileName, uIndex)), set);
+}
+
+void tst_QxDecodeSettings::splitSetIgnoresFolder()
+{
+	QxDecodeSettings settings;
+	settings.splitMode = QxDecodeSettings::SplitBySample;
+	settings.uSplitSeed = 12345;
+	for (quint64 uIndex = 0; uIndex != 200; ++uIndex)
+	{
+		const QxDecodeSettings::SplitSet set = settings.splitSet("/mnt/a/1001-c.gnt", uIndex);
+		QCOMPARE(settings.splitSet("D:/b/1001-c.gnt.zst", uIndex), set);
+		QCOMPARE(settings.splitSet("1001-c.gnt.gz", uIndex), set);
+	}
+}
+
+void tst_QxDecodeSettings::splitSetPercentages()
+{
+	QxDecodeSettings settings;
+	settings.splitMode = QxDecodeSettings::SplitBySample;
+	settings.uTrainPercent = 70;
+	settings.uValidationPercent = 20;
+	int setCounts[QxDecodeSettings::SplitSetCount] = { 0, 0, 0 };
+	const int iSampleCount = 20000;
+	for (int i = 0; i != iSampleCount; ++i)
+	{
+		++setCounts[settings.splitSet("1001-c.gnt", quint64(i))];
+	}
+	QVERIFY(qAbs(setCounts[QxDecodeSettings::TrainSet] - iSampleCount * 70 / 100) < iSampleCount / 50);
+	QVERIFY(qAbs(setCounts[QxDecodeSettings::ValidationSet] - iSampleCount * 20 / 100) < iSampleCount / 50);
+	QVERIFY(qAbs(setCounts[QxDecodeSettings::TestSet] - iSampleCount * 10 / 100) < iSampleCount / 50);
+
+	// another seed, another split
+	QxDecodeSettings otherSettings = settings;
+	otherSettings.uSplitSeed = 1;
+	int iDifferentCount = 0;
+	for (int i = 0; i != 1000; ++i)
+	{
+		iDifferentCount += (settings.splitSet("1001-c.gnt", quint64(i)) != otherSettings.splitSet("1001-c.gnt", quint64(i)));
+	}
+	QVERIFY(iDifferentCount > 100);
+}
+
+void tst_QxDecodeSettings::splitByFileKeepsFilesTogether()
+{
+	QxDecodeSettings settings;
+	settings.splitMode = QxDecodeSettings::SplitByFile;
+	settings.uSplitSeed = 7;
+	const char* fileNames[] = { "1001-c.gnt", "1.0train-gb1.gnt", "PotSimple01.pot", "C001-f-f.dgr" };
+	for (int i = 0; i != 4; ++i)
+	{
+		const QxDecodeSettings::SplitSet set = settings.splitSet(fileNames[i], 0);
+		for (quint64 uIndex = 1; uIndex != 100; ++uIndex)
+		{
+			QCOMPARE(settings.splitSet(fileNames[i], uIndex), set);
+		}
+	}
+}
+
+void tst_QxDecodeSettings::inShardStable_data()
+{
+	QTest::addColumn<int>("shardMode");
+	QTest::addColumn<QString>("strFileName");
+	QTest::addColumn<quint64>("uIndex");
+	QTest::addColumn<int>("iShard");
+
+	// 4 shards
+	QTest::newRow("file 1001-c") << int(QxDecodeSettings::ShardByFile) << "/a/1001-c.gnt" << quint64(9) << 3;
+	QTest::newRow("file 1.0train-gb1") << int(QxDecodeSettings::ShardByFile) << "1.0train-gb1.gnt.gz" << quint64(0) << 3;
+	QTest::newRow("file PotSimple01") << int(QxDecodeSettings::ShardByFile) << "PotSimple01.pot" << quint64(0) << 2;
+	QTest::newRow("file C001-f-f") << int(QxDecodeSettings::ShardByFile) << "C001-f-f.dgr" << quint64(0) << 0;
+	QTest::newRow("sample 0") << int(QxDecodeSettings::ShardBySample) << "1001-c.gnt" << quint64(0) << 3;
+	QTest::newRow("sample 1") << int(QxDecodeSettings::ShardBySample) << "1001-c.gnt" << quint64(1) << 2;
+	QTest::newRow("sample 2") << int(QxDecodeSettings::ShardBySample) << "1001-c.gnt" << quint64(2) << 0;
+	QTest::newRow("sample 5") << int(QxDecodeSettings::ShardBySample) << "1001-c.gnt" << quint64(5) << 1;
+}
+
+void tst_QxDecodeSettings::inShardStable()
+{
+	QFETCH(int, shardMode);
+	QFETCH(QString, strFileName);
+	QFETCH(quint64, uIndex);
+	QFETCH(int, iShard);
+
+	QxDecodeSettings settings;
+	settings.shardMode = QxDecodeSettings::ShardMode(shardMode);
+	settings.iShardCount = 4;
+	for (settings.iShardIndex = 0; settings.iShardIndex != settings.iShardCount; ++settings.iShardIndex)
+	{
+		QCOMPARE(settings.inShard(strFileName, uIndex), settings.iShardIndex == iShard);
+	}
+}
+
+void tst_QxDecodeSettings::inShardPartition()
+{
+	// every sample is in exactly one shard
+	QxDecodeSettings settings;
+	settings.shardMode = QxDecodeSettings::ShardBySample;
+	settings.iShardCount = 3;
+	for (quint64 uIndex = 0; uIndex != 300; ++uIndex)
+	{
+		int iShardCount = 0;
+		for (settings.iShardIndex = 0; settings.iShardIndex != settings.iShardCount; ++settings.iShardIndex)
+		{
+			iShardCount += settings.inShard("1001-c.gnt", uIndex);
+		}
+		QCOMPARE(iShardCount, 1);
+	}
+
+	// a single shard holds everything
+	settings.iShardCount = 1;
+	settings.iShardIndex = 0;
+	QVERIFY(settings.inShard("1001-c.gnt", 12));
+}
+
+void tst_QxDecodeSettings::variantSeed()
+{
+	QCOMPARE(QxAugmenter::variantSeed(0, "/a/1001-c.gnt", 7, 1), Q_UINT64_C(0x3092FD0389523AC3));
+	QCOMPARE(QxAugmenter::variantSeed(123, "b/1001-c.gnt.gz", 7, 2), Q_UINT64_C(0xEE82FAB271BA040D));
+	QCOMPARE(QxAugmenter::variantSeed(5, "/a/1001-c.gnt", 7, 1), QxAugmenter::variantSeed(5, "1001-c.gnt.zst", 7, 1));
+	QVERIFY(QxAugmenter::variantSeed(5, "1001-c.gnt", 7, 1) != QxAugmenter::variantSeed(5, "1001-c.gnt", 7, 2));
+	QVERIFY(QxAugmenter::variantSeed(5, "1001-c.gnt", 7, 1) != QxAugmenter::variantSeed(5, "1001-c.gnt", 8, 1));
+	QVERIFY(QxAugmenter::variantSeed(5, "1001-c.gnt", 7, 1) != QxAugmenter::variantSeed(6, "1001-c.gnt", 7, 1));
+}
+
+QTEST_GUILESS_MAIN(tst_QxDecodeSettings)
+
+#include "tst_qxdecodesettings.moc"
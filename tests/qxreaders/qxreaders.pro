@@ -0,0 +1,17 @@
+include(../tests.pri)
+
+TARGET = tst_qxreaders
+
+SOURCES += tst_qxreaders.cpp \
+    $$SOURCE_PATH/QxDecompressDevice.cpp \
+    $$SOURCE_PATH/QxDgrReader.cpp \
+    $$SOURCE_PATH/QxGntReader.cpp \
+    $$SOURCE_PATH/QxPotReader.cpp \
+    $$SOURCE_PATH/QxSampleStore.cpp
+
+HEADERS += \
+    $$SOURCE_PATH/QxDecompressDevice.h \
+    $$SOURCE_PATH/QxDgrReader.h \
+    $$SOURCE_PATH/QxGntReader.h \
+    $$SOURCE_PATH/QxPotReader.h \
+    $$SOURCE_PATH/QxSampleStore.h
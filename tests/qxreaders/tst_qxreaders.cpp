@@ -0,0 +1,404 @@
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "QxDgrReader.h"
+#include "QxGntReader.h"
+#include "QxPotReader.h"
+#include "QxTestData.h"
+
+/*
+	Parsing of well-formed, truncated and corrupt .gnt, .pot and .dgr files, plain and gzip compressed.
+*/
+class tst_QxReaders : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+
+	void gntReadsAllSamples();
+	void gntTruncated_data();
+	void gntTruncated();
+	void gntCorruptLength();
+	void gntOversizedHeader_data();
+	void gntOversizedHeader();
+	void gntGzip_data();
+	void gntGzip();
+	void gntGzipTruncated();
+
+	void potReadsStrokes();
+	void potTruncated();
+	void potCorrupt_data();
+	void potCorrupt();
+
+	void dgrReadsPages();
+	void dgrTruncatedPage_data();
+	void dgrTruncatedPage();
+	void dgrCorruptHeader_data();
+	void dgrCorruptHeader();
+
+private:
+	QString fileName(const QString& strName) const;
+
+private:
+	QTemporaryDir m_TempDir;
+	QList<QxGntRecord> m_Records;
+};
+
+void tst_QxReaders::initTestCase()
+{
+	QVERIFY(m_TempDir.isValid());
+	m_Records << qxMakeRecord(0xB0A1, 7, 5, 0) << qxMakeRecord(0xB0A2, 300, 2, 1) << qxMakeRecord(0xB0A1, 1, 1, 2)
+		<< qxMakeRecord(0xD7F9, 40, 33, 3);
+}
+
+QString tst_QxReaders::fileName(const QString& strName) const
+{
+	return m_TempDir.path() + "/" + strName;
+}
+
+void tst_QxReaders::gntReadsAllSamples()
+{
+	const QString strFileName = fileName("all.gnt");
+	QVERIFY(qxWriteFile(strFileName, qxGntData(m_Records)));
+
+	QxGntReader reader;
+	QVERIFY(reader.open(strFileName));
+	quint64 uOffset = 0;
+	QxGntRecord record;
+	for (int i = 0; i != m_Records.size(); ++i)
+	{
+		QVERIFY(reader.readRecord(record));
+		QCOMPARE(record.uTagCode, m_Records.at(i).uTagCode);
+		QCOMPARE(record.uWidth, m_Records.at(i).uWidth);
+		QCOMPARE(record.uHeight, m_Records.at(i).uHeight);
+		QCOMPARE(record.bitmap, m_Records.at(i).bitmap);
+		QCOMPARE(record.uIndex, quint64(i));
+		QCOMPARE(record.uOffset, uOffset);
+		uOffset += QxGntReader::RecordHeaderSize + record.bitmap.size();
+	}
+	QVERIFY(!reader.readRecord(record));
+	QVERIFY(!reader.hasError());
+}
+
+void tst_QxReaders::gntTruncated_data()
+{
+	QTest::addColumn<int>("iCut");
+	QTest::addColumn<QString>("strMessage");
+
+	const int iFirstSize = QxGntReader::RecordHeaderSize + m_Records.at(0).bitmap.size();
+	QTest::newRow("header") << iFirstSize + 3 << "Unexpected end of file in the header of a sample.";
+	QTest::newRow("bitmap") << iFirstSize + int(QxGntReader::RecordHeaderSize) + 100
+		<< QString("Sample needs %1 bytes but only 110 bytes are left, the file may be truncated.")
+			.arg(QxGntReader::RecordHeaderSize + m_Records.at(1).bitmap.size());
+}
+
+void tst_QxReaders::gntTruncated()
+{
+	QFETCH(int, iCut);
+	QFETCH(QString, strMessage);
+	const QString strFileName = fileName("truncated.gnt");
+	QVERIFY(qxWriteFile(strFileName, qxGntData(m_Records).left(iCut)));
+
+	// the sample before the cut is read, then the error tells where the cut sample starts
+	QxGntReader reader;
+	QVERIFY(reader.open(strFileName));
+	QxGntRecord record;
+	QVERIFY(reader.readRecord(record));
+	QVERIFY(!reader.readRecord(record));
+	QVERIFY(reader.hasError());
+	QCOMPARE(reader.errorMessage(), strMessage);
+	QCOMPARE(reader.sampleIndex(), quint64(1));
+	QCOMPARE(reader.offset(), quint64(QxGntReader::RecordHeaderSize + m_Records.at(0).bitmap.size()));
+	QVERIFY(!reader.readRecord(record));
+}
+
+void tst_QxReaders::gntCorruptLength()
+{
+	QByteArray data = qxGntData(m_Records);
+	// data length of the first sample one byte too long
+	data[0] = char(data.at(0) + 1);
+	const QString strFileName = fileName("corrupt.gnt");
+	QVERIFY(qxWriteFile(strFileName, data));
+
+	QxGntReader reader;
+	QVERIFY(reader.open(strFileName));
+	QxGntRecord record;
+	QVERIFY(!reader.readRecord(record));
+	QVERIFY(reader.hasError());
+	QVERIFY(reader.errorMessage().startsWith("Sample length 46 doesn't match its size 7 x 5"));
+	QCOMPARE(reader.sampleIndex(), quint64(0));
+}
+
+void tst_QxReaders::gntOversizedHeader_data()
+{
+	QTest::addColumn<QByteArray>("header");
+	QTest::addColumn<QString>("strMessage");
+
+	// headers which are consistent but announce more than the file holds, or than a QByteArray can hold
+	QTest::newRow("larger than the file") << QByteArray("\x4A\x42\x0F\x00\xA1\xB0\xE8\x03\xE8\x03", 10)
+		<< "Sample needs 1000010 bytes but only 10 bytes are left, the file may be truncated.";
+	QTest::newRow("larger than 2 GB") << QByteArray("\x0B\x00\xFE\xFF\xA1\xB0\xFF\xFF\xFF\xFF", 10)
+		<< "Bitmap of 65535 x 65535 pixels is too large to be read.";
+}
+
+void tst_QxReaders::gntOversizedHeader()
+{
+	QFETCH(QByteArray, header);
+	QFETCH(QString, strMessage);
+	const QString strFileName = fileName("oversized.gnt");
+	QVERIFY(qxWriteFile(strFileName, header));
+
+	QxGntReader reader;
+	QVERIFY(reader.open(strFileName));
+	QxGntRecord record;
+	QVERIFY(!reader.readRecord(record));
+	QVERIFY(reader.hasError());
+	QCOMPARE(reader.errorMessage(), strMessage);
+}
+
+void tst_QxReaders::gntGzip_data()
+{
+	QTest::addColumn<QByteArray>("data");
+
+	const QByteArray gnt = qxGntData(m_Records);
+	QTest::newRow("one member") << qxGzipData(gnt);
+	QTest::newRow("two members") << qxGzipData(gnt.left(100)) + qxGzipData(gnt.mid(100));
+	QTest::newRow("zero padding") << qxGzipData(gnt) + QByteArray(512, '\0');
+}
+
+void tst_QxReaders::gntGzip()
+{
+	QFETCH(QByteArray, data);
+	const QString strFileName = fileName("compressed.gnt.gz");
+	QVERIFY(qxWriteFile(strFileName, data));
+
+	QxGntReader reader;
+	QVERIFY(reader.open(strFileName));
+	QxGntRecord record;
+	for (int i = 0; i != m_Records.size(); ++i)
+	{
+		QVERIFY2(reader.readRecord(record), qPrintable(reader.errorString()));
+		QCOMPARE(record.bitmap, m_Records.at(i).bitmap);
+	}
+	QVERIFY(!reader.readRecord(record));
+	QVERIFY2(!reader.hasError(), qPrintable(reader.errorString()));
+}
+
+void tst_QxReaders::gntGzipTruncated()
+{
+	const QByteArray data = qxGzipData(qxGntData(m_Records));
+	const QString strFileName = fileName("truncated.gnt.gz");
+	QVERIFY(qxWriteFile(strFileName, data.left(data.size() - 20)));
+
+	QxGntReader reader;
+	QVERIFY(reader.open(strFileName));
+	QxGntRecord record;
+	while (reader.readRecord(record))
+	{
+	}
+	QVERIFY(reader.hasError());
+}
+
+void tst_QxReaders::potReadsStrokes()
+{
+	QList<QVector<QPoint> > strokes;
+	strokes << (QVector<QPoint>() << QPoint(10, 20) << QPoint(11, 22) << QPoint(-5, 300));
+	strokes << (QVector<QPoint>() << QPoint(40, 41));
+	const QString strFileName = fileName("strokes.pot");
+	QVERIFY(qxWriteFile(strFileName, qxPotData(0xB0A1, strokes) + qxPotData(0xB0A2, strokes.mid(1))));
+
+	QxPotReader reader;
+	QVERIFY(reader.open(strFileName));
+	QxPotSample sample;
+	QVERIFY(reader.readSample(sample));
+	QCOMPARE(sample.uTagCode, quint32(0xB0A1));
+	QCOMPARE(sample.points, strokes.at(0) + strokes.at(1));
+	QCOMPARE(sample.strokeEnds, QVector<int>() << 3 << 4);
+	QCOMPARE(sample.uIndex, quint64(0));
+	QVERIFY(reader.readSample(sample));
+	QCOMPARE(sample.uTagCode, quint32(0xB0A2));
+	QCOMPARE(sample.points, strokes.at(1));
+	QCOMPARE(sample.uIndex, quint64(1));
+	QCOMPARE(sample.uOffset, quint64(qxPotData(0xB0A1, strokes).size()));
+	QVERIFY(!reader.readSample(sample));
+	QVERIFY(!reader.hasError());
+}
+
+void tst_QxReaders::potTruncated()
+{
+	QList<QVector<QPoint> > strokes;
+	strokes << (QVector<QPoint>() << QPoint(1, 2) << QPoint(3, 4));
+	const QByteArray sample = qxPotData(0xB0A1, strokes);
+	const QString strFileName = fileName("truncated.pot");
+	QVERIFY(qxWriteFile(strFileName, sample + sample.left(sample.size() - 1)));
+
+	QxPotReader reader;
+	QVERIFY(reader.open(strFileName));
+	QxPotSample potSample;
+	QVERIFY(reader.readSample(potSample));
+	QVERIFY(!reader.readSample(potSample));
+	QVERIFY(reader.hasError());
+	QCOMPARE(reader.errorMessage(), QString("Unexpected end of file in the strokes of a sample."));
+	QCOMPARE(reader.sampleIndex(), quint64(1));
+	QCOMPARE(reader.offset(), quint64(sample.size()));
+}
+
+void tst_QxReaders::potCorrupt_data()
+{
+	QTest::addColumn<QByteArray>("data");
+	QTest::addColumn<QString>("strMessage");
+
+	QList<QVector<QPoint> > strokes;
+	strokes << (QVector<QPoint>() << QPoint(1, 2) << QPoint(3, 4));
+	const QByteArray sample = qxPotData(0xB0A1, strokes);
+
+	QByteArray tooSmall = sample;
+	tooSmall[0] = 11;
+	tooSmall[1] = 0;
+	QTest::newRow("size") << tooSmall << "Sample size 11 is smaller than the smallest sample (12 bytes).";
+
+	QByteArray strokeCount = sample;
+	strokeCount[6] = 2;
+	QTest::newRow("stroke count") << strokeCount << "Sample has 1 strokes instead of 2.";
+
+	// the (-1, -1) mark replaced by another point
+	QByteArray noEnd = sample;
+	noEnd[noEnd.size() - 4] = 5;
+	noEnd[noEnd.size() - 3] = 0;
+	QTest::newRow("no end") << noEnd << "Sample has no end of character mark (-1, -1).";
+
+	// a sample 4 bytes longer than its strokes
+	QByteArray early = sample + QByteArray(4, '\0');
+	early[0] = char(sample.size() + 4);
+	QTest::newRow("early end") << early << QString("End of the character at byte %1 of a sample of %2 bytes.")
+		.arg(sample.size() - 4).arg(sample.size() + 4);
+}
+
+void tst_QxReaders::potCorrupt()
+{
+	QFETCH(QByteArray, data);
+	QFETCH(QString, strMessage);
+	const QString strFileName = fileName("corrupt.pot");
+	QVERIFY(qxWriteFile(strFileName, data));
+
+	QxPotReader reader;
+	QVERIFY(reader.open(strFileName));
+	QxPotSample sample;
+	QVERIFY(!reader.readSample(sample));
+	QVERIFY(reader.hasError());
+	QCOMPARE(reader.errorMessage(), strMessage);
+	QCOMPARE(reader.sampleIndex(), quint64(0));
+}
+
+void tst_QxReaders::dgrReadsPages()
+{
+	QList<QList<QxGntRecord> > firstPage;
+	firstPage << m_Records.mid(0, 2) << m_Records.mid(2, 1);
+	QList<QList<QxGntRecord> > secondPage;
+	secondPage << QList<QxGntRecord>() << m_Records.mid(3);
+	const QString strFileName = fileName("pages.dgr");
+	QVERIFY(qxWriteFile(strFileName, qxDgrHeader() + qxDgrPage(firstPage) + qxDgrPage(secondPage)));
+
+	QxDgrReader reader;
+	QVERIFY2(reader.open(strFileName), qPrintable(reader.errorString()));
+	QVERIFY(!reader.hasError());
+	QCOMPARE(reader.pageCount(), 2);
+	QCOMPARE(reader.characterCount(), quint64(m_Records.size()));
+	QCOMPARE(reader.page(0).uCharacterCount, quint32(3));
+	QCOMPARE(reader.page(0).uLineCount, quint32(2));
+	QCOMPARE(reader.page(1).uFirstIndex, quint64(3));
+	QCOMPARE(reader.page(1).uOffset, quint64(qxDgrHeader().size() + qxDgrPage(firstPage).size()));
+
+	QVector<QxGntRecord> records(int(reader.characterCount()));
+	reader.readPage(0, records.data());
+	reader.readPage(1, records.data() + reader.page(1).uFirstIndex);
+	for (int i = 0; i != m_Records.size(); ++i)
+	{
+		QCOMPARE(records.at(i).uTagCode, m_Records.at(i).uTagCode);
+		QCOMPARE(records.at(i).uWidth, m_Records.at(i).uWidth);
+		QCOMPARE(records.at(i).uHeight, m_Records.at(i).uHeight);
+		QCOMPARE(records.at(i).bitmap, m_Records.at(i).bitmap);
+		QCOMPARE(records.at(i).uIndex, quint64(i));
+	}
+}
+
+void tst_QxReaders::dgrTruncatedPage_data()
+{
+	QTest::addColumn<int>("iCut");
+	QTest::addColumn<QString>("strMessage");
+
+	QList<QList<QxGntRecord> > page;
+	page << m_Records.mid(0, 2);
+	const int iSecondPage = qxDgrHeader().size() + qxDgrPage(page).size();
+	QTest::newRow("page header") << iSecondPage + 5 << "Unexpected end of file in the header of a page.";
+	QTest::newRow("line header") << iSecondPage + 12 + 2 << "Unexpected end of file in the header of line 0.";
+	QTest::newRow("labels") << iSecondPage + 12 + 4 + 3 << "Unexpected end of file in the labels of line 0 (2 characters).";
+	QTest::newRow("character header") << iSecondPage + 12 + 4 + 4 + 6
+		<< "Unexpected end of file in the header of character 0 of line 0.";
+	QTest::newRow("bitmap") << iSecondPage + 12 + 4 + 4 + 8 + 10
+		<< "Character 0 of line 0 needs 35 bytes but only 10 bytes are left, the file may be truncated.";
+}
+
+void tst_QxReaders::dgrTruncatedPage()
+{
+	QFETCH(int, iCut);
+	QFETCH(QString, strMessage);
+	QList<QList<QxGntRecord> > page;
+	page << m_Records.mid(0, 2);
+	const QByteArray data = qxDgrHeader() + qxDgrPage(page) + qxDgrPage(page);
+	const QString strFileName = fileName("truncated.dgr");
+	QVERIFY(qxWriteFile(strFileName, data.left(iCut)));
+
+	// the pages before the corrupt one can still be read
+	QxDgrReader reader;
+	QVERIFY(reader.open(strFileName));
+	QVERIFY(reader.hasError());
+	QCOMPARE(reader.errorMessage(), strMessage);
+	QCOMPARE(reader.pageCount(), 1);
+	QCOMPARE(reader.characterCount(), quint64(2));
+	QCOMPARE(reader.sampleIndex(), quint64(2));
+	QCOMPARE(reader.offset(), quint64(qxDgrHeader().size() + qxDgrPage(page).size()));
+}
+
+void tst_QxReaders::dgrCorruptHeader_data()
+{
+	QTest::addColumn<QByteArray>("data");
+	QTest::addColumn<QString>("strMessage");
+
+	const QByteArray header = qxDgrHeader();
+	QTest::newRow("small") << header.left(20) << "File of 20 bytes is smaller than a .dgr header.";
+
+	QByteArray format = header;
+	format[4] = 'X';
+	QTest::newRow("format") << format << "Not a .dgr file (no DGR format code).";
+
+	QByteArray headerSize = header;
+	headerSize[0] = 37;
+	QTest::newRow("header size") << headerSize << "Header size 37 is out of the file (36 bytes).";
+
+	QByteArray codeLength = header;
+	codeLength[32] = 0;
+	QTest::newRow("code length") << codeLength << "Labels have a code length of 0 bytes.";
+
+	QByteArray bitsPerPixel = header;
+	bitsPerPixel[34] = 1;
+	QTest::newRow("bits per pixel") << bitsPerPixel << "Only 8-bit .dgr files can be decoded (1 bits per pixel).";
+}
+
+void tst_QxReaders::dgrCorruptHeader()
+{
+	QFETCH(QByteArray, data);
+	QFETCH(QString, strMessage);
+	const QString strFileName = fileName("corrupt.dgr");
+	QVERIFY(qxWriteFile(strFileName, data));
+
+	QxDgrReader reader;
+	QVERIFY(!reader.open(strFileName));
+	QCOMPARE(reader.errorString(), strMessage);
+	QCOMPARE(reader.pageCount(), 0);
+}
+
+QTEST_GUILESS_MAIN(tst_QxReaders)
+
+#include "tst_qxreaders.moc"
@@ -0,0 +1,28 @@
+include(../tests.pri)
+
+QT += network concurrent widgets
+
+TARGET = tst_qxsampleserver
+
+SOURCES += tst_qxsampleserver.cpp \
+    $$SOURCE_PATH/QxAugmenter.cpp \
+    $$SOURCE_PATH/QxDecodeSettings.cpp \
+    $$SOURCE_PATH/QxDecompressDevice.cpp \
+    $$SOURCE_PATH/QxGntDataset.cpp \
+    $$SOURCE_PATH/QxGntReader.cpp \
+    $$SOURCE_PATH/QxSampleProcessor.cpp \
+    $$SOURCE_PATH/QxSampleServer.cpp \
+    $$SOURCE_PATH/QxSampleStore.cpp
+
+HEADERS += \
+    $$SOURCE_PATH/QxAugmenter.h \
+    $$SOURCE_PATH/QxDecodeSettings.h \
+    $$SOURCE_PATH/QxDecompressDevice.h \
+    $$SOURCE_PATH/QxGntDataset.h \
+    $$SOURCE_PATH/QxGntReader.h \
+    $$SOURCE_PATH/QxSampleProcessor.h \
+    $$SOURCE_PATH/QxSampleServer.h \
+    $$SOURCE_PATH/QxSampleStore.h
+
+unix:!macx: LIBS += -lopencv_core
+unix:!macx: LIBS += -lopencv_imgproc
@@ -0,0 +1,288 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <QtTest>
+
+#include "QxGntDataset.h"
+#include "QxSampleServer.h"
+#include "QxTestData.h"
+
+// Longest wait for the server, in milliseconds.
+static const int g_iTimeout = 10000;
+
+/*
+	Wire format of QxSampleServer, seen from a client: the hello, the batches of an epoch, and the errors.
+	The server and the client share the thread of the test, so waiting for data runs the event loop.
+*/
+class tst_QxSampleServer : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void init();
+	void cleanup();
+
+	void sendsHello();
+	void servesEpoch();
+	void shufflesWithSeed_data();
+	void shufflesWithSeed();
+	void dropsLastBatch();
+	void queuesRequests();
+	void rejectsInvalidRequest_data();
+	void rejectsInvalidRequest();
+
+private:
+	struct Batch
+	{
+		quint32 uSampleCount;
+		quint32 uImageSide;
+		quint32 uBatchIndex;
+		QList<quint64> indices;
+		QList<qint32> labels;
+		QByteArray pixels;
+	};
+
+	static QByteArray request(quint32 uBatchSize, quint32 uImageSide, quint32 uFlags, quint64 uSeed);
+	// Wait for iSize bytes from the server and take them. Fewer bytes are returned when they don't come.
+	QByteArray receive(int iSize);
+	// Read one batch. Return false when it doesn't come or is not a batch.
+	bool receiveBatch(Batch& batch);
+	// Read the batches of an epoch up to its empty batch, checking their headers and contents as they come.
+	void receiveEpoch(quint32 uBatchSize, quint32 uImageSide, QList<quint64>& indices, QList<quint32>& batchSizes);
+
+private:
+	QTemporaryDir m_TempDir;
+	QList<QxGntRecord> m_Records;
+	QxGntDataset m_Dataset;
+	QScopedPointer<QxSampleServer> m_pServer;
+	QScopedPointer<QLocalSocket> m_pSocket;
+};
+
+void tst_QxSampleServer::initTestCase()
+{
+	QVERIFY(m_TempDir.isValid());
+	m_Records << qxMakeRecord(0xB0A1, 12, 20, 0) << qxMakeRecord(0xB0A2, 30, 9, 1) << qxMakeRecord(0xB0A1, 5, 5, 2)
+		<< qxMakeRecord(0xB0A3, 64, 64, 3) << qxMakeRecord(0xB0A2, 1, 40, 4);
+	const QString strFileName = m_TempDir.path() + "/samples.gnt";
+	QVERIFY(qxWriteFile(strFileName, qxGntData(m_Records)));
+	QVERIFY2(m_Dataset.open(QStringList() << strFileName), qPrintable(m_Dataset.errorString()));
+}
+
+void tst_QxSampleServer::init()
+{
+	m_pServer.reset(new QxSampleServer(&m_Dataset));
+	QVERIFY2(m_pServer->listen(QString("tst_qxsampleserver-%1").arg(QCoreApplication::applicationPid())),
+		qPrintable(m_pServer->errorString()));
+	m_pSocket.reset(new QLocalSocket);
+	m_pSocket->connectToServer(m_pServer->fullServerName());
+	QTRY_COMPARE_WITH_TIMEOUT(m_pSocket->state(), QLocalSocket::ConnectedState, g_iTimeout);
+}
+
+void tst_QxSampleServer::cleanup()
+{
+	m_pSocket.reset();
+	m_pServer.reset();
+}
+
+QByteArray tst_QxSampleServer::request(quint32 uBatchSize, quint32 uImageSide, quint32 uFlags, quint64 uSeed)
+{
+	QByteArray data("GNTQ", 4);
+	qxAppendUInt32(data, uBatchSize);
+	qxAppendUInt32(data, uImageSide);
+	qxAppendUInt32(data, uFlags);
+	qxAppendUInt32(data, quint32(uSeed));
+	qxAppendUInt32(data, quint32(uSeed >> 32));
+	return data;
+}
+
+QByteArray tst_QxSampleServer::receive(int iSize)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while (m_pSocket->bytesAvailable() < iSize && timer.elapsed() < g_iTimeout
+		&& m_pSocket->state() == QLocalSocket::ConnectedState)
+	{
+		QTest::qWait(5);
+	}
+	return m_pSocket->read(iSize);
+}
+
+bool tst_QxSampleServer::receiveBatch(Batch& batch)
+{
+	const QByteArray header = receive(16);
+	if (header.size() != 16 || !header.startsWith("GNTB"))
+	{
+		return false;
+	}
+	const uchar* pHeader = reinterpret_cast<const uchar*>(header.constData());
+	batch.uSampleCount = qFromLittleEndian<quint32>(pHeader + 4);
+	batch.uImageSide = qFromLittleEndian<quint32>(pHeader + 8);
+	batch.uBatchIndex = qFromLittleEndian<quint32>(pHeader + 12);
+
+	const int iSampleCount = int(batch.uSampleCount);
+	const int iImageSize = int(batch.uImageSide * batch.uImageSide);
+	const QByteArray data = receive(iSampleCount * (8 + 4 + iImageSize));
+	if (data.size() != iSampleCount * (8 + 4 + iImageSize))
+	{
+		return false;
+	}
+	const uchar* pData = reinterpret_cast<const uchar*>(data.constData());
+	batch.indices.clear();
+	batch.labels.clear();
+	for (int i = 0; i != iSampleCount; ++i)
+	{
+		batch.indices << qFromLittleEndian<quint64>(pData + 8 * i);
+		batch.labels << qFromLittleEndian<qint32>(pData + 8 * iSampleCount + 4 * i);
+	}
+	batch.pixels = data.mid(12 * iSampleCount);
+	return true;
+}
+
+void tst_QxSampleServer::receiveEpoch(quint32 uBatchSize, quint32 uImageSide, QList<quint64>& indices, QList<quint32>& batchSizes)
+{
+	indices.clear();
+	batchSizes.clear();
+	for (quint32 uBatchIndex = 0; ; ++uBatchIndex)
+	{
+		Batch batch;
+		QVERIFY(receiveBatch(batch));
+		QCOMPARE(batch.uBatchIndex, uBatchIndex);
+		QCOMPARE(batch.uImageSide, uImageSide);
+		QVERIFY(batch.uSampleCount <= uBatchSize);
+		if (batch.uSampleCount == 0)
+		{
+			return;
+		}
+		batchSizes << batch.uSampleCount;
+
+		// the pixels are those rendered by the dataset, and the labels follow the order the tag codes are met
+		QByteArray pixels(int(uImageSide * uImageSide), '\0');
+		for (int i = 0; i != batch.indices.size(); ++i)
+		{
+			const quint64 uIndex = batch.indices.at(i);
+			QVERIFY(uIndex < quint64(m_Records.size()));
+			QCOMPARE(quint32(batch.labels.at(i)), m_Dataset.label(uIndex));
+			m_Dataset.render(uIndex, int(uImageSide), reinterpret_cast<uchar*>(pixels.data()));
+			QCOMPARE(batch.pixels.mid(i * pixels.size(), pixels.size()), pixels);
+			indices << uIndex;
+		}
+	}
+}
+
+void tst_QxSampleServer::sendsHello()
+{
+	const QByteArray hello = receive(4 + 4 + 8 + 4 + 3 * 4);
+	QCOMPARE(hello.size(), 32);
+	const uchar* pHello = reinterpret_cast<const uchar*>(hello.constData());
+	QVERIFY(hello.startsWith("GNTS"));
+	QCOMPARE(qFromLittleEndian<quint32>(pHello + 4), quint32(1));
+	QCOMPARE(qFromLittleEndian<quint64>(pHello + 8), quint64(m_Records.size()));
+	QCOMPARE(qFromLittleEndian<quint32>(pHello + 16), quint32(3));
+	QCOMPARE(qFromLittleEndian<quint32>(pHello + 20), quint32(0xB0A1));
+	QCOMPARE(qFromLittleEndian<quint32>(pHello + 24), quint32(0xB0A2));
+	QCOMPARE(qFromLittleEndian<quint32>(pHello + 28), quint32(0xB0A3));
+	QCOMPARE(m_pSocket->bytesAvailable(), qint64(0));
+}
+
+void tst_QxSampleServer::servesEpoch()
+{
+	QCOMPARE(receive(32).size(), 32);
+	m_pSocket->write(request(2, 8, 0, 0));
+
+	QList<quint64> indices;
+	QList<quint32> batchSizes;
+	receiveEpoch(2, 8, indices, batchSizes);
+	QCOMPARE(indices, QList<quint64>() << 0 << 1 << 2 << 3 << 4);
+	QCOMPARE(batchSizes, QList<quint32>() << 2 << 2 << 1);
+}
+
+void tst_QxSampleServer::shufflesWithSeed_data()
+{
+	QTest::addColumn<quint64>("uSeed");
+	QTest::addColumn<QList<quint64> >("indices");
+
+	QTest::newRow("seed 42") << quint64(42) << (QList<quint64>() << 1 << 2 << 3 << 0 << 4);
+	QTest::newRow("seed 7") << quint64(7) << (QList<quint64>() << 2 << 1 << 4 << 0 << 3);
+}
+
+void tst_QxSampleServer::shufflesWithSeed()
+{
+	QFETCH(quint64, uSeed);
+	QFETCH(QList<quint64>, indices);
+	QCOMPARE(receive(32).size(), 32);
+
+	// the same seed gives the same order every epoch
+	for (int iEpoch = 0; iEpoch != 2; ++iEpoch)
+	{
+		m_pSocket->write(request(3, 4, 1, uSeed));
+		QList<quint64> epochIndices;
+		QList<quint32> batchSizes;
+		receiveEpoch(3, 4, epochIndices, batchSizes);
+		QCOMPARE(epochIndices, indices);
+	}
+}
+
+void tst_QxSampleServer::dropsLastBatch()
+{
+	QCOMPARE(receive(32).size(), 32);
+	m_pSocket->write(request(2, 8, 2, 0));
+
+	QList<quint64> indices;
+	QList<quint32> batchSizes;
+	receiveEpoch(2, 8, indices, batchSizes);
+	QCOMPARE(indices, QList<quint64>() << 0 << 1 << 2 << 3);
+	QCOMPARE(batchSizes, QList<quint32>() << 2 << 2);
+}
+
+void tst_QxSampleServer::queuesRequests()
+{
+	QCOMPARE(receive(32).size(), 32);
+	// both requests at once, the second one is answered once the first epoch is over
+	m_pSocket->write(request(5, 16, 0, 0) + request(3, 2, 0, 0));
+
+	QList<quint64> indices;
+	QList<quint32> batchSizes;
+	receiveEpoch(5, 16, indices, batchSizes);
+	QCOMPARE(batchSizes, QList<quint32>() << 5);
+	receiveEpoch(3, 2, indices, batchSizes);
+	QCOMPARE(batchSizes, QList<quint32>() << 3 << 2);
+	QCOMPARE(indices, QList<quint64>() << 0 << 1 << 2 << 3 << 4);
+}
+
+void tst_QxSampleServer::rejectsInvalidRequest_data()
+{
+	QTest::addColumn<QByteArray>("data");
+	QTest::addColumn<QString>("strMessage");
+
+	QByteArray magic = request(2, 8, 0, 0);
+	magic[3] = 'X';
+	QTest::newRow("magic") << magic << "Invalid request.";
+	QTest::newRow("no sample") << request(0, 8, 0, 0) << "Invalid batch size 0 or image side 8.";
+	QTest::newRow("batch size") << request(65537, 8, 0, 0) << "Invalid batch size 65537 or image side 8.";
+	QTest::newRow("no side") << request(2, 0, 0, 0) << "Invalid batch size 2 or image side 0.";
+	QTest::newRow("side") << request(2, 1025, 0, 0) << "Invalid batch size 2 or image side 1025.";
+	QTest::newRow("pixels") << request(65536, 1024, 0, 0) << "Invalid batch size 65536 or image side 1024.";
+}
+
+void tst_QxSampleServer::rejectsInvalidRequest()
+{
+	QFETCH(QByteArray, data);
+	QFETCH(QString, strMessage);
+	QCOMPARE(receive(32).size(), 32);
+	m_pSocket->write(data);
+
+	const QByteArray header = receive(8);
+	QCOMPARE(header.size(), 8);
+	QVERIFY(header.startsWith("GNTE"));
+	const int iLength = int(qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(header.constData()) + 4));
+	QCOMPARE(QString::fromUtf8(receive(iLength)), strMessage);
+	QTRY_COMPARE_WITH_TIMEOUT(m_pSocket->state(), QLocalSocket::UnconnectedState, g_iTimeout);
+}
+
+QTEST_GUILESS_MAIN(tst_QxSampleServer)
+
+#include "tst_qxsampleserver.moc"
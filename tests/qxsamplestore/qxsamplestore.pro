@@ -0,0 +1,13 @@
+include(../tests.pri)
+
+TARGET = tst_qxsamplestore
+
+SOURCES += tst_qxsamplestore.cpp \
+    $$SOURCE_PATH/QxDecompressDevice.cpp \
+    $$SOURCE_PATH/QxGntReader.cpp \
+    $$SOURCE_PATH/QxSampleStore.cpp
+
+HEADERS += \
+    $$SOURCE_PATH/QxDecompressDevice.h \
+    $$SOURCE_PATH/QxGntReader.h \
+    $$SOURCE_PATH/QxSampleStore.h
@@ -0,0 +1,279 @@
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "QxGntReader.h"
+#include "QxSampleStore.h"
+#include "QxTestData.h"
+
+Q_DECLARE_METATYPE(QxGntRecord)
+
+/*
+	Row runs of the stored samples, and the files read through the store: in memory, spilled, or read again once changed.
+*/
+class tst_QxSampleStore : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+
+	void roundTrip_data();
+	void roundTrip();
+	void readTruncated();
+	void readCorruptHeader();
+
+	void storesFileRead();
+	void spillsBeyondBudget();
+	void splitsIntoChunks();
+	void readsChangedFileAgain();
+	void skipsFileWithError();
+
+private:
+	// Read all the samples of a file through a reader. Return false if the reader stopped on an error.
+	static bool readAll(const QString& strFileName, QxSampleStore* pStore, QList<QxGntRecord>& records);
+	static void compareRecords(const QList<QxGntRecord>& records, const QList<QxGntRecord>& expectedRecords);
+	QString fileName(const QString& strName) const;
+
+private:
+	QTemporaryDir m_TempDir;
+	QList<QxGntRecord> m_Records;
+};
+
+void tst_QxSampleStore::initTestCase()
+{
+	QVERIFY(m_TempDir.isValid());
+	for (int i = 0; i != 50; ++i)
+	{
+		m_Records << qxMakeRecord(0xB0A1 + i % 7, 20 + i, 30 + i % 11, i);
+	}
+}
+
+QString tst_QxSampleStore::fileName(const QString& strName) const
+{
+	return m_TempDir.path() + "/" + strName;
+}
+
+bool tst_QxSampleStore::readAll(const QString& strFileName, QxSampleStore* pStore, QList<QxGntRecord>& records)
+{
+	records.clear();
+	QxGntReader reader;
+	if (!reader.open(strFileName, pStore))
+	{
+		return false;
+	}
+	QxGntRecord record;
+	while (reader.readRecord(record))
+	{
+		records << record;
+	}
+	return !reader.hasError();
+}
+
+void tst_QxSampleStore::compareRecords(const QList<QxGntRecord>& records, const QList<QxGntRecord>& expectedRecords)
+{
+	QCOMPARE(records.size(), expectedRecords.size());
+	quint64 uOffset = 0;
+	for (int i = 0; i != records.size(); ++i)
+	{
+		QCOMPARE(records.at(i).uTagCode, expectedRecords.at(i).uTagCode);
+		QCOMPARE(records.at(i).uWidth, expectedRecords.at(i).uWidth);
+		QCOMPARE(records.at(i).uHeight, expectedRecords.at(i).uHeight);
+		QCOMPARE(records.at(i).bitmap, expectedRecords.at(i).bitmap);
+		QCOMPARE(records.at(i).uIndex, quint64(i));
+		QCOMPARE(records.at(i).uOffset, uOffset);
+		uOffset += QxGntReader::RecordHeaderSize + expectedRecords.at(i).bitmap.size();
+	}
+}
+
+void tst_QxSampleStore::roundTrip_data()
+{
+	QTest::addColumn<QxGntRecord>("record");
+
+	QxGntRecord white = qxMakeRecord(0x3021, 9, 4, 0);
+	white.bitmap.fill(char(255));
+	QxGntRecord ink = qxMakeRecord(0x3022, 9, 4, 0);
+	ink.bitmap.fill(char(0));
+	// runs longer than a token holds
+	QxGntRecord longRuns = qxMakeRecord(0xFFFF, 700, 2, 0);
+	longRuns.bitmap.fill(char(255), 700);
+	longRuns.bitmap.append(QByteArray(700, char(254)));
+
+	QTest::newRow("mixed") << qxMakeRecord(0xB0A1, 37, 23, 4);
+	QTest::newRow("white") << white;
+	QTest::newRow("ink") << ink;
+	QTest::newRow("long runs") << longRuns;
+	QTest::newRow("one pixel") << qxMakeRecord(0, 1, 1, 0);
+	QTest::newRow("no width") << qxMakeRecord(0xB0A1, 0, 5, 0);
+	QTest::newRow("no height") << qxMakeRecord(0xB0A1, 5, 0, 0);
+}
+
+void tst_QxSampleStore::roundTrip()
+{
+	QFETCH(QxGntRecord, record);
+
+	QByteArray samples;
+	QxSampleStore::appendRecord(samples, record);
+	QxSampleStore::appendRecord(samples, record);
+	for (int i = 0; i != 2; ++i)
+	{
+		qint64 iPosition = i * samples.size() / 2;
+		QxGntRecord storedRecord;
+		QVERIFY(QxSampleStore::readRecord(samples, iPosition, storedRecord));
+		QCOMPARE(iPosition, qint64((i + 1) * samples.size() / 2));
+		QCOMPARE(storedRecord.uTagCode, record.uTagCode);
+		QCOMPARE(storedRecord.uWidth, record.uWidth);
+		QCOMPARE(storedRecord.uHeight, record.uHeight);
+		QCOMPARE(storedRecord.bitmap, record.bitmap);
+	}
+}
+
+void tst_QxSampleStore::readTruncated()
+{
+	QByteArray samples;
+	QxSampleStore::appendRecord(samples, qxMakeRecord(0xB0A1, 37, 23, 4));
+
+	// no sample at the end, and no sample cut anywhere: the position stays where it was
+	qint64 iPosition = samples.size();
+	QxGntRecord record;
+	QVERIFY(!QxSampleStore::readRecord(samples, iPosition, record));
+	QCOMPARE(iPosition, qint64(samples.size()));
+	for (int iSize = 0; iSize != samples.size(); ++iSize)
+	{
+		iPosition = 0;
+		QVERIFY(!QxSampleStore::readRecord(samples.left(iSize), iPosition, record));
+		QCOMPARE(iPosition, qint64(0));
+	}
+}
+
+void tst_QxSampleStore::readCorruptHeader()
+{
+	QByteArray samples;
+	QxSampleStore::appendRecord(samples, qxMakeRecord(0xB0A1, 4, 3, 1));
+	qint64 iPosition = 0;
+	QxGntRecord record;
+
+	// a row announcing more pixels than its width
+	QByteArray runs = samples;
+	runs[6] = 3;
+	runs[7] = 3;
+	QVERIFY(!QxSampleStore::readRecord(runs, iPosition, record));
+
+	// a header announcing 65535 x 65535 pixels, more rows than the data could hold
+	QByteArray header = samples;
+	header[2] = header[3] = header[4] = header[5] = char(0xFF);
+	QVERIFY(!QxSampleStore::readRecord(header, iPosition, record));
+	QCOMPARE(iPosition, qint64(0));
+}
+
+void tst_QxSampleStore::storesFileRead()
+{
+	const QString strFileName = fileName("stored.gnt");
+	QVERIFY(qxWriteFile(strFileName, qxGntData(m_Records)));
+
+	QxSampleStore store;
+	QList<QxGntRecord> records;
+	QVERIFY(readAll(strFileName, &store, records));
+	compareRecords(records, m_Records);
+	QCOMPARE(store.fileCount(), 1);
+	QCOMPARE(store.sampleCount(), quint64(m_Records.size()));
+	QCOMPARE(store.rawSize(), qint64(qxGntData(m_Records).size()));
+	QVERIFY(store.memorySize() > 0);
+	QVERIFY(store.memorySize() < store.rawSize());
+	QCOMPARE(store.spilledSize(), qint64(0));
+
+	// read again, from the store
+	QList<QxSampleStore::Chunk> chunks;
+	quint64 uSampleCount = 0;
+	QVERIFY(store.find(strFileName, chunks, uSampleCount));
+	QCOMPARE(uSampleCount, quint64(m_Records.size()));
+	QVERIFY(readAll(strFileName, &store, records));
+	compareRecords(records, m_Records);
+
+	store.clear();
+	QCOMPARE(store.fileCount(), 0);
+	QCOMPARE(store.memorySize(), qint64(0));
+	QVERIFY(!store.find(strFileName, chunks, uSampleCount));
+}
+
+void tst_QxSampleStore::spillsBeyondBudget()
+{
+	const QString strFileName = fileName("spilled.gnt");
+	QVERIFY(qxWriteFile(strFileName, qxGntData(m_Records)));
+
+	QxSampleStore store(0);
+	QList<QxGntRecord> records;
+	QVERIFY(readAll(strFileName, &store, records));
+	QCOMPARE(store.fileCount(), 1);
+	QCOMPARE(store.memorySize(), qint64(0));
+	QVERIFY(store.spilledSize() > 0);
+	QVERIFY(readAll(strFileName, &store, records));
+	compareRecords(records, m_Records);
+}
+
+void tst_QxSampleStore::splitsIntoChunks()
+{
+	// samples without any white pixel, thus about as large stored as read: more than a chunk in all
+	QList<QxGntRecord> records;
+	for (int i = 0; i * 250 * 250 < QxSampleStore::ChunkSize * 3 / 2; ++i)
+	{
+		QxGntRecord record = qxMakeRecord(0xB0A1 + i % 3, 250, 250, i);
+		record.bitmap.fill(char(i % 255));
+		records << record;
+	}
+	const QString strFileName = fileName("chunks.gnt");
+	QVERIFY(qxWriteFile(strFileName, qxGntData(records)));
+
+	QxSampleStore store;
+	QList<QxGntRecord> readRecords;
+	QVERIFY(readAll(strFileName, &store, readRecords));
+	QList<QxSampleStore::Chunk> chunks;
+	quint64 uSampleCount = 0;
+	QVERIFY(store.find(strFileName, chunks, uSampleCount));
+	QCOMPARE(chunks.size(), 2);
+	QCOMPARE(uSampleCount, quint64(records.size()));
+	QVERIFY(readAll(strFileName, &store, readRecords));
+	compareRecords(readRecords, records);
+	QFile::remove(strFileName);
+}
+
+void tst_QxSampleStore::readsChangedFileAgain()
+{
+	const QString strFileName = fileName("changed.gnt");
+	QVERIFY(qxWriteFile(strFileName, qxGntData(m_Records)));
+	QxSampleStore store;
+	QList<QxGntRecord> records;
+	QVERIFY(readAll(strFileName, &store, records));
+
+	// another size
+	QList<QxGntRecord> changedRecords = m_Records.mid(1);
+	changedRecords[0].bitmap.fill(char(0));
+	QVERIFY(qxWriteFile(strFileName, qxGntData(changedRecords)));
+
+	QList<QxSampleStore::Chunk> chunks;
+	quint64 uSampleCount = 0;
+	QVERIFY(!store.find(strFileName, chunks, uSampleCount));
+	QVERIFY(readAll(strFileName, &store, records));
+	compareRecords(records, changedRecords);
+	QVERIFY(readAll(strFileName, &store, records));
+	compareRecords(records, changedRecords);
+	QCOMPARE(store.fileCount(), 1);
+}
+
+void tst_QxSampleStore::skipsFileWithError()
+{
+	const QString strFileName = fileName("truncated.gnt");
+	const QByteArray data = qxGntData(m_Records);
+	QVERIFY(qxWriteFile(strFileName, data.left(data.size() - 1)));
+
+	QxSampleStore store;
+	QList<QxGntRecord> records;
+	QVERIFY(!readAll(strFileName, &store, records));
+	QCOMPARE(records.size(), m_Records.size() - 1);
+	QCOMPARE(store.fileCount(), 0);
+	QCOMPARE(store.memorySize(), qint64(0));
+}
+
+QTEST_GUILESS_MAIN(tst_QxSampleStore)
+
+#include "tst_qxsamplestore.moc"
@@ -0,0 +1,52 @@
+include(../tests.pri)
+
+# The merger takes the output file names from QxDecoder, which brings the whole decoding along.
+QT += widgets
+QT += concurrent
+
+TARGET = tst_qxshardmerger
+
+SOURCES += tst_qxshardmerger.cpp \
+    $$SOURCE_PATH/QxAtlasWriter.cpp \
+    $$SOURCE_PATH/QxAugmenter.cpp \
+    $$SOURCE_PATH/QxDecodeOptionDlg.cpp \
+    $$SOURCE_PATH/QxDecodeSettings.cpp \
+    $$SOURCE_PATH/QxDecoder.cpp \
+    $$SOURCE_PATH/QxDecompressDevice.cpp \
+    $$SOURCE_PATH/QxDgrReader.cpp \
+    $$SOURCE_PATH/QxEncodedCache.cpp \
+    $$SOURCE_PATH/QxExternalShuffler.cpp \
+    $$SOURCE_PATH/QxGntReader.cpp \
+    $$SOURCE_PATH/QxNpyWriter.cpp \
+    $$SOURCE_PATH/QxPngWriter.cpp \
+    $$SOURCE_PATH/QxPotReader.cpp \
+    $$SOURCE_PATH/QxSampleProcessor.cpp \
+    $$SOURCE_PATH/QxSampleStore.cpp \
+    $$SOURCE_PATH/QxShardMerger.cpp \
+    $$SOURCE_PATH/QxStrokeRasterizer.cpp
+
+HEADERS += \
+    $$SOURCE_PATH/QxAtlasWriter.h \
+    $$SOURCE_PATH/QxAugmenter.h \
+    $$SOURCE_PATH/QxDecodeOptionDlg.h \
+    $$SOURCE_PATH/QxDecodeSettings.h \
+    $$SOURCE_PATH/QxDecoder.h \
+    $$SOURCE_PATH/QxDecompressDevice.h \
+    $$SOURCE_PATH/QxDgrReader.h \
+    $$SOURCE_PATH/QxEncodedCache.h \
+    $$SOURCE_PATH/QxExternalShuffler.h \
+    $$SOURCE_PATH/QxGntReader.h \
+    $$SOURCE_PATH/QxNpyWriter.h \
+    $$SOURCE_PATH/QxPngWriter.h \
+    $$SOURCE_PATH/QxPotReader.h \
+    $$SOURCE_PATH/QxSampleProcessor.h \
+    $$SOURCE_PATH/QxSampleStore.h \
+    $$SOURCE_PATH/QxShardMerger.h \
+    $$SOURCE_PATH/QxStrokeRasterizer.h
+
+
+unix:!macx: LIBS += -lopencv_core
+
+unix:!macx: LIBS += -lopencv_highgui
+
+unix:!macx: LIBS += -lopencv_imgproc
@@ -0,0 +1,255 @@
+#include <QDir>
+#include <QFile>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "QxDecoder.h"
+#include "QxNpyWriter.h"
+#include "QxShardMerger.h"
+#include "QxTestData.h"
+
+/*
+	Merging the outputs of two shards: the global labels follow the sorted tag codes, and every label file, atlas
+	manifest and packed label file found in the shards is rewritten with them.
+*/
+class tst_QxShardMerger : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void init();
+
+	void mergesMappingFiles();
+	void mergesLabelFiles();
+	void mergesManifests();
+	void mergesTensorLabels();
+	void rejectsUnknownLabel();
+	void rejectsOtherTensors_data();
+	void rejectsOtherTensors();
+	void rejectsShardAsDestination();
+	void rejectsMissingMapping();
+
+private:
+	// Write a code_label.txt file like QxDecoder: a header line, then "code label" lines.
+	static bool writeMappingFile(const QString& strPath, const QList<quint32>& codes);
+	static bool writeLabels(const QString& strFileName, const QVector<qint32>& labels);
+	// Labels of a .npy file of int32 labels, empty if it isn't one.
+	static QVector<qint32> readLabels(const QString& strFileName);
+	static QStringList readLines(const QString& strFileName);
+	bool merge();
+
+private:
+	QScopedPointer<QTemporaryDir> m_pTempDir;
+	QStringList m_ShardPaths;
+	QString m_strDestinationPath;
+	QxShardMerger m_Merger;
+};
+
+void tst_QxShardMerger::init()
+{
+	// shard 0 met 45217 then 12345, shard 1 met 12345 then 50000: the global labels are 12345, 45217, 50000
+	m_pTempDir.reset(new QTemporaryDir);
+	QVERIFY(m_pTempDir->isValid());
+	m_ShardPaths.clear();
+	for (int iShard = 0; iShard != 2; ++iShard)
+	{
+		m_ShardPaths << m_pTempDir->path() + QString("/shard%1").arg(iShard);
+		QVERIFY(QDir().mkpath(m_ShardPaths.last()));
+	}
+	m_strDestinationPath = m_pTempDir->path() + "/merged";
+	QVERIFY(QDir().mkpath(m_strDestinationPath));
+	QVERIFY(writeMappingFile(m_ShardPaths.at(0), QList<quint32>() << 45217 << 12345));
+	QVERIFY(writeMappingFile(m_ShardPaths.at(1), QList<quint32>() << 12345 << 50000));
+}
+
+bool tst_QxShardMerger::writeMappingFile(const QString& strPath, const QList<quint32>& codes)
+{
+	QByteArray data("Code      Label     \n");
+	for (int i = 0; i != codes.size(); ++i)
+	{
+		data.append(QByteArray::number(codes.at(i)).leftJustified(10)).append(QByteArray::number(i).leftJustified(10)).append('\n');
+	}
+	return qxWriteFile(strPath + "/" + QxDecoder::mappingFileName(), data);
+}
+
+bool tst_QxShardMerger::writeLabels(const QString& strFileName, const QVector<qint32>& labels)
+{
+	QxNpyWriter writer;
+	if (!writer.open(strFileName, QxNpyWriter::Int32, QList<int>()))
+	{
+		return false;
+	}
+	for (int i = 0; i != labels.size(); ++i)
+	{
+		if (!writer.append(&labels.at(i)))
+		{
+			return false;
+		}
+	}
+	return writer.close();
+}
+
+QVector<qint32> tst_QxShardMerger::readLabels(const QString& strFileName)
+{
+	QFile file(strFileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return QVector<qint32>();
+	}
+	const QByteArray data = file.readAll();
+	const int iDataStart = 10 + uchar(data.at(8)) + uchar(data.at(9)) * 256;
+	const QByteArray dict = data.mid(10, iDataStart - 10);
+	const int iCount = (data.size() - iDataStart) / 4;
+	if (!data.startsWith("\x93NUMPY") || !dict.contains("'descr': '<i4'") || !dict.contains("'shape': (" + QByteArray::number(iCount) + ",)"))
+	{
+		return QVector<qint32>();
+	}
+	QVector<qint32> labels(iCount);
+	memcpy(labels.data(), data.constData() + iDataStart, iCount * 4);
+	return labels;
+}
+
+QStringList tst_QxShardMerger::readLines(const QString& strFileName)
+{
+	QFile file(strFileName);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		return QStringList();
+	}
+	return QString::fromUtf8(file.readAll()).split('\n', QString::SkipEmptyParts);
+}
+
+bool tst_QxShardMerger::merge()
+{
+	return m_Merger.merge(m_ShardPaths, m_strDestinationPath);
+}
+
+void tst_QxShardMerger::mergesMappingFiles()
+{
+	QVERIFY2(merge(), qPrintable(m_Merger.errorString()));
+	QCOMPARE(m_Merger.classCount(), quint32(3));
+	QCOMPARE(m_Merger.sampleCount(), quint64(0));
+
+	const QStringList lines = readLines(m_strDestinationPath + "/" + QxDecoder::mappingFileName());
+	QCOMPARE(lines.size(), 4);
+	QCOMPARE(lines.at(1).simplified(), QString("12345 0"));
+	QCOMPARE(lines.at(2).simplified(), QString("45217 1"));
+	QCOMPARE(lines.at(3).simplified(), QString("50000 2"));
+}
+
+void tst_QxShardMerger::mergesLabelFiles()
+{
+	const QString strLabelFileName = QxDecoder::labelFileName(QxDecodeSettings::NoSplit, QxDecodeSettings::TrainSet);
+	QVERIFY(qxWriteFile(m_ShardPaths.at(0) + "/" + strLabelFileName, "images/a b.png 0\nimages/c.png 1\n"));
+	QVERIFY(qxWriteFile(m_ShardPaths.at(1) + "/" + strLabelFileName, "images/d.png\t1\r\n\nimages/e.png\t0\r\n"));
+	// split label files only in the second shard
+	const QString strTestFileName = QxDecoder::labelFileName(QxDecodeSettings::SplitBySample, QxDecodeSettings::TestSet);
+	QVERIFY(qxWriteFile(m_ShardPaths.at(1) + "/" + strTestFileName, "test/f.png 1\n"));
+
+	QVERIFY2(merge(), qPrintable(m_Merger.errorString()));
+	QCOMPARE(m_Merger.sampleCount(), quint64(5));
+	QCOMPARE(readLines(m_strDestinationPath + "/" + strLabelFileName),
+		QStringList() << "images/a b.png 1" << "images/c.png 0" << "images/d.png\t2" << "images/e.png\t0");
+	QCOMPARE(readLines(m_strDestinationPath + "/" + strTestFileName), QStringList() << "test/f.png 2");
+	QVERIFY(!QFile::exists(m_strDestinationPath + "/"
+		+ QxDecoder::labelFileName(QxDecodeSettings::SplitBySample, QxDecodeSettings::TrainSet)));
+}
+
+void tst_QxShardMerger::mergesManifests()
+{
+	const QString strManifestFileName = QxDecoder::manifestFileName(QxDecodeSettings::SplitBySample, QxDecodeSettings::ValidationSet);
+	QVERIFY(qxWriteFile(m_ShardPaths.at(0) + "/" + strManifestFileName, "index sheet row col label\n0 0 0 0 1\n1 0 0 1 0\n"));
+	QVERIFY(qxWriteFile(m_ShardPaths.at(1) + "/" + strManifestFileName, "index sheet row col label\n0 0 0 0 1\n"));
+
+	QVERIFY2(merge(), qPrintable(m_Merger.errorString()));
+	QCOMPARE(m_Merger.sampleCount(), quint64(3));
+	QCOMPARE(readLines(m_strDestinationPath + "/" + strManifestFileName),
+		QStringList() << "index shard sheet row col label" << "0 0 0 0 0 0" << "1 0 0 0 1 1" << "2 1 0 0 0 2");
+}
+
+void tst_QxShardMerger::mergesTensorLabels()
+{
+	const QString strLabelFileName = QxDecoder::tensorLabelFileName(QxDecodeSettings::NoSplit, QxDecodeSettings::TrainSet);
+	const QString strTrainFileName = QxDecoder::tensorLabelFileName(QxDecodeSettings::SplitBySample, QxDecodeSettings::TrainSet);
+	QCOMPARE(strLabelFileName, QString("labels.npy"));
+	QCOMPARE(strTrainFileName, QString("train_labels.npy"));
+	QVERIFY(writeLabels(m_ShardPaths.at(0) + "/" + strLabelFileName, QVector<qint32>() << 0 << 1 << 1 << 0));
+	QVERIFY(writeLabels(m_ShardPaths.at(1) + "/" + strLabelFileName, QVector<qint32>() << 1 << 0));
+	QVERIFY(writeLabels(m_ShardPaths.at(1) + "/" + strTrainFileName, QVector<qint32>() << 1));
+	// the images stay in the shards
+	QVERIFY(qxWriteFile(m_ShardPaths.at(0) + "/" + QxDecoder::tensorFileName(QxDecodeSettings::NoSplit, QxDecodeSettings::TrainSet), "images"));
+
+	QVERIFY2(merge(), qPrintable(m_Merger.errorString()));
+	QCOMPARE(m_Merger.sampleCount(), quint64(7));
+	QCOMPARE(readLabels(m_strDestinationPath + "/" + strLabelFileName), QVector<qint32>() << 1 << 0 << 0 << 1 << 2 << 0);
+	QCOMPARE(readLabels(m_strDestinationPath + "/" + strTrainFileName), QVector<qint32>() << 2);
+	QVERIFY(!QFile::exists(m_strDestinationPath + "/" + QxDecoder::tensorFileName(QxDecodeSettings::NoSplit, QxDecodeSettings::TrainSet)));
+}
+
+void tst_QxShardMerger::rejectsUnknownLabel()
+{
+	const QString strLabelFileName = QxDecoder::labelFileName(QxDecodeSettings::NoSplit, QxDecodeSettings::TrainSet);
+	QVERIFY(qxWriteFile(m_ShardPaths.at(1) + "/" + strLabelFileName, "images/d.png 2\n"));
+	QVERIFY(!merge());
+	QVERIFY(m_Merger.errorString().startsWith("Unknown label in "));
+
+	QVERIFY(QFile::remove(m_ShardPaths.at(1) + "/" + strLabelFileName));
+	const QString strTensorLabelFileName = QxDecoder::tensorLabelFileName(QxDecodeSettings::NoSplit, QxDecodeSettings::TrainSet);
+	QVERIFY(writeLabels(m_ShardPaths.at(0) + "/" + strTensorLabelFileName, QVector<qint32>() << 0 << -1));
+	QVERIFY(!merge());
+	QVERIFY(m_Merger.errorString().startsWith("Unknown label in "));
+	QVERIFY(m_Merger.errorString().endsWith(": -1"));
+}
+
+void tst_QxShardMerger::rejectsOtherTensors_data()
+{
+	QTest::addColumn<QByteArray>("data");
+
+	QxNpyWriter writer;
+	const QString strFileName = m_pTempDir->path() + "/images.npy";
+	QVERIFY(writer.open(strFileName, QxNpyWriter::UInt8, QList<int>() << 2 << 2));
+	QVERIFY(writer.append("abcd"));
+	QVERIFY(writer.close());
+	QFile file(strFileName);
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QTest::newRow("images") << file.readAll();
+
+	QVERIFY(writer.open(strFileName, QxNpyWriter::Float32, QList<int>()));
+	QVERIFY(writer.append("abcd"));
+	QVERIFY(writer.close());
+	file.close();
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QTest::newRow("float labels") << file.readAll();
+
+	QTest::newRow("not npy") << QByteArray("0 1 2\n");
+	QTest::newRow("truncated header") << QByteArray("\x93NUMPY\x01\x00\x76\x00{'descr': '<i4'", 25);
+}
+
+void tst_QxShardMerger::rejectsOtherTensors()
+{
+	QFETCH(QByteArray, data);
+	const QString strLabelFileName = QxDecoder::tensorLabelFileName(QxDecodeSettings::NoSplit, QxDecodeSettings::TrainSet);
+	QVERIFY(writeLabels(m_ShardPaths.at(0) + "/" + strLabelFileName, QVector<qint32>() << 0));
+	QVERIFY(qxWriteFile(m_ShardPaths.at(1) + "/" + strLabelFileName, data));
+	QVERIFY(!merge());
+	QVERIFY(m_Merger.errorString().startsWith("Not a .npy file"));
+}
+
+void tst_QxShardMerger::rejectsShardAsDestination()
+{
+	m_strDestinationPath = m_ShardPaths.at(1) + "/../shard1";
+	QVERIFY(!merge());
+	QVERIFY(m_Merger.errorString().startsWith("The merged files must go to a folder which is not one of the shards"));
+}
+
+void tst_QxShardMerger::rejectsMissingMapping()
+{
+	QVERIFY(QFile::remove(m_ShardPaths.at(0) + "/" + QxDecoder::mappingFileName()));
+	QVERIFY(!merge());
+	QVERIFY(m_Merger.errorString().startsWith("Can not open "));
+}
+
+QTEST_GUILESS_MAIN(tst_QxShardMerger)
+
+#include "tst_qxshardmerger.moc"
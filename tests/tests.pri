@@ -0,0 +1,24 @@
+# Settings shared by the test projects, which build the sources they test from the parent folder.
+
+QT += testlib
+QT -= gui
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCE_PATH = $$PWD/..
+
+INCLUDEPATH += $$SOURCE_PATH \
+    $$PWD \
+    /usr/local/include
+DEPENDPATH += $$SOURCE_PATH \
+    $$PWD
+
+HEADERS += \
+    $$PWD/QxTestData.h
+
+unix:!macx: LIBS += -lz
+
+unix:!macx: LIBS += -lzstd
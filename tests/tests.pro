@@ -0,0 +1,15 @@
+#-------------------------------------------------
+#
+# Unit tests (QtTest), one executable per subject.
+# Build and run them with: qmake tests.pro && make check
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    qxdecodesettings \
+    qxreaders \
+    qxsampleserver \
+    qxsamplestore \
+    qxshardmerger